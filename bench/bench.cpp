@@ -0,0 +1,667 @@
+// Copyright (C) 2022  The COLA Authors
+//
+// This file is a part of cola, a tool for complementation and determinization
+// of omega automata.
+//
+// cola is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// cola is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// kofola-bench: runs kofola with selected algorithms over corpora of
+// automata (HOA files, directories of them, or files with LTL formulae
+// translated by ltl2tgba) and collects the time, peak memory and size of
+// the output of every run.  Every run gets its own process, so a timeout or
+// a crash affects only one run.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+/// an algorithm to benchmark: kofola's arguments, '%H' is replaced by the
+/// input file
+struct algorithm
+{
+  std::string name;
+  std::vector<std::string> args;
+};
+
+/// algorithms that can be selected by --algos
+const std::vector<algorithm> ALGORITHMS = {
+  {"comp", {"--algo=comp", "%H"}},
+  {"comp-scc", {"--algo=comp", "--scc-compl", "%H"}},
+  {"comp-tgba", {"--algo=comp", "--tgba", "%H"}},
+  {"comp-lazy-product", {"--algo=comp", "--scc-compl", "--lazy-product", "%H"}},
+  {"cola", {"--algo=cola", "%H"}},
+  {"congr", {"--algo=congr", "--contain=%H", "%H"}},
+};
+
+/// an input automaton
+struct input
+{
+  std::string name;
+  std::string path;
+};
+
+/// the result of one run
+struct result
+{
+  std::string algo;
+  std::string input;
+  std::string status;   // ok, timeout, error, or budget (exit code 3)
+  double time_s = 0;
+  double memory_mib = 0;
+  long states = -1;     // -1 if there is no automaton on the output
+};
+
+void print_usage(std::ostream &os)
+{
+  os << "Usage: kofola-bench [OPTION...] INPUT...\n";
+}
+
+void print_help()
+{
+  print_usage(std::cout);
+  std::cout <<
+      R"(Runs kofola over the given inputs and measures every run.
+
+An INPUT is a HOA file, a directory (all its *.hoa files are used), or a file
+*.ltl with one LTL formula per line (each formula is translated into a Buchi
+automaton by ltl2tgba).
+
+Options:
+    --kofola=[PATH]       The kofola binary (default=./kofola)
+    --ltl2tgba=[PATH]     The ltl2tgba binary of Spot (default=ltl2tgba)
+    --algos=[LIST]        Comma-separated algorithms to run (default=comp,cola):
+)";
+  for (const algorithm &algo : ALGORITHMS)
+  {
+    std::cout << "                            " << std::left << std::setw(18) << algo.name;
+    for (const std::string &arg : algo.args)
+      std::cout << " " << arg;
+    std::cout << "\n";
+  }
+  std::cout <<
+      R"(    --args=[ARGS]         Additional arguments of kofola (separated by spaces)
+    --timeout=[INT]       Timeout of a run in seconds (default=60)
+    --csv=[FILE]          Write the results in CSV into FILE ('-' for stdout)
+    --json=[FILE]         Write the results in JSON into FILE ('-' for stdout)
+    --baseline=[FILE]     Compare the results with a CSV written by an earlier run
+    --tolerance=[INT]     Report runs slower than the baseline by more than INT %
+                          (default=10)
+
+Without --csv and --json, the results are written in CSV to stdout.  With
+--baseline, the exit status is 1 if a run got slower, changed the size of
+its output, or stopped finishing.
+)";
+}
+
+/// parses the value of an option --opt=INT
+unsigned parse_int(const std::string &arg)
+{
+  const std::string number = arg.substr(arg.find('=') + 1);
+  char *end = nullptr;
+  errno = 0;
+  unsigned long result = std::strtoul(number.c_str(), &end, 10);
+  if (number.empty() || *end != '\0' || errno != 0)
+  {
+    throw std::runtime_error("invalid number in " + arg);
+  }
+
+  return static_cast<unsigned>(result);
+}
+
+/// splits 'str' at 'sep' (empty items are dropped)
+std::vector<std::string> split(const std::string &str, char sep)
+{
+  std::vector<std::string> result;
+  std::istringstream iss(str);
+  std::string item;
+  while (std::getline(iss, item, sep))
+  {
+    if (!item.empty())
+      result.push_back(item);
+  }
+
+  return result;
+}
+
+bool ends_with(const std::string &str, const std::string &suffix)
+{
+  return str.size() >= suffix.size() &&
+    0 == str.compare(str.size() - suffix.size(), suffix.size(), suffix);
+}
+
+/// creates an empty temporary file and returns its name
+std::string make_temp_file()
+{
+  const char *tmpdir = std::getenv("TMPDIR");
+  std::string name = std::string((nullptr != tmpdir)? tmpdir : "/tmp") +
+    "/kofola-bench-XXXXXX";
+  int fd = mkstemp(&name[0]);
+  if (fd < 0)
+  {
+    throw std::runtime_error("cannot create a temporary file: " +
+      std::string(std::strerror(errno)));
+  }
+  close(fd);
+
+  return name;
+}
+
+/// outcome of a process
+struct run_info
+{
+  bool timed_out = false;
+  int exit_code = -1;   // -1 if killed by a signal
+  double time_s = 0;
+  double memory_mib = 0;
+};
+
+/// runs 'args' with stdout redirected to 'out_file' (and stderr discarded);
+/// the process is killed after 'timeout' seconds (0 = no timeout)
+run_info run_process(const std::vector<std::string> &args,
+                     const std::string &out_file, unsigned timeout)
+{
+  run_info info;
+  const auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    throw std::runtime_error("fork failed: " + std::string(std::strerror(errno)));
+  }
+  else if (0 == pid)
+  { // child
+    // own process group, so that its children are killed with it
+    setpgid(0, 0);
+    int out = open(out_file.c_str(), O_WRONLY | O_TRUNC);
+    int null = open("/dev/null", O_WRONLY);
+    if (out < 0 || null < 0)
+      _exit(127);
+    dup2(out, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+
+    std::vector<char *> argv;
+    for (const std::string &arg : args)
+      argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+
+  // the process is polled, the period grows up to 10 ms so that short runs
+  // are measured precisely
+  int status = 0;
+  struct rusage usage;
+  auto period = std::chrono::microseconds(100);
+  while (true)
+  {
+    pid_t res = wait4(pid, &status, WNOHANG, &usage);
+    if (res == pid)
+      break;
+    else if (res < 0 && errno != EINTR)
+      throw std::runtime_error("wait4 failed: " + std::string(std::strerror(errno)));
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (timeout > 0 && elapsed >= std::chrono::seconds(timeout))
+    {
+      kill(-pid, SIGKILL);
+      kill(pid, SIGKILL);
+      wait4(pid, &status, 0, &usage);
+      info.timed_out = true;
+      break;
+    }
+
+    std::this_thread::sleep_for(period);
+    period = std::min(2 * period, std::chrono::microseconds(10000));
+  }
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  info.time_s = elapsed.count();
+  info.memory_mib = usage.ru_maxrss / 1024.0;   // ru_maxrss is in KiB
+  if (WIFEXITED(status))
+    info.exit_code = WEXITSTATUS(status);
+
+  return info;
+}
+
+/// the number of states of the automata in a HOA file (-1 if there is none)
+long count_states(const std::string &path)
+{
+  std::ifstream in(path);
+  long result = -1;
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (0 == line.compare(0, 7, "States:"))
+      result = std::max(0L, result) + std::atol(line.c_str() + 7);
+  }
+
+  return result;
+}
+
+/// collects the inputs given by 'arg' (see print_help())
+void collect_inputs(const std::string &arg, const std::string &ltl2tgba,
+                    std::vector<input> &inputs, std::vector<std::string> &temp_files)
+{
+  struct stat st;
+  if (0 != stat(arg.c_str(), &st))
+  {
+    throw std::runtime_error("cannot open " + arg);
+  }
+
+  if (S_ISDIR(st.st_mode))
+  {
+    std::vector<std::string> names;
+    DIR *dir = opendir(arg.c_str());
+    if (nullptr == dir)
+      throw std::runtime_error("cannot open " + arg);
+    while (struct dirent *entry = readdir(dir))
+    {
+      if (ends_with(entry->d_name, ".hoa"))
+        names.push_back(entry->d_name);
+    }
+    closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    const std::string prefix = ends_with(arg, "/")? arg : arg + "/";
+    for (const std::string &name : names)
+      inputs.push_back({prefix + name, prefix + name});
+  }
+  else if (ends_with(arg, ".ltl"))
+  {
+    std::ifstream in(arg);
+    std::string formula;
+    for (unsigned line = 1; std::getline(in, formula); ++line)
+    {
+      if (formula.empty() || '#' == formula[0])
+        continue;
+
+      std::string hoa = make_temp_file();
+      temp_files.push_back(hoa);
+      run_info info = run_process({ltl2tgba, "-B", "-f", formula}, hoa, 0);
+      if (0 != info.exit_code)
+      {
+        throw std::runtime_error(ltl2tgba + " failed on " + arg + ":" +
+          std::to_string(line));
+      }
+      inputs.push_back({arg + ":" + std::to_string(line), hoa});
+    }
+  }
+  else
+  {
+    inputs.push_back({arg, arg});
+  }
+}
+
+/// quotes a field of CSV if needed
+std::string csv_field(const std::string &str)
+{
+  if (str.find_first_of(",\"\n") == std::string::npos)
+    return str;
+
+  std::string result = "\"";
+  for (char c : str)
+  {
+    if ('"' == c)
+      result += '"';
+    result += c;
+  }
+
+  return result + "\"";
+}
+
+/// splits a line of CSV written by csv_field()
+std::vector<std::string> parse_csv_line(const std::string &line)
+{
+  std::vector<std::string> result(1);
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); ++i)
+  {
+    if (quoted)
+    {
+      if ('"' == line[i] && i + 1 < line.size() && '"' == line[i + 1])
+      {
+        result.back() += '"';
+        ++i;
+      }
+      else if ('"' == line[i])
+        quoted = false;
+      else
+        result.back() += line[i];
+    }
+    else if ('"' == line[i])
+      quoted = true;
+    else if (',' == line[i])
+      result.emplace_back();
+    else
+      result.back() += line[i];
+  }
+
+  return result;
+}
+
+/// a JSON string literal
+std::string json_string(const std::string &str)
+{
+  std::string result = "\"";
+  for (char c : str)
+  {
+    if ('"' == c || '\\' == c)
+      result += std::string("\\") + c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+      result += buf;
+    }
+    else
+      result += c;
+  }
+
+  return result + "\"";
+}
+
+void write_csv(std::ostream &os, const std::vector<result> &results)
+{
+  os << "algo,input,status,time_s,memory_mib,states\n";
+  for (const result &res : results)
+  {
+    os << csv_field(res.algo) << "," << csv_field(res.input) << "," << res.status
+       << "," << std::fixed << std::setprecision(3) << res.time_s
+       << "," << std::setprecision(1) << res.memory_mib
+       << "," << res.states << "\n";
+  }
+}
+
+void write_json(std::ostream &os, const std::vector<result> &results)
+{
+  os << "[\n";
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const result &res = results[i];
+    os << "  {\"algo\":" << json_string(res.algo)
+       << ",\"input\":" << json_string(res.input)
+       << ",\"status\":" << json_string(res.status)
+       << ",\"time_s\":" << std::fixed << std::setprecision(3) << res.time_s
+       << ",\"memory_mib\":" << std::setprecision(1) << res.memory_mib
+       << ",\"states\":" << res.states << "}"
+       << ((i + 1 < results.size())? ",\n" : "\n");
+  }
+  os << "]\n";
+}
+
+/// writes the results by 'writer' into 'file' ('-' for stdout)
+template <class Writer>
+void write_results(const std::string &file, const std::vector<result> &results,
+                   Writer writer)
+{
+  if ("-" == file)
+  {
+    writer(std::cout, results);
+    return;
+  }
+
+  std::ofstream out(file);
+  writer(out, results);
+  if (!out)
+    throw std::runtime_error("cannot write " + file);
+}
+
+/// compares 'results' with the CSV in 'baseline_file' and prints the
+/// differences; returns the number of regressions
+unsigned compare_with_baseline(const std::vector<result> &results,
+                               const std::string &baseline_file, unsigned tolerance)
+{
+  std::ifstream in(baseline_file);
+  if (!in)
+    throw std::runtime_error("cannot open " + baseline_file);
+
+  std::map<std::pair<std::string, std::string>, result> baseline;
+  std::string line;
+  std::getline(in, line);   // header
+  while (std::getline(in, line))
+  {
+    std::vector<std::string> fields = parse_csv_line(line);
+    if (fields.size() != 6)
+      throw std::runtime_error("invalid line in " + baseline_file + ": " + line);
+    result res;
+    res.algo = fields[0];
+    res.input = fields[1];
+    res.status = fields[2];
+    res.time_s = std::atof(fields[3].c_str());
+    res.memory_mib = std::atof(fields[4].c_str());
+    res.states = std::atol(fields[5].c_str());
+    baseline[{res.algo, res.input}] = res;
+  }
+
+  // differences of times below the resolution of the measurement are noise
+  const double min_diff_s = 0.05;
+  unsigned regressions = 0;
+  double sum_time = 0, sum_base_time = 0;
+  for (const result &res : results)
+  {
+    auto it = baseline.find({res.algo, res.input});
+    if (baseline.end() == it)
+      continue;
+    const result &base = it->second;
+    const std::string what = res.algo + " on " + res.input + ": ";
+
+    if ("ok" == base.status && "ok" != res.status)
+    {
+      std::cerr << what << res.status << " (baseline ok in " << base.time_s << " s)\n";
+      ++regressions;
+      continue;
+    }
+    else if ("ok" != base.status && "ok" == res.status)
+    {
+      std::cerr << what << "ok (baseline " << base.status << ")\n";
+      continue;
+    }
+    else if ("ok" != res.status)
+      continue;
+
+    sum_time += res.time_s;
+    sum_base_time += base.time_s;
+    if (res.states != base.states)
+    {
+      std::cerr << what << res.states << " states (baseline " << base.states << ")\n";
+      ++regressions;
+    }
+    if (res.time_s > base.time_s * (1 + tolerance / 100.0) &&
+        res.time_s - base.time_s > min_diff_s)
+    {
+      std::cerr << what << std::fixed << std::setprecision(3) << res.time_s
+                << " s (baseline " << base.time_s << " s)\n";
+      ++regressions;
+    }
+  }
+
+  std::cerr << "total time of runs finished in both: " << std::fixed
+            << std::setprecision(3) << sum_time << " s (baseline " << sum_base_time
+            << " s), " << regressions << " regressions\n";
+
+  return regressions;
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[])
+{
+  std::string kofola = "./kofola";
+  std::string ltl2tgba = "ltl2tgba";
+  std::vector<std::string> algo_names = {"comp", "cola"};
+  std::vector<std::string> extra_args;
+  unsigned timeout = 60;
+  unsigned tolerance = 10;
+  std::string csv_file;
+  std::string json_file;
+  std::string baseline_file;
+  std::vector<std::string> input_args;
+
+  try
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if (arg.find("--kofola=") == 0)
+        kofola = arg.substr(arg.find('=') + 1);
+      else if (arg.find("--ltl2tgba=") == 0)
+        ltl2tgba = arg.substr(arg.find('=') + 1);
+      else if (arg.find("--algos=") == 0)
+        algo_names = split(arg.substr(arg.find('=') + 1), ',');
+      else if (arg.find("--args=") == 0)
+        extra_args = split(arg.substr(arg.find('=') + 1), ' ');
+      else if (arg.find("--timeout=") == 0)
+        timeout = parse_int(arg);
+      else if (arg.find("--tolerance=") == 0)
+        tolerance = parse_int(arg);
+      else if (arg.find("--csv=") == 0)
+        csv_file = arg.substr(arg.find('=') + 1);
+      else if (arg.find("--json=") == 0)
+        json_file = arg.substr(arg.find('=') + 1);
+      else if (arg.find("--baseline=") == 0)
+        baseline_file = arg.substr(arg.find('=') + 1);
+      else if ((arg == "--help") || (arg == "-h"))
+      {
+        print_help();
+        return 0;
+      }
+      else if (arg[0] == '-' && arg.size() > 1)
+      {
+        std::cerr << "kofola-bench: Unsupported option " << arg << '\n';
+        return 2;
+      }
+      else
+        input_args.push_back(arg);
+    }
+  }
+  catch (const std::runtime_error &e)
+  {
+    std::cerr << "kofola-bench: " << e.what() << "\n";
+    return 2;
+  }
+
+  if (input_args.empty())
+  {
+    std::cerr << "kofola-bench: No input to run on.\n";
+    print_usage(std::cerr);
+    return 1;
+  }
+
+  std::vector<const algorithm *> algos;
+  for (const std::string &name : algo_names)
+  {
+    auto it = std::find_if(ALGORITHMS.begin(), ALGORITHMS.end(),
+                           [&name](const algorithm &algo) { return algo.name == name; });
+    if (ALGORITHMS.end() == it)
+    {
+      std::cerr << "kofola-bench: Unknown algorithm " << name << "\n";
+      return 1;
+    }
+    algos.push_back(&*it);
+  }
+
+  std::vector<std::string> temp_files;
+  int retval = 0;
+  try
+  {
+    std::vector<input> inputs;
+    for (const std::string &arg : input_args)
+      collect_inputs(arg, ltl2tgba, inputs, temp_files);
+
+    const std::string out_file = make_temp_file();
+    temp_files.push_back(out_file);
+    std::vector<result> results;
+    for (const algorithm *algo : algos)
+    {
+      for (const input &in : inputs)
+      {
+        std::vector<std::string> args = {kofola};
+        for (std::string arg : algo->args)
+        {
+          size_t pos = arg.find("%H");
+          if (pos != std::string::npos)
+            arg.replace(pos, 2, in.path);
+          args.push_back(arg);
+        }
+        args.insert(args.end() - 1, extra_args.begin(), extra_args.end());
+
+        run_info info = run_process(args, out_file, timeout);
+        result res;
+        res.algo = algo->name;
+        res.input = in.name;
+        res.time_s = info.time_s;
+        res.memory_mib = info.memory_mib;
+        if (info.timed_out)
+          res.status = "timeout";
+        else if (3 == info.exit_code)
+          res.status = "budget";
+        else if (0 != info.exit_code)
+          res.status = "error";
+        else
+        {
+          res.status = "ok";
+          res.states = count_states(out_file);
+        }
+
+        std::cerr << res.algo << " " << res.input << ": " << res.status << " "
+                  << std::fixed << std::setprecision(3) << res.time_s << " s\n";
+        results.push_back(res);
+      }
+    }
+
+    if (csv_file.empty() && json_file.empty())
+      csv_file = "-";
+    if (!csv_file.empty())
+      write_results(csv_file, results, write_csv);
+    if (!json_file.empty())
+      write_results(json_file, results, write_json);
+
+    if (!baseline_file.empty() &&
+        compare_with_baseline(results, baseline_file, tolerance) > 0)
+      retval = 1;
+  }
+  catch (const std::runtime_error &e)
+  {
+    std::cerr << "kofola-bench: " << e.what() << "\n";
+    retval = 2;
+  }
+
+  for (const std::string &file : temp_files)
+    std::remove(file.c_str());
+
+  return retval;
+}
@@ -0,0 +1,510 @@
+// Copyright (C) 2022  The COLA Authors
+//
+// This file is a part of cola, a tool for complementation and determinization
+// of omega automata.
+//
+// cola is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// cola is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// kofola-microbench: times the kernels of the complementation in isolation
+// and reports the time and the number of heap allocations per operation.
+// For every input automaton, cmpl_info is built as complement_tnba does (one
+// partition per accepting SCC), and the successor functions of the
+// algorithm of every partition are called on a fixed sample of partial
+// macrostates reached from the initial ones.  The saturation, the
+// simulation, and get_tight_rankings() are measured separately.
+
+#include "kofola.hpp"
+#include "abstract_complement_alg.hpp"
+#include "complement_alg_mh.hpp"
+#include "complement_alg_ncsb.hpp"
+#include "complement_alg_rank.hpp"
+#include "complement_alg_safra.hpp"
+#include "rankings.hpp"
+#include "reachability.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <spot/parseaut/public.hh>
+#include <spot/twaalgos/degen.hh>
+#include <spot/twaalgos/postproc.hh>
+#include <spot/twaalgos/simulation.hh>
+
+// Allocations are counted by replacing the global operator new (the array
+// and sized versions forward to these).
+namespace
+{
+std::atomic<size_t> num_allocs{0};
+}
+
+void *operator new(std::size_t size)
+{
+  num_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc((size > 0)? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace
+{
+
+using kofola::abstract_complement_alg;
+using mstate = abstract_complement_alg::mstate;
+using mstate_set = abstract_complement_alg::mstate_set;
+using mstate_col_set = abstract_complement_alg::mstate_col_set;
+
+/// minimum time of measuring a benchmark
+std::chrono::milliseconds MIN_TIME(200);
+/// maximum number of sampled partial macrostates of a partition
+size_t MAX_SAMPLES = 1000;
+
+/// keeps results alive, so that the measured calls are not optimized out
+volatile size_t sink;
+
+/// result of a benchmark
+struct measurement
+{
+  size_t ops = 0;
+  double ns_per_op = 0;
+  double allocs_per_op = 0;
+};
+
+/// runs 'round' (which returns the number of operations it did) until
+/// MIN_TIME passes, after one round for warming up
+template <class Round>
+measurement measure(Round round)
+{
+  round();
+
+  measurement result;
+  const size_t allocs_before = num_allocs.load();
+  const auto start = std::chrono::steady_clock::now();
+  auto elapsed = std::chrono::steady_clock::duration::zero();
+  do
+  {
+    result.ops += round();
+    elapsed = std::chrono::steady_clock::now() - start;
+  } while (elapsed < MIN_TIME || 0 == result.ops);
+
+  const size_t allocs = num_allocs.load() - allocs_before;
+  const std::chrono::duration<double, std::nano> ns = elapsed;
+  result.ns_per_op = ns.count() / result.ops;
+  result.allocs_per_op = static_cast<double>(allocs) / result.ops;
+  return result;
+}
+
+/// prints a line of the report
+void report(const std::string &input, const std::string &bench, const measurement &m)
+{
+  std::cout << input << "\t" << bench << "\t" << std::fixed << std::setprecision(1)
+            << m.ns_per_op << "\t" << std::setprecision(2) << m.allocs_per_op
+            << "\t" << m.ops << std::endl;
+}
+
+/// a set of reached states with the successors over its enabled letters
+struct reached
+{
+  kofola::state_bitset states;
+  std::vector<std::pair<unsigned, kofola::state_bitset>> succs;
+};
+
+/// a partial macrostate in the sample with the set of states reached with it
+struct sample
+{
+  mstate ms;
+  size_t reached_index;
+};
+
+/// everything cmpl_info refers to
+struct compl_setup
+{
+  spot::twa_graph_ptr aut;
+  std::unique_ptr<spot::scc_info> si;
+  size_t num_partitions = 0;
+  kofola::PartitionToTypeMap part_to_type_map;
+  kofola::StateToPartitionMap st_to_part_map;
+  kofola::PartitionToSCCMap part_to_scc_map;
+  std::unique_ptr<kofola::scc_reachability> reach;
+  std::unique_ptr<kofola::minterm_alphabet> alphabet;
+  std::unique_ptr<kofola::post_image_table> post_table;
+  kofola::Simulation dir_sim;
+  std::vector<bool> is_accepting;
+  compl_decomp_options options;
+  std::unique_ptr<kofola::cmpl_info> info;
+};
+
+/// computes the direct simulation of 'aut' (reduces 'aut') as the
+/// complementation does
+kofola::Simulation compute_simulation(spot::twa_graph_ptr &aut)
+{
+  std::vector<bdd> implications;
+  aut = spot::simulation(aut, &implications, -1);
+  kofola::Simulation dir_sim(implications.size());
+  for (unsigned i = 0; i < implications.size(); ++i)
+  {
+    for (unsigned j = 0; j < implications.size(); ++j)
+    {
+      if (bdd_implies(implications[i], implications[j]))
+        dir_sim.add(i, j);
+    }
+  }
+
+  return dir_sim;
+}
+
+/// prepares the complementation of 'aut' (one partition per accepting SCC,
+/// i.e., complement_tnba without --merge-iwa and --merge-det)
+void prepare(compl_setup &setup, spot::twa_graph_ptr aut)
+{
+  setup.dir_sim = compute_simulation(aut);
+  spot::scc_info si(aut, spot::scc_info_options::ALL);
+  setup.aut = cola::saturation(aut, si);
+  setup.si = std::make_unique<spot::scc_info>(setup.aut, spot::scc_info_options::ALL);
+
+  const std::string scc_types = cola::get_scc_types(*setup.si);
+  kofola::SCCToPartitionMap scc_to_part_map;
+  for (unsigned scc = 0; scc < setup.si->scc_count(); ++scc)
+  {
+    if (!cola::is_accepting_scc(scc_types, scc))
+      continue;
+
+    const size_t part = setup.num_partitions++;
+    scc_to_part_map[scc] = part;
+    setup.part_to_scc_map[part] = {scc};
+    if (cola::is_accepting_weakscc(scc_types, scc))
+      setup.part_to_type_map[part] = kofola::PartitionType::INHERENTLY_WEAK;
+    else if (cola::is_accepting_detscc(scc_types, scc))
+      setup.part_to_type_map[part] = kofola::PartitionType::DETERMINISTIC;
+    else
+      setup.part_to_type_map[part] = kofola::PartitionType::NONDETERMINISTIC;
+  }
+  for (unsigned state = 0; state < setup.aut->num_states(); ++state)
+  {
+    auto it = scc_to_part_map.find(setup.si->scc_of(state));
+    if (scc_to_part_map.end() != it)
+      setup.st_to_part_map[state] = it->second;
+  }
+
+  setup.is_accepting.resize(setup.aut->num_states());
+  for (unsigned state = 0; state < setup.aut->num_states(); ++state)
+  {
+    bool accepting = true;
+    bool has_transitions = false;
+    for (const auto &out : setup.aut->out(state))
+    {
+      has_transitions = true;
+      accepting = accepting && out.acc;
+    }
+    setup.is_accepting[state] = accepting && has_transitions;
+  }
+
+  setup.reach = std::make_unique<kofola::scc_reachability>(*setup.si);
+  setup.alphabet = std::make_unique<kofola::minterm_alphabet>(setup.aut);
+  setup.post_table = std::make_unique<kofola::post_image_table>(
+    setup.aut, *setup.alphabet, *setup.si);
+  setup.info = std::make_unique<kofola::cmpl_info>(setup.aut, setup.num_partitions,
+    setup.part_to_type_map, setup.st_to_part_map, setup.part_to_scc_map,
+    *setup.reach, *setup.si, *setup.alphabet, *setup.post_table, setup.dir_sim,
+    setup.is_accepting, setup.options);
+}
+
+/// a key identifying a partial macrostate with its reached states
+std::string sample_key(const reached &reach, const mstate &ms)
+{
+  std::string key;
+  for (auto word : reach.states.words())
+    key += std::to_string(word) + ",";
+  return key + std::to_string(ms);
+}
+
+/// collects samples of the track and active partial macrostates of 'alg'
+/// (at most MAX_SAMPLES of each) by a breadth-first search from its
+/// initial ones; 'reached_sets' are shared by all partitions
+void collect_samples(const compl_setup &setup, const abstract_complement_alg &alg,
+                     std::vector<reached> &reached_sets,
+                     std::vector<sample> &track, std::vector<sample> &active)
+{
+  auto get_reached = [&](const kofola::state_bitset &states) -> size_t
+  {
+    for (size_t i = 0; i < reached_sets.size(); ++i)
+    {
+      if (reached_sets[i].states == states)
+        return i;
+    }
+
+    reached reach;
+    reach.states = states;
+    for (unsigned letter : setup.alphabet->get_enabled_letters(states))
+    {
+      reach.succs.emplace_back(letter,
+        kofola::get_all_successors(*setup.post_table, states, letter));
+    }
+    reached_sets.push_back(std::move(reach));
+    return reached_sets.size() - 1;
+  };
+
+  std::set<std::string> seen;
+  std::deque<sample> queue;
+  auto add = [&](const mstate &ms, size_t reached_index)
+  {
+    std::vector<sample> &samples = kofola::is_active(ms)? active : track;
+    if (samples.size() >= MAX_SAMPLES ||
+        !seen.insert(sample_key(reached_sets[reached_index], ms)).second)
+      return;
+    samples.push_back({ms, reached_index});
+    queue.push_back({ms, reached_index});
+  };
+
+  kofola::state_bitset init;
+  init.insert(setup.aut->get_init_state_number());
+  const size_t init_index = get_reached(init);
+  for (const auto &ms : alg.get_init())
+  {
+    for (const auto &lifted : alg.lift_track_to_active(ms))
+      add(lifted, init_index);
+    if (alg.use_round_robin())
+      add(ms, init_index);
+  }
+
+  while (!queue.empty())
+  {
+    const sample src = queue.front();
+    queue.pop_front();
+    if (!kofola::is_active(src.ms))
+    { // the partition may become active
+      for (const auto &lifted : alg.lift_track_to_active(src.ms))
+        add(lifted, src.reached_index);
+    }
+
+    // the vector of reached sets may grow
+    const auto succs = reached_sets[src.reached_index].succs;
+    for (const auto &letter_succ : succs)
+    {
+      mstate_col_set mcs = kofola::is_active(src.ms)?
+        alg.get_succ_active(letter_succ.second, src.ms, letter_succ.first) :
+        alg.get_succ_track(letter_succ.second, src.ms, letter_succ.first);
+      if (mcs.empty())
+        continue;
+      const size_t succ_index = get_reached(letter_succ.second);
+      for (const auto &ms_col : mcs)
+        add(ms_col.first, succ_index);
+    }
+  }
+}
+
+/// measures the successor functions of the algorithm of every partition
+void bench_algorithms(const std::string &input, const compl_setup &setup)
+{
+  std::vector<reached> reached_sets;
+  for (size_t part = 0; part < setup.num_partitions; ++part)
+  {
+    // all algorithms applicable to the partition
+    std::vector<std::pair<std::string, std::unique_ptr<abstract_complement_alg>>> algs;
+    switch (setup.part_to_type_map.at(part))
+    {
+      case kofola::PartitionType::INHERENTLY_WEAK:
+        algs.emplace_back("mh", std::make_unique<kofola::complement_mh>(*setup.info, part));
+        break;
+      case kofola::PartitionType::DETERMINISTIC:
+      case kofola::PartitionType::STRONGLY_DETERMINISTIC:
+        algs.emplace_back("ncsb", std::make_unique<kofola::complement_ncsb>(*setup.info, part));
+        break;
+      default:
+        algs.emplace_back("safra", std::make_unique<kofola::complement_safra>(*setup.info, part));
+        algs.emplace_back("rank", std::make_unique<kofola::complement_rank>(*setup.info, part));
+    }
+
+    for (const auto &name_alg : algs)
+    {
+      const abstract_complement_alg &alg = *name_alg.second;
+      const std::string prefix = "part" + std::to_string(part) + "/" + name_alg.first + "/";
+      std::vector<sample> track, active;
+      collect_samples(setup, alg, reached_sets, track, active);
+
+      report(input, prefix + "get_init", measure([&]()
+        {
+          sink = alg.get_init().size();
+          return size_t(1);
+        }));
+
+      auto bench_succ = [&](const std::vector<sample> &samples, bool is_active)
+      {
+        return measure([&]()
+          {
+            size_t ops = 0;
+            for (const sample &smp : samples)
+            {
+              for (const auto &letter_succ : reached_sets[smp.reached_index].succs)
+              {
+                sink = (is_active?
+                  alg.get_succ_active(letter_succ.second, smp.ms, letter_succ.first) :
+                  alg.get_succ_track(letter_succ.second, smp.ms, letter_succ.first)).size();
+                ++ops;
+              }
+            }
+            return ops;
+          });
+      };
+
+      if (!track.empty())
+      {
+        report(input, prefix + "get_succ_track", bench_succ(track, false));
+        report(input, prefix + "lift_track_to_active", measure([&]()
+          {
+            for (const sample &smp : track)
+              sink = alg.lift_track_to_active(smp.ms).size();
+            return track.size();
+          }));
+      }
+      if (!active.empty())
+        report(input, prefix + "get_succ_active", bench_succ(active, true));
+    }
+  }
+}
+
+/// measures the preprocessing of 'aut' for the complementation
+void bench_preprocessing(const std::string &input, const spot::twa_graph_ptr &aut)
+{
+  report(input, "simulation", measure([&]()
+    {
+      spot::twa_graph_ptr copy = aut;
+      sink = compute_simulation(copy).num_states();
+      return size_t(1);
+    }));
+
+  spot::scc_info si(aut, spot::scc_info_options::ALL);
+  report(input, "saturation", measure([&]()
+    {
+      sink = cola::saturation(aut, si)->num_edges();
+      return size_t(1);
+    }));
+}
+
+/// measures get_tight_rankings() on 'n' states with ranks up to 2n
+void bench_rankings(unsigned n)
+{
+  std::vector<std::tuple<int, int, bool>> mp;
+  for (unsigned i = 0; i < n; ++i)
+    mp.emplace_back(i, 2 * n, 0 == i % 2);
+
+  report("-", "get_tight_rankings/" + std::to_string(n), measure([&]()
+    {
+      sink = kofola::get_tight_rankings(mp).size();
+      return size_t(1);
+    }));
+}
+
+void print_help()
+{
+  std::cout << "Usage: kofola-microbench [OPTION...] FILENAME...\n" <<
+      R"(Times the kernels of the complementation on the automata in the given HOA
+files, and prints for every kernel a line 'input, benchmark, ns/op,
+allocations/op, operations'.
+
+Options:
+    --min-time=[INT]      Measure every benchmark for at least INT ms (default=200)
+    --max-samples=[INT]   Number of sampled partial macrostates of every kind and
+                          partition (default=1000)
+)";
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[])
+{
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg.find("--min-time=") == 0)
+      MIN_TIME = std::chrono::milliseconds(std::atoi(arg.c_str() + arg.find('=') + 1));
+    else if (arg.find("--max-samples=") == 0)
+      MAX_SAMPLES = std::atoi(arg.c_str() + arg.find('=') + 1);
+    else if ((arg == "--help") || (arg == "-h"))
+    {
+      print_help();
+      return 0;
+    }
+    else if (arg[0] == '-' && arg.size() > 1)
+    {
+      std::cerr << "kofola-microbench: Unsupported option " << arg << '\n';
+      return 2;
+    }
+    else
+      files.push_back(arg);
+  }
+
+  std::cout << "input\tbenchmark\tns/op\tallocs/op\tops\n";
+  for (unsigned n = 2; n <= 4; ++n)
+    bench_rankings(n);
+
+  auto dict = spot::make_bdd_dict();
+  try
+  {
+    for (const std::string &file : files)
+    {
+      spot::automaton_stream_parser parser(file);
+      for (unsigned num = 0; ; ++num)
+      {
+        spot::parsed_aut_ptr parsed_aut = parser.parse(dict);
+        if (parsed_aut->format_errors(std::cerr))
+          return 1;
+        spot::twa_graph_ptr aut = parsed_aut->aut;
+        if (!aut)
+          break;
+
+        // the input of the complementation is a Buchi automaton
+        if (aut->acc().is_generalized_buchi())
+          aut = spot::degeneralize_tba(aut);
+        spot::postprocessor p;
+        p.set_type(spot::postprocessor::Buchi);
+        p.set_level(spot::postprocessor::High);
+        aut = p.run(aut);
+
+        const std::string input = (0 == num)? file : file + "#" + std::to_string(num);
+        bench_preprocessing(input, aut);
+        compl_setup setup;
+        prepare(setup, aut);
+        bench_algorithms(input, setup);
+      }
+    }
+  }
+  catch (const std::runtime_error &e)
+  {
+    std::cerr << "kofola-microbench: " << e.what() << "\n";
+    return 1;
+  }
+
+  return 0;
+}
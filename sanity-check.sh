@@ -1,6 +1,6 @@
 #!/bin/bash
 
-HELP_MSG="usage: ${0} [--all] <input-ba> [optional parameters]"
+HELP_MSG="usage: ${0} [--all|--threads|--stream|--checkpoint|--cache|--budget|--contain] <input-ba> [optional parameters]"
 TIMEOUT=60
 AUTCROSS_CMD="timeout ${TIMEOUT} autcross -T ${TIMEOUT}"
 
@@ -10,20 +10,33 @@ if [ \( "$#" -lt 1 \) ] ; then
 	exit 1
 fi
 
-ALL=0
-if [ \( "$1" == "--all" \) ] ; then
-	if [ \( "$#" -lt 2 \) ] ; then
-		echo ${HELP_MSG}
-		exit 1
-	fi
+# --all       compares with other complementation tools
+# --threads   compares the parallel exploration with the sequential one
+# --stream    compares the streamed output with the one built in memory
+# --checkpoint  compares the output resumed from a checkpoint (written when
+#             a small budget is exceeded) with the complement
+# --cache     compares the output taken from the cache with the computed one
+# --budget    checks that exceeding a budget gives the exit code 3 (also for
+#             parts complemented in child processes with --scc-compl)
+# --contain   compares --contain (also with --scc-compl in child processes)
+#             with autfilt --included-in, the first automaton of the input
+#             being checked to be included in every automaton of the input
+MODE=""
+case "$1" in
+	--all|--threads|--stream|--checkpoint|--cache|--budget|--contain)
+		if [ \( "$#" -lt 2 \) ] ; then
+			echo ${HELP_MSG}
+			exit 1
+		fi
 
-	ALL=1
-	shift
-fi
+		MODE=$1
+		shift
+		;;
+esac
 
 INPUT=$1
 shift
-if [ \( ${ALL} == 1 \) ] ; then
+if [ \( "${MODE}" == "--all" \) ] ; then
 	cat ${INPUT} | ${AUTCROSS_CMD} \
 	'./bin/autfilt --complement %H >%O' \
 	"./bin/ranker $* %H >%O" \
@@ -36,6 +49,84 @@ if [ \( ${ALL} == 1 \) ] ; then
 	'./bin/goal-autcross-wrap.sh %H %O -m fribourg' \
 	'./bin/ranker-tight %H >%O' \
 	'./bin/ranker-composition %H >%O'
+elif [ \( "${MODE}" == "--threads" \) ] ; then
+	echo  running "./kofola --algo=comp --threads=[1|2] $* %H >%O"
+	cat ${INPUT} | ${AUTCROSS_CMD} \
+		'autfilt --complement %H >%O' \
+		"./kofola --algo=comp --threads=1 $* %H >%O" \
+		"./kofola --algo=comp --threads=2 $* %H >%O"
+	retval=$?
+
+	# the states are numbered canonically, so the outputs must be the same
+	OUT1=$(timeout ${TIMEOUT} ./kofola --algo=comp --threads=1 $* ${INPUT})
+	OUT2=$(timeout ${TIMEOUT} ./kofola --algo=comp --threads=2 $* ${INPUT})
+	if [ \( "${OUT1}" != "${OUT2}" \) ] ; then
+		echo "outputs of --threads=1 and --threads=2 differ"
+		exit 1
+	fi
+	exit ${retval}
+elif [ \( "${MODE}" == "--stream" \) ] ; then
+	echo  running "./kofola --algo=comp [--raw|--stream] $* %H >%O"
+	cat ${INPUT} | ${AUTCROSS_CMD} \
+		'autfilt --complement %H >%O' \
+		"./kofola --algo=comp --raw $* %H >%O" \
+		"./kofola --algo=comp --stream $* %H >%O"
+elif [ \( "${MODE}" == "--checkpoint" \) ] ; then
+	# checkpoints are written only for a single automaton, which autcross
+	# passes in %H; if the budget suffices, the first run gives the result
+	echo  running "./kofola --algo=comp --checkpoint=%H.ckpt --max-states=10 $* %H; ./kofola --algo=comp --resume=%H.ckpt $* %H >%O"
+	cat ${INPUT} | ${AUTCROSS_CMD} \
+		'autfilt --complement %H >%O' \
+		"./kofola --algo=comp $* %H >%O" \
+		"./kofola --algo=comp --checkpoint=%H.ckpt --max-states=10 $* %H >%O 2>/dev/null; if [ -f %H.ckpt ] ; then ./kofola --algo=comp --resume=%H.ckpt $* %H >%O; fi; rm -f %H.ckpt"
+elif [ \( "${MODE}" == "--cache" \) ] ; then
+	CACHE_DIR=$(mktemp -d)
+	# the first run fills the cache, the second one takes the results from it
+	OUT1=$(timeout ${TIMEOUT} ./kofola --algo=comp --cache=${CACHE_DIR} $* ${INPUT})
+	retval=$?
+	OUT2=$(timeout ${TIMEOUT} ./kofola --algo=comp --cache=${CACHE_DIR} $* ${INPUT})
+	rm -rf ${CACHE_DIR}
+	if [ \( ${retval} != 0 \) ] ; then
+		echo "computing the results to be cached failed"
+		exit 1
+	fi
+	if [ \( "${OUT1}" != "${OUT2}" \) ] ; then
+		echo "outputs computed and taken from the cache differ"
+		exit 1
+	fi
+elif [ \( "${MODE}" == "--budget" \) ] ; then
+	# the input needs an automaton whose complement has more than one state
+	for OPTS in "" "--scc-compl --threads=2" ; do
+		echo  running "./kofola --algo=comp --max-states=1 ${OPTS} $* ${INPUT}"
+		timeout ${TIMEOUT} ./kofola --algo=comp --max-states=1 ${OPTS} $* ${INPUT} >/dev/null
+		retval=$?
+		if [ \( ${retval} != 3 \) ] ; then
+			echo "exceeding the budget with '${OPTS}' gave the exit code ${retval} instead of 3"
+			exit 1
+		fi
+	done
+elif [ \( "${MODE}" == "--contain" \) ] ; then
+	TMP_DIR=$(mktemp -d)
+	autfilt -N 1 ${INPUT} >${TMP_DIR}/first.hoa
+	NUM=$(autfilt -c ${INPUT})
+	retval=0
+	for ((i = 1; i <= NUM; i++)) ; do
+		autfilt -N ${i} ${INPUT} >${TMP_DIR}/aut.hoa
+		if [ \( "$(autfilt -c --included-in=${TMP_DIR}/aut.hoa ${TMP_DIR}/first.hoa)" == "1" \) ] ; then
+			EXPECTED="Contained"
+		else
+			EXPECTED="Not contained"
+		fi
+		for OPTS in "" "--scc-compl --threads=2" ; do
+			RESULT=$(timeout ${TIMEOUT} ./kofola --algo=comp --contain=${TMP_DIR}/first.hoa ${OPTS} $* ${TMP_DIR}/aut.hoa)
+			if [ \( "${RESULT#${EXPECTED}}" == "${RESULT}" \) ] ; then
+				echo "automaton ${i} with '${OPTS}': expected '${EXPECTED}', got '${RESULT}'"
+				retval=1
+			fi
+		done
+	done
+	rm -rf ${TMP_DIR}
+	exit ${retval}
 else
 	echo  running "./kofola --algo=comp $* %H >%O"
 	cat ${INPUT} | ${AUTCROSS_CMD} \
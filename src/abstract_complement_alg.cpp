@@ -1,34 +1,14 @@
-
 #include "src/abstract_complement_alg.hpp"
 
 using namespace kofola;
 
-/// equality operator
-bool kofola::operator==(
-  const abstract_complement_alg::mstate& lhs,
-  const abstract_complement_alg::mstate& rhs)
-{
-  return lhs.eq(rhs);
-}
-
-/// disequality operator
-bool kofola::operator!=(
-  const abstract_complement_alg::mstate& lhs,
-  const abstract_complement_alg::mstate& rhs)
-{
-  return !(lhs == rhs);
-}
-
-/// ordering relation
-bool kofola::operator<(
-  const abstract_complement_alg::mstate& lhs,
-  const abstract_complement_alg::mstate& rhs)
+std::ostream& kofola::operator<<(std::ostream& os, const abstract_complement_alg::mstate& ms)
 {
-  return lhs.lt(rhs);
+  std::visit([&os](const auto& x) { os << x.to_string(); }, ms);
+  return os;
 }
 
-std::ostream& kofola::operator<<(std::ostream& os, const abstract_complement_alg::mstate& ms)
+void kofola::save_mstate(checkpoint_writer& out, const abstract_complement_alg::mstate& ms)
 {
-  os << ms.to_string();
-  return os;
+  std::visit([&out](const auto& x) { x.save(out); }, ms);
 }
@@ -3,9 +3,14 @@
 #pragma once
 
 #include <string>
+#include <variant>
 #include <vector>
 
 #include "kofola.hpp"
+#include "checkpoint.hpp"
+#include "hash_index.hpp"
+#include "part_macrostate.hpp"
+#include "reachability.hpp"
 
 // SPOT
 #include <spot/misc/bddlt.hh>
@@ -30,18 +35,22 @@ struct cmpl_info
   /// types of partitions
   const PartitionToTypeMap& part_to_type_map_;
 
-  /// vector of states reachable from given state
-  const ReachableVector& reachable_vector_;
 
   /// map of partition to the SCCs it contains
   const PartitionToSCCMap& part_to_scc_map_;
 
-  /// maps SCCs to sets of their predecessors
-  const SCCToSCCSetMap& scc_to_pred_sccs_map_;
+  /// reachability between states and SCCs
+  const scc_reachability& reach_;
 
   /// information about SCCs
   const spot::scc_info& scc_info_;
 
+  /// the alphabet of the automaton split into letters
+  const minterm_alphabet& alphabet_;
+
+  /// successors of states over letters
+  const post_image_table& post_table_;
+
   /// direct simulation
   const Simulation& dir_sim_;
 
@@ -57,10 +66,11 @@ struct cmpl_info
     size_t                            num_partitions,
     const PartitionToTypeMap&         part_to_type_map,
     const StateToPartitionMap&        st_to_part_map,
-    const ReachableVector&            reachable_vector,
     const PartitionToSCCMap&          part_to_scc_map,
-    const SCCToSCCSetMap&             scc_to_pred_sccs_map,
+    const scc_reachability&           reach,
     const spot::scc_info&             scc_info,
+    const minterm_alphabet&           alphabet,
+    const post_image_table&           post_table,
     const Simulation&                 dir_sim,
     const std::vector<bool>&          state_accepting,
     const compl_decomp_options&       options
@@ -69,10 +79,11 @@ struct cmpl_info
     num_partitions_(num_partitions),
     part_to_type_map_(part_to_type_map),
     st_to_part_map_(st_to_part_map),
-    reachable_vector_(reachable_vector),
     part_to_scc_map_(part_to_scc_map),
-    scc_to_pred_sccs_map_(scc_to_pred_sccs_map),
+    reach_(reach),
     scc_info_(scc_info),
+    alphabet_(alphabet),
+    post_table_(post_table),
     dir_sim_(dir_sim),
     state_accepting_(state_accepting),
     options_(options)
@@ -85,32 +96,23 @@ class abstract_complement_alg
 { // {{{
 public: // TYPES
 
-  /// partial macrostate for the given component
-  class mstate
-  { // {{{
-  public: // METHODS
-
-    /// is the macrostate active?
-    virtual bool is_active() const = 0;
-
-    /// returns string representation of the partial macrostate
-    virtual std::string to_string() const = 0;
-
-    /// equality test
-    virtual bool eq(const mstate& rhs) const = 0;
-
-    /// less-than relation
-    virtual bool lt(const mstate& rhs) const = 0;
-
-    /// virtual destructor (to allow deletion via pointer)
-    virtual ~mstate() { }
-  }; // mstate }}}
+  /// partial macrostate for the given component; the kinds of partial
+  /// macrostates are closed and kept by value, so comparing and hashing them
+  /// needs neither RTTI nor reference counting
+  using mstate = std::variant<mstate_mh, mstate_ncsb, mstate_safra, mstate_rank>;
 
   /// set of partial macrostates together with sets of colours on the edge
-  using mstate_set = std::vector<std::shared_ptr<mstate>>;
-  using mstate_col = std::pair<std::shared_ptr<mstate>, std::set<unsigned>>;
+  using mstate_set = std::vector<mstate>;
+  using mstate_col = std::pair<mstate, std::set<unsigned>>;
   using mstate_col_set = std::vector<mstate_col>;
 
+  /// hash functor for partial macrostates (consistent with operator==)
+  struct mstate_hash
+  {
+    size_t operator()(const mstate& ms) const
+    { return std::visit([](const auto& x) { return x.hash(); }, ms); }
+  };
+
 protected: // DATA MEMBERS
 
   /// information for complementation
@@ -119,31 +121,46 @@ protected: // DATA MEMBERS
   /// index of the partition
   unsigned part_index_;
 
+  /// states of the partition
+  state_bitset part_states_;
+
 public: // METHODS
 
   /// constructor
   abstract_complement_alg(const cmpl_info& info, unsigned part_index) :
     info_(info),
     part_index_(part_index)
-  { }
+  { // {{{
+    for (const auto& st_part_pair : info.st_to_part_map_) {
+      if (st_part_pair.second == static_cast<int>(part_index)) {
+        this->part_states_.insert(st_part_pair.first);
+      }
+    }
+  } // abstract_complement_alg() }}}
 
   /// returns initial partial macrostate
   virtual mstate_set get_init() const = 0;
 
   /// tracking successors
   virtual mstate_col_set get_succ_track(
-    const std::set<unsigned>&  glob_reached,      // all states reached over symbol
-    const mstate*              src,               // partial macrostate
-    const bdd&                 symbol) const = 0; // symbol
+    const state_bitset&        glob_reached,      // all states reached over symbol
+    const mstate&              src,               // partial macrostate
+    unsigned                   symbol) const = 0; // letter of info_.alphabet_
 
   /// lifts tracking state to active state
-  virtual mstate_set lift_track_to_active(const mstate* src) const = 0;
+  virtual mstate_set lift_track_to_active(const mstate& src) const = 0;
 
   /// active successors
   virtual mstate_col_set get_succ_active(
-    const std::set<unsigned>&  glob_reached,      // all states reached over symbol
-    const mstate*              src,               // partial macrostate
-    const bdd&                 symbol) const = 0; // symbol
+    const state_bitset&        glob_reached,      // all states reached over symbol
+    const mstate&              src,               // partial macrostate
+    unsigned                   symbol) const = 0; // letter of info_.alphabet_
+
+  /// restricts the set of all reached states to the states the successors
+  /// of partial macrostates depend on (used as a part of the key for caching
+  /// the successors)
+  virtual state_bitset restrict_reached(const state_bitset& glob_reached) const
+  { return glob_reached & this->part_states_; }
 
   /// determines whether the algorithm should be use in round-robin scheme;
   /// in particular:
@@ -158,6 +175,21 @@ public: // METHODS
   /// returns the minimum colour used - HACK to allow colour reshuffle for Safra-based algorithm
   virtual unsigned get_min_colour() const = 0;
 
+  /// reads a partial macrostate written by save_mstate()
+  virtual mstate load_mstate(checkpoint_reader& in) const = 0;
+
+  /// writes the state of the algorithm collected during the construction
+  /// (e.g., the range of colours) into a checkpoint
+  virtual void save_state(checkpoint_writer& /*out*/) const { }
+
+  /// restores the state written by save_state()
+  virtual void load_state(checkpoint_reader& /*in*/) { }
+
+  /// fixes the acceptance condition (and the range of colours) before the
+  /// construction starts; needed when the complement is explored on the fly
+  /// and get_acc_cond() cannot wait for the construction to finish
+  virtual void fix_acc_cond() { }
+
   /// virtual destructor (to allow deletion via pointer)
   virtual ~abstract_complement_alg() { }
 }; // abstract_complement_alg }}}
@@ -165,19 +197,12 @@ public: // METHODS
 /// output stream conversion
 std::ostream& operator<<(std::ostream& os, const abstract_complement_alg::mstate& ms);
 
-/// equality operator
-bool operator==(
-  const abstract_complement_alg::mstate& lhs,
-  const abstract_complement_alg::mstate& rhs);
-
-/// disequality operator
-bool operator!=(
-  const abstract_complement_alg::mstate& lhs,
-  const abstract_complement_alg::mstate& rhs);
+/// is the partial macrostate active?
+inline bool is_active(const abstract_complement_alg::mstate& ms)
+{ return std::visit([](const auto& x) { return x.is_active(); }, ms); }
 
-/// ordering relation
-bool operator<(
-  const abstract_complement_alg::mstate& lhs,
-  const abstract_complement_alg::mstate& rhs);
+/// writes the partial macrostate into a checkpoint (read back by
+/// abstract_complement_alg::load_mstate())
+void save_mstate(checkpoint_writer& out, const abstract_complement_alg::mstate& ms);
 
 } // namespace kofola }}}
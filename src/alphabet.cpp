@@ -0,0 +1,83 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "alphabet.hpp"
+
+#include <map>
+
+#include <spot/misc/bddlt.hh>
+
+using namespace kofola;
+
+
+minterm_alphabet::minterm_alphabet(const spot::const_twa_graph_ptr& aut)
+{ // {{{
+  // every distinct condition refines the partition
+  std::map<bdd, std::vector<word_t>, spot::bdd_less_than> cond_masks;
+  for (const auto& e : aut->edges()) {
+    cond_masks.insert({e.cond, {}});
+  }
+
+  this->minterms_ = {bddtrue};
+  for (const auto& cond_mask_pair : cond_masks) {
+    const bdd& cond = cond_mask_pair.first;
+    std::vector<bdd> refined;
+    for (const bdd& m : this->minterms_) {
+      bdd pos = m & cond;
+      bdd neg = m - cond;
+      if (bddfalse != pos) { refined.push_back(pos); }
+      if (bddfalse != neg) { refined.push_back(neg); }
+    }
+    this->minterms_ = std::move(refined);
+  }
+
+  // compute the bitmasks of conditions (every letter is either included in a
+  // condition or disjoint with it)
+  this->num_words_ = (this->minterms_.size() + WORD_BITS - 1) / WORD_BITS;
+  for (auto& cond_mask_pair : cond_masks) {
+    std::vector<word_t>& mask = cond_mask_pair.second;
+    mask.assign(this->num_words_, 0);
+    for (unsigned letter = 0; letter < this->minterms_.size(); ++letter) {
+      if (bdd_implies(this->minterms_[letter], cond_mask_pair.first)) {
+        mask[letter / WORD_BITS] |= word_t(1) << (letter % WORD_BITS);
+      }
+    }
+  }
+
+  // bitmasks of edges and states
+  this->edge_letters_.assign(aut->edge_vector().size() * this->num_words_, 0);
+  this->state_letters_.assign(aut->num_states() * this->num_words_, 0);
+  for (unsigned s = 0; s < aut->num_states(); ++s) {
+    word_t* state_mask = &this->state_letters_[s * this->num_words_];
+    for (const auto& t : aut->out(s)) {
+      const std::vector<word_t>& mask = cond_masks.at(t.cond);
+      word_t* edge_mask = &this->edge_letters_[aut->edge_number(t) * this->num_words_];
+      for (size_t i = 0; i < this->num_words_; ++i) {
+        edge_mask[i] = mask[i];
+        state_mask[i] |= mask[i];
+      }
+    }
+  }
+} // minterm_alphabet() }}}
+
+
+bdd minterm_alphabet::letters_to_bdd(const std::vector<unsigned>& letters) const
+{ // {{{
+  bdd result = bddfalse;
+  for (unsigned letter : letters) {
+    result |= this->get_minterm(letter);
+  }
+
+  return result;
+} // letters_to_bdd() }}}
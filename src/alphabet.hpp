@@ -0,0 +1,111 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// the alphabet of an automaton split into minterms
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <spot/twa/twagraph.hh>
+
+namespace kofola { // {{{
+
+/// The alphabet of an automaton split into minterms, i.e., the coarsest
+/// partition of all valuations of atomic propositions such that the
+/// condition of every edge is a union of some of its classes.  The classes
+/// (called letters) are numbered from 0.  For every edge and every state,
+/// the set of letters it is enabled for is kept as a bitmask, so checking
+/// whether an edge can be taken over a letter does not touch BuDDy (and can
+/// be done concurrently).
+class minterm_alphabet
+{ // {{{
+public: // TYPES
+
+  using word_t = uint64_t;
+
+private: // CONSTANTS
+
+  static const size_t WORD_BITS = 64;
+
+private: // DATA MEMBERS
+
+  /// the letters
+  std::vector<bdd> minterms_;
+  /// number of words of a bitmask
+  size_t num_words_ = 0;
+  /// bitmasks of letters of edges (indexed by edge numbers)
+  std::vector<word_t> edge_letters_;
+  /// bitmasks of letters of outgoing edges of states
+  std::vector<word_t> state_letters_;
+
+  /// tests a bit in a bitmask
+  bool test(const std::vector<word_t>& masks, size_t index, unsigned letter) const
+  { // {{{
+    assert(letter < this->minterms_.size());
+    const word_t w = masks[index * this->num_words_ + letter / WORD_BITS];
+    return (w >> (letter % WORD_BITS)) & 1;
+  } // test() }}}
+
+public: // METHODS
+
+  /// splits the alphabet of 'aut'
+  explicit minterm_alphabet(const spot::const_twa_graph_ptr& aut);
+
+  /// number of letters
+  size_t size() const { return this->minterms_.size(); }
+
+  /// returns the BDD of a letter
+  const bdd& get_minterm(unsigned letter) const
+  { // {{{
+    assert(letter < this->minterms_.size());
+    return this->minterms_[letter];
+  } // get_minterm() }}}
+
+  /// checks whether the edge with the given number is enabled for a letter
+  bool edge_has_letter(unsigned edge, unsigned letter) const
+  { return this->test(this->edge_letters_, edge, letter); }
+
+  /// checks whether some outgoing edge of a state is enabled for a letter
+  bool state_has_letter(unsigned state, unsigned letter) const
+  { return this->test(this->state_letters_, state, letter); }
+
+  /// returns (in ascending order) the letters for which some outgoing edge
+  /// of some of the given states is enabled
+  template <class T>
+  std::vector<unsigned> get_enabled_letters(const T& states) const
+  { // {{{
+    std::vector<word_t> mask(this->num_words_, 0);
+    for (unsigned s : states) {
+      const word_t* state_mask = &this->state_letters_[s * this->num_words_];
+      for (size_t i = 0; i < this->num_words_; ++i) { mask[i] |= state_mask[i]; }
+    }
+
+    std::vector<unsigned> result;
+    for (size_t i = 0; i < this->num_words_; ++i) {
+      for (word_t w = mask[i]; w != 0; w &= w - 1) {
+        result.push_back(i * WORD_BITS + __builtin_ctzll(w));
+      }
+    }
+
+    return result;
+  } // get_enabled_letters() }}}
+
+  /// returns the union of the given letters as a BDD
+  bdd letters_to_bdd(const std::vector<unsigned>& letters) const;
+}; // minterm_alphabet }}}
+
+} // namespace kofola }}}
@@ -0,0 +1,109 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "analysis.hpp"
+#include "kofola.hpp"
+
+using namespace kofola;
+
+
+void aut_analysis::check_size()
+{ // {{{
+  if (this->aut_->num_states() != this->num_states_ ||
+      this->aut_->num_edges() != this->num_edges_) {
+    this->invalidate();
+  }
+} // check_size() }}}
+
+
+spot::scc_info& aut_analysis::get_scc_info()
+{ // {{{
+  this->check_size();
+  if (!this->si_) {
+    this->si_ = std::make_unique<spot::scc_info>(this->aut_, spot::scc_info_options::ALL);
+  }
+
+  return *this->si_;
+} // get_scc_info() }}}
+
+
+const std::string& aut_analysis::get_scc_types()
+{ // {{{
+  this->check_size();
+  if (!this->scc_types_) {
+    this->scc_types_ = cola::get_scc_types(this->get_scc_info());
+  }
+
+  return *this->scc_types_;
+} // get_scc_types() }}}
+
+
+const scc_reachability& aut_analysis::get_reachability()
+{ // {{{
+  this->check_size();
+  if (!this->reach_) {
+    this->reach_ = std::make_unique<scc_reachability>(this->get_scc_info());
+  }
+
+  return *this->reach_;
+} // get_reachability() }}}
+
+
+bool aut_analysis::is_weak()
+{ // {{{
+  this->check_size();
+  if (!this->weak_) {
+    this->weak_ = cola::is_weak_automaton(this->get_scc_info(),
+      this->get_scc_types());
+  }
+
+  return *this->weak_;
+} // is_weak() }}}
+
+
+bool aut_analysis::is_semi_deterministic()
+{ // {{{
+  this->check_size();
+  if (!this->semi_det_) {
+    this->semi_det_ = cola::is_limit_deterministic_automaton(this->get_scc_info(),
+      this->get_scc_types());
+  }
+
+  return *this->semi_det_;
+} // is_semi_deterministic() }}}
+
+
+bool aut_analysis::is_elevator()
+{ // {{{
+  this->check_size();
+  if (!this->elevator_) {
+    this->elevator_ = cola::is_elevator_automaton(this->get_scc_info(),
+      this->get_scc_types());
+  }
+
+  return *this->elevator_;
+} // is_elevator() }}}
+
+
+void aut_analysis::invalidate()
+{ // {{{
+  this->num_states_ = this->aut_->num_states();
+  this->num_edges_ = this->aut_->num_edges();
+  this->si_.reset();
+  this->scc_types_.reset();
+  this->reach_.reset();
+  this->weak_.reset();
+  this->semi_det_.reset();
+  this->elevator_.reset();
+} // invalidate() }}}
@@ -0,0 +1,87 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// cached analyses of an automaton
+
+#pragma once
+
+#include "reachability.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <spot/twa/twagraph.hh>
+#include <spot/twaalgos/sccinfo.hh>
+
+namespace kofola { // {{{
+
+/// Analyses of an automaton (SCCs, their types, reachability, and the
+/// properties derived from them) computed on the first request and shared
+/// by all their users.  The results are dropped when the number of states
+/// or edges of the automaton changes; other modifications in place (e.g.,
+/// of colours) need to be followed by invalidate().
+class aut_analysis
+{ // {{{
+private: // DATA MEMBERS
+
+  spot::const_twa_graph_ptr aut_;
+  /// the size of the automaton when the results were computed
+  unsigned num_states_ = 0;
+  unsigned num_edges_ = 0;
+
+  std::unique_ptr<spot::scc_info> si_;
+  std::optional<std::string> scc_types_;
+  std::unique_ptr<scc_reachability> reach_;
+  std::optional<bool> weak_;
+  std::optional<bool> semi_det_;
+  std::optional<bool> elevator_;
+
+  /// drops the results if the automaton changed its size
+  void check_size();
+
+public: // METHODS
+
+  /// constructor
+  explicit aut_analysis(const spot::const_twa_graph_ptr& aut) :
+    aut_(aut)
+  { }
+
+  /// the analysed automaton
+  const spot::const_twa_graph_ptr& get_aut() const { return this->aut_; }
+
+  /// information about SCCs (with all options of Spot)
+  spot::scc_info& get_scc_info();
+
+  /// types of SCCs (see cola::get_scc_types())
+  const std::string& get_scc_types();
+
+  /// reachability between SCCs
+  const scc_reachability& get_reachability();
+
+  /// checks whether all SCCs are inherently weak
+  bool is_weak();
+
+  /// checks whether the automaton is deterministic after reaching an
+  /// accepting SCC
+  bool is_semi_deterministic();
+
+  /// checks whether every SCC is inherently weak or deterministic inside
+  bool is_elevator();
+
+  /// drops all results (to be called after the automaton is modified)
+  void invalidate();
+}; // aut_analysis }}}
+
+} // namespace kofola }}}
@@ -0,0 +1,272 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "checkpoint.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+
+#include <spot/misc/minato.hh>
+
+using namespace kofola;
+
+namespace { // {{{
+
+const std::string MAGIC = "KOFOLA-CHECKPOINT";
+const uint64_t VERSION = 2;
+
+/// maps BDD variables of the atomic propositions of 'aut' to their indices
+std::map<int, unsigned> get_var_to_ap(const spot::const_twa_graph_ptr& aut)
+{ // {{{
+  std::map<int, unsigned> result;
+  const auto& aps = aut->ap();
+  for (unsigned i = 0; i < aps.size(); ++i) {
+    result[aut->get_dict()->varnum(aps[i])] = i;
+  }
+
+  return result;
+} // get_var_to_ap() }}}
+
+/// calls func(literals) for every cube of an irredundant sum of products of
+/// 'cond'; a literal is (2 * index of the atomic proposition), plus one if
+/// it is negative
+template <class F>
+void for_each_cube(
+  const bdd&                      cond,
+  const std::map<int, unsigned>&  var_to_ap,
+  F                               func)
+{ // {{{
+  spot::minato_isop isop(cond);
+  bdd cube;
+  while ((cube = isop.next()) != bddfalse) {
+    std::vector<uint64_t> literals;
+    while (cube != bddtrue) {
+      const uint64_t ap = var_to_ap.at(bdd_var(cube));
+      bdd high = bdd_high(cube);
+      if (bddfalse == high) { // negative literal
+        literals.push_back(2 * ap + 1);
+        cube = bdd_low(cube);
+      } else {
+        literals.push_back(2 * ap);
+        cube = high;
+      }
+    }
+    func(literals);
+  }
+} // for_each_cube() }}}
+
+/// computes a fingerprint of an automaton (FNV-1a of its structure), which
+/// does not depend on the numbering of BDD variables
+uint64_t fingerprint(
+  const spot::const_twa_graph_ptr&  aut,
+  const std::map<int, unsigned>&    var_to_ap)
+{ // {{{
+  uint64_t result = 14695981039346656037ULL;
+  auto add = [&result](uint64_t val) {
+      for (unsigned i = 0; i < 8; ++i) {
+        result ^= (val >> (8 * i)) & 0xff;
+        result *= 1099511628211ULL;
+      }
+    };
+
+  add(aut->num_states());
+  add(aut->get_init_state_number());
+  add(aut->num_edges());
+  for (const auto& ap : aut->ap()) {
+    for (char c : ap.ap_name()) { add(static_cast<unsigned char>(c)); }
+    add(0);
+  }
+  for (const auto& e : aut->edges()) {
+    add(e.src);
+    add(e.dst);
+    for (unsigned col : e.acc.sets()) { add(col + 1); }
+    add(0);
+    for_each_cube(e.cond, var_to_ap, [&](const std::vector<uint64_t>& literals) {
+        add(literals.size());
+        for (uint64_t lit : literals) { add(lit); }
+      });
+    add(0);
+  }
+
+  return result;
+} // fingerprint() }}}
+
+} // anonymous namespace }}}
+
+
+checkpoint_writer::checkpoint_writer(
+  const std::string&                path,
+  const std::string&                kind,
+  const std::string&                options,
+  const spot::const_twa_graph_ptr&  aut) :
+  path_(path),
+  tmp_path_(path + ".tmp"),
+  out_(tmp_path_, std::ios::binary | std::ios::trunc),
+  var_to_ap_(get_var_to_ap(aut))
+{ // {{{
+  if (!this->out_) {
+    throw std::runtime_error("cannot write checkpoint " + this->tmp_path_);
+  }
+
+  this->out_.write(MAGIC.data(), MAGIC.size());
+  this->write_uint(VERSION);
+  this->write_uint(kind.size());
+  this->out_.write(kind.data(), kind.size());
+  this->write_uint(options.size());
+  this->out_.write(options.data(), options.size());
+  this->write_uint(fingerprint(aut, this->var_to_ap_));
+} // checkpoint_writer() }}}
+
+
+void checkpoint_writer::write_uint(uint64_t val)
+{ // {{{
+  // LEB128: 7 bits per byte, the highest bit says whether more bytes follow
+  while (val >= 0x80) {
+    this->out_.put(static_cast<char>((val & 0x7f) | 0x80));
+    val >>= 7;
+  }
+  this->out_.put(static_cast<char>(val));
+} // write_uint() }}}
+
+
+void checkpoint_writer::write_int(int64_t val)
+{ // {{{
+  // zigzag encoding, so that small negative numbers are short
+  this->write_uint((static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63));
+} // write_int() }}}
+
+
+void checkpoint_writer::write_bitset(const state_bitset& states)
+{ // {{{
+  this->write_uint_range(states.words());
+} // write_bitset() }}}
+
+
+void checkpoint_writer::write_bdd(const bdd& cond)
+{ // {{{
+  std::vector<std::vector<uint64_t>> cubes;
+  for_each_cube(cond, this->var_to_ap_, [&cubes](const std::vector<uint64_t>& literals) {
+      cubes.push_back(literals);
+    });
+
+  this->write_uint(cubes.size());
+  for (const auto& cube : cubes) { this->write_uint_range(cube); }
+} // write_bdd() }}}
+
+
+void checkpoint_writer::commit()
+{ // {{{
+  this->out_.close();
+  if (!this->out_) {
+    throw std::runtime_error("cannot write checkpoint " + this->tmp_path_);
+  }
+
+  if (0 != std::rename(this->tmp_path_.c_str(), this->path_.c_str())) {
+    throw std::runtime_error("cannot move checkpoint " + this->tmp_path_ +
+      " to " + this->path_);
+  }
+} // commit() }}}
+
+
+checkpoint_reader::checkpoint_reader(
+  const std::string&                path,
+  const std::string&                kind,
+  const std::string&                options,
+  const spot::const_twa_graph_ptr&  aut) :
+  path_(path),
+  in_(path, std::ios::binary)
+{ // {{{
+  if (!this->in_) {
+    throw std::runtime_error("cannot read checkpoint " + this->path_);
+  }
+
+  std::string magic(MAGIC.size(), '\0');
+  this->in_.read(&magic[0], magic.size());
+  if (!this->in_ || magic != MAGIC) { this->fail("not a checkpoint"); }
+  if (this->read_uint() != VERSION) { this->fail("unsupported version"); }
+
+  std::string file_kind(this->read_uint(), '\0');
+  this->in_.read(&file_kind[0], file_kind.size());
+  if (!this->in_ || file_kind != kind) {
+    this->fail("not a checkpoint of " + kind);
+  }
+
+  // the size is compared first, so that a corrupt one is not allocated
+  if (this->read_uint() != options.size()) { this->fail("written with other options"); }
+  std::string file_options(options.size(), '\0');
+  this->in_.read(&file_options[0], file_options.size());
+  if (!this->in_ || file_options != options) {
+    this->fail("written with other options");
+  }
+
+  std::map<int, unsigned> var_to_ap = get_var_to_ap(aut);
+  if (this->read_uint() != fingerprint(aut, var_to_ap)) {
+    this->fail("written for another automaton");
+  }
+
+  this->ap_vars_.resize(aut->ap().size());
+  for (const auto& var_ap_pair : var_to_ap) {
+    this->ap_vars_[var_ap_pair.second] = var_ap_pair.first;
+  }
+} // checkpoint_reader() }}}
+
+
+uint64_t checkpoint_reader::read_uint()
+{ // {{{
+  uint64_t result = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    const int c = this->in_.get();
+    if (std::char_traits<char>::eof() == c) { this->fail("truncated"); }
+    result |= static_cast<uint64_t>(c & 0x7f) << shift;
+    if (0 == (c & 0x80)) { return result; }
+  }
+
+  this->fail("malformed number");
+} // read_uint() }}}
+
+
+int64_t checkpoint_reader::read_int()
+{ // {{{
+  const uint64_t val = this->read_uint();
+  return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1);
+} // read_int() }}}
+
+
+state_bitset checkpoint_reader::read_bitset()
+{ // {{{
+  return state_bitset::from_words(this->read_uint_vector<state_bitset::word_t>());
+} // read_bitset() }}}
+
+
+bdd checkpoint_reader::read_bdd()
+{ // {{{
+  bdd result = bddfalse;
+  for (uint64_t num_cubes = this->read_uint(); num_cubes > 0; --num_cubes) {
+    bdd cube = bddtrue;
+    for (uint64_t literal : this->read_uint_vector<uint64_t>()) {
+      const uint64_t ap = literal / 2;
+      if (ap >= this->ap_vars_.size()) { this->fail("unknown atomic proposition"); }
+      cube &= (literal % 2)? bdd_nithvar(this->ap_vars_[ap]) : bdd_ithvar(this->ap_vars_[ap]);
+    }
+    result |= cube;
+  }
+
+  return result;
+} // read_bdd() }}}
+
+
+void checkpoint_reader::fail(const std::string& reason) const
+{ // {{{
+  throw std::runtime_error("checkpoint " + this->path_ + " cannot be used: " + reason);
+} // fail() }}}
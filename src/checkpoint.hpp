@@ -0,0 +1,155 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// on-disk checkpoints of long constructions
+
+#pragma once
+
+#include "state_bitset.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <spot/twa/twagraph.hh>
+
+namespace kofola { // {{{
+
+/// Writes a checkpoint: a compact binary file with a header identifying the
+/// kind of the construction, the options it was run with (a canonical string
+/// of the options that affect the result), and the automaton it works on,
+/// followed by
+/// numbers (variable-length encoded), sets of states and BDDs.  BDDs are
+/// stored as disjunctions of cubes over the indices of the atomic
+/// propositions of the automaton, so they do not depend on the numbering of
+/// BDD variables.  The data are written into a temporary file that replaces
+/// the checkpoint only in commit(), so a run killed while writing leaves the
+/// previous checkpoint intact.
+class checkpoint_writer
+{ // {{{
+private: // DATA MEMBERS
+
+  std::string path_;
+  std::string tmp_path_;
+  std::ofstream out_;
+  /// maps BDD variables to indices of atomic propositions
+  std::map<int, unsigned> var_to_ap_;
+
+public: // METHODS
+
+  /// opens a checkpoint of the construction 'kind' with 'options' on 'aut'
+  checkpoint_writer(
+    const std::string&                path,
+    const std::string&                kind,
+    const std::string&                options,
+    const spot::const_twa_graph_ptr&  aut);
+
+  /// writes an unsigned number
+  void write_uint(uint64_t val);
+
+  /// writes a signed number
+  void write_int(int64_t val);
+
+  /// writes a Boolean value
+  void write_bool(bool val) { this->write_uint(val); }
+
+  /// writes a set of states
+  void write_bitset(const state_bitset& states);
+
+  /// writes a BDD over the atomic propositions of the automaton
+  void write_bdd(const bdd& cond);
+
+  /// writes a container of unsigned numbers (with its size)
+  template <class C>
+  void write_uint_range(const C& cont)
+  { // {{{
+    this->write_uint(cont.size());
+    for (const auto& val : cont) { this->write_uint(val); }
+  } // write_uint_range() }}}
+
+  /// writes a container of signed numbers (with its size)
+  template <class C>
+  void write_int_range(const C& cont)
+  { // {{{
+    this->write_uint(cont.size());
+    for (const auto& val : cont) { this->write_int(val); }
+  } // write_int_range() }}}
+
+  /// finishes the checkpoint and moves it to its place
+  void commit();
+}; // checkpoint_writer }}}
+
+
+/// Reads a checkpoint written by checkpoint_writer.  Throws
+/// std::runtime_error if the file cannot be read, is malformed, or was
+/// written for another kind of construction, with other options, or for
+/// another automaton.
+class checkpoint_reader
+{ // {{{
+private: // DATA MEMBERS
+
+  std::string path_;
+  std::ifstream in_;
+  /// BDD variables of the atomic propositions
+  std::vector<int> ap_vars_;
+
+public: // METHODS
+
+  /// opens a checkpoint of the construction 'kind' with 'options' on 'aut'
+  checkpoint_reader(
+    const std::string&                path,
+    const std::string&                kind,
+    const std::string&                options,
+    const spot::const_twa_graph_ptr&  aut);
+
+  /// reads an unsigned number
+  uint64_t read_uint();
+
+  /// reads a signed number
+  int64_t read_int();
+
+  /// reads a Boolean value
+  bool read_bool() { return 0 != this->read_uint(); }
+
+  /// reads a set of states
+  state_bitset read_bitset();
+
+  /// reads a BDD over the atomic propositions of the automaton
+  bdd read_bdd();
+
+  /// reads a vector of unsigned numbers written by write_uint_range()
+  template <class T = unsigned>
+  std::vector<T> read_uint_vector()
+  { // {{{
+    std::vector<T> result(this->read_uint());
+    for (T& val : result) { val = static_cast<T>(this->read_uint()); }
+    return result;
+  } // read_uint_vector() }}}
+
+  /// reads a vector of signed numbers written by write_int_range()
+  template <class T = int>
+  std::vector<T> read_int_vector()
+  { // {{{
+    std::vector<T> result(this->read_uint());
+    for (T& val : result) { val = static_cast<T>(this->read_int()); }
+    return result;
+  } // read_int_vector() }}}
+
+  /// throws an exception saying that the checkpoint does not fit
+  [[noreturn]] void fail(const std::string& reason) const;
+}; // checkpoint_reader }}}
+
+} // namespace kofola }}}
@@ -8,39 +8,6 @@ using mstate_set = abstract_complement_alg::mstate_set;
 using mstate_col_set = abstract_complement_alg::mstate_col_set;
 
 
-namespace { // {{{
-
-/// partial macrostate for the given component
-class mstate_mh : public abstract_complement_alg::mstate
-{ // {{{
-private: // DATA MEMBERS
-
-  bool active_;
-  std::set<unsigned> states_;
-  std::set<unsigned> breakpoint_;
-
-public: // METHODS
-
-  /// constructor
-  mstate_mh(
-    const std::set<unsigned>&  states,
-    const std::set<unsigned>&  breakpoint,
-    bool                       active
-  ) : states_(states),
-    breakpoint_(breakpoint),
-    active_(active)
-  { }
-
-  virtual std::string to_string() const override;
-  virtual bool is_active() const override { return this->active_; }
-  virtual bool eq(const mstate& rhs) const override;
-  virtual bool lt(const mstate& rhs) const override;
-  virtual ~mstate_mh() override { }
-
-  friend class kofola::complement_mh;
-}; // mstate_mh }}}
-
-
 std::string mstate_mh::to_string() const
 {
   std::string res = std::string("[MH(") + ((this->active_)? "A" : "T") + "): ";
@@ -52,26 +19,34 @@ std::string mstate_mh::to_string() const
   return res;
 }
 
-bool mstate_mh::eq(const mstate& rhs) const
+bool mstate_mh::operator==(const mstate_mh& rhs) const
 {
-  const mstate_mh* rhs_mh = dynamic_cast<const mstate_mh*>(&rhs);
-  assert(rhs_mh);
-  return (this->states_ == rhs_mh->states_) &&
-    (this->breakpoint_ == rhs_mh->breakpoint_);
+  return (this->states_ == rhs.states_) &&
+    (this->breakpoint_ == rhs.breakpoint_);
 }
 
-bool mstate_mh::lt(const mstate& rhs) const
+bool mstate_mh::operator<(const mstate_mh& rhs) const
 {
-  const mstate_mh* rhs_mh = dynamic_cast<const mstate_mh*>(&rhs);
-  assert(rhs_mh);
-
-  if (this->states_ != rhs_mh->states_) { return this->states_ < rhs_mh->states_; }
-  if (this->breakpoint_ != rhs_mh->breakpoint_) { return this->breakpoint_ < rhs_mh->breakpoint_; }
+  if (this->states_ != rhs.states_) { return this->states_ < rhs.states_; }
+  if (this->breakpoint_ != rhs.breakpoint_) { return this->breakpoint_ < rhs.breakpoint_; }
 
   return false;   // if all are equal
 }
 
-} // anonymous namespace }}}
+size_t mstate_mh::hash() const
+{
+  // NB: active_ is not considered by eq()
+  size_t res = this->states_.hash();
+  res = kofola::hash_combine(res, this->breakpoint_.hash());
+  return res;
+}
+
+void mstate_mh::save(checkpoint_writer& out) const
+{
+  out.write_bool(this->active_);
+  out.write_bitset(this->states_);
+  out.write_bitset(this->breakpoint_);
+}
 
 complement_mh::complement_mh(const cmpl_info& info, unsigned part_index)
   : abstract_complement_alg(info, part_index)
@@ -79,7 +54,7 @@ complement_mh::complement_mh(const cmpl_info& info, unsigned part_index)
 
 mstate_set complement_mh::get_init() const
 { // {{{
-  std::set<unsigned> init_state;
+  state_bitset init_state;
 
   unsigned orig_init = this->info_.aut_->get_init_state_number();
   if (this->info_.st_to_part_map_.at(orig_init) == this->part_index_) {
@@ -87,91 +62,90 @@ mstate_set complement_mh::get_init() const
   }
 
   mstate_set result;
-  std::shared_ptr<mstate> ms(new mstate_mh(init_state, {}, false));
-  result.push_back(ms);
+  result.push_back(mstate_mh(init_state, {}, false));
 
   return result;
 } // get_init() }}}
 
 mstate_col_set complement_mh::get_succ_track(
-  const std::set<unsigned>&  glob_reached,
-  const mstate*              src,
-  const bdd&                 symbol) const
+  const state_bitset&        glob_reached,
+  const mstate&              src,
+  unsigned                   symbol) const
 { // {{{
   DEBUG_PRINT_LN("Miyano-Hayashi successor");
   DEBUG_PRINT_LN("glob_reached = " + std::to_string(glob_reached));
-  DEBUG_PRINT_LN("src = " + std::to_string(*src));
+  DEBUG_PRINT_LN("src = " + std::to_string(src));
   DEBUG_PRINT_LN("symbol = " + std::to_string(symbol));
 
-  const mstate_mh* src_mh = dynamic_cast<const mstate_mh*>(src);
+  const mstate_mh* src_mh = std::get_if<mstate_mh>(&src);
   assert(src_mh);
   assert(!src_mh->active_);
 
-  std::set<unsigned> states;
-  for (unsigned st : glob_reached) {
-    if (this->info_.st_to_part_map_.at(st) == this->part_index_) {
-      states.insert(st);
-    }
-  }
+  state_bitset states = glob_reached & this->part_states_;
 
-  std::shared_ptr<mstate> ms(new mstate_mh(states, {}, false));
-  return {{ms, {}}};
+  return {{mstate_mh(states, {}, false), {}}};
 } // get_succ_track() }}}
 
-mstate_set complement_mh::lift_track_to_active(const mstate* src) const
+mstate_set complement_mh::lift_track_to_active(const mstate& src) const
 { // {{{
-  const mstate_mh* src_mh = dynamic_cast<const mstate_mh*>(src);
+  const mstate_mh* src_mh = std::get_if<mstate_mh>(&src);
   assert(src_mh);
   assert(!src_mh->active_);
 
-  std::shared_ptr<mstate> ms(new mstate_mh(src_mh->states_, src_mh->states_, true));
-  return {ms};
+  return {mstate_mh(src_mh->states_, src_mh->states_, true)};
 } // lift_track_to_active() }}}
 
 mstate_col_set complement_mh::get_succ_active(
-  const std::set<unsigned>&  glob_reached,
-  const mstate*              src,
-  const bdd&                 symbol) const
+  const state_bitset&        glob_reached,
+  const mstate&              src,
+  unsigned                   symbol) const
 {
-  const mstate_mh* src_mh = dynamic_cast<const mstate_mh*>(src);
+  const mstate_mh* src_mh = std::get_if<mstate_mh>(&src);
   assert(src_mh);
   assert(src_mh->active_);
 
   DEBUG_PRINT_LN("tracking successor of: " + std::to_string(*src_mh));
-  mstate_mh tmp(src_mh->states_, {}, false);
-  mstate_col_set track_succ = this->get_succ_track(glob_reached, &tmp, symbol);
+  const mstate tmp = mstate_mh(src_mh->states_, {}, false);
+  mstate_col_set track_succ = this->get_succ_track(glob_reached, tmp, symbol);
 
   if (track_succ.size() == 0) { return {};}
   assert(track_succ.size() == 1);
 
-  const mstate_mh* track_ms = dynamic_cast<const mstate_mh*>(track_succ[0].first.get());
+  const mstate_mh* track_ms = std::get_if<mstate_mh>(&track_succ[0].first);
   assert(track_ms);
 
   DEBUG_PRINT_LN("obtained track ms: " + std::to_string(*track_ms));
 
-  std::set<unsigned> succ_break = kofola::get_all_successors_in_scc(
-    this->info_.aut_, this->info_.scc_info_, src_mh->breakpoint_, symbol);
+  state_bitset succ_break = kofola::get_all_successors_in_scc(
+    this->info_.post_table_, src_mh->breakpoint_, symbol);
 
   // intersect with what is really reachable (for simulation pruning)
-  succ_break = kofola::get_set_intersection(succ_break, glob_reached);
+  succ_break &= glob_reached;
 
   mstate_col_set result;
   if (succ_break.empty()) { // hit breakpoint
     if (this->use_round_robin()) {
-      std::shared_ptr<mstate> ms(new mstate_mh(track_ms->states_, {}, false));
-      result.push_back({ms, {0}});
+      result.push_back({mstate_mh(track_ms->states_, {}, false), {0}});
     } else { // no round robin
-      std::shared_ptr<mstate> ms(new mstate_mh(track_ms->states_, track_ms->states_, true));
-      result.push_back({ms, {0}});
+      result.push_back({mstate_mh(track_ms->states_, track_ms->states_, true), {0}});
     }
   }
   else { // no breakpoint
-    std::shared_ptr<mstate> ms(new mstate_mh(track_ms->states_, succ_break, true));
-    result.push_back({ms, {}});
+    result.push_back({mstate_mh(track_ms->states_, succ_break, true), {}});
   }
 
   return result;
 }
 
+abstract_complement_alg::mstate complement_mh::load_mstate(
+  checkpoint_reader&         in) const
+{ // {{{
+  const bool active = in.read_bool();
+  state_bitset states = in.read_bitset();
+  state_bitset breakpoint = in.read_bitset();
+
+  return mstate_mh(states, breakpoint, active);
+} // load_mstate() }}}
+
 complement_mh::~complement_mh()
 { }
@@ -19,16 +19,18 @@ public: // METHODS
   virtual mstate_set get_init() const override;
 
   virtual mstate_col_set get_succ_track(
-    const std::set<unsigned>&  glob_reached,
-    const mstate*              src,
-    const bdd&                 symbol) const override;
+    const state_bitset&        glob_reached,
+    const mstate&              src,
+    unsigned                   symbol) const override;
 
-  virtual mstate_set lift_track_to_active(const mstate* src) const override;
+  virtual mstate_set lift_track_to_active(const mstate& src) const override;
 
   virtual mstate_col_set get_succ_active(
-    const std::set<unsigned>&  glob_reached,
-    const mstate*              src,
-    const bdd&                 symbol) const override;
+    const state_bitset&        glob_reached,
+    const mstate&              src,
+    unsigned                   symbol) const override;
+
+  virtual mstate load_mstate(checkpoint_reader& in) const override;
 
   virtual bool use_round_robin() const override { return false; }
 
@@ -9,58 +9,14 @@ using mstate_col_set = abstract_complement_alg::mstate_col_set;
 
 namespace { // anonymous namespace {{{
 
-/// partial macrostate for the given component
-class mstate_ncsb : public abstract_complement_alg::mstate
-{ // {{{
-private: // DATA MEMBERS
-
-  bool active_;                    // true = active ; false = track
-  std::set<unsigned> check_;       // states for runs that need to be checked
-  std::set<unsigned> safe_;        // safe states (cannot see accepting transition)
-  std::set<unsigned> breakpoint_;
-
-public: // METHODS
-
-  /// constructor
-  mstate_ncsb(
-    const std::set<unsigned>&  check,
-    const std::set<unsigned>&  safe,
-    const std::set<unsigned>&  breakpoint,
-    bool                       active
-  ) : check_(check),
-    safe_(safe),
-    breakpoint_(breakpoint),
-    active_(active)
-  { }
-
-  virtual std::string to_string() const override;
-  virtual bool is_active() const override { return this->active_; }
-  virtual bool eq(const mstate& rhs) const override;
-  virtual bool lt(const mstate& rhs) const override;
-  virtual ~mstate_ncsb() override { }
-
-  friend class kofola::complement_ncsb;
-}; // mstate_ncsb }}}
-
-
 /// returns true of there is at least one outgoing accepting transition from
-/// a set of states over the given symbol in the SCC the source state is in
+/// a set of states over the given letter in the SCC the source state is in
 bool contains_accepting_outgoing_transitions_in_scc(
-  const spot::const_twa_graph_ptr&    aut,
-  const kofola::StateToPartitionMap&  st_to_part_map,
-  const spot::scc_info&               scc_info,
-  const std::set<unsigned>&           states,
-  const bdd&                          symbol)
+  const kofola::post_image_table&     posts,
+  const state_bitset&                 states,
+  unsigned                            symbol)
 { // {{{
-  for (unsigned s : states) {
-    for (const auto &t : aut->out(s)) {
-      if (scc_info.scc_of(s) == scc_info.scc_of(t.dst) && bdd_implies(symbol, t.cond)) {
-        if (t.acc) { return true; }
-      }
-    }
-  }
-
-  return false;
+  return posts.has_acc_post_in_scc(states, symbol);
 } // contains_accepting_outgoing_transitions() }}}
 
 } // anonymous namespace }}}
@@ -79,29 +35,43 @@ std::string mstate_ncsb::to_string() const
   return res;
 }
 
-bool mstate_ncsb::eq(const mstate& rhs) const
+bool mstate_ncsb::operator==(const mstate_ncsb& rhs) const
 {
-  const mstate_ncsb* rhs_ncsb = dynamic_cast<const mstate_ncsb*>(&rhs);
-  assert(rhs_ncsb);
-  return (this->active_ == rhs_ncsb->active_) &&
-    (this->check_ == rhs_ncsb->check_) &&
-    (this->safe_ == rhs_ncsb->safe_) &&
-    (this->breakpoint_ == rhs_ncsb->breakpoint_);
+  return (this->active_ == rhs.active_) &&
+    (this->check_ == rhs.check_) &&
+    (this->safe_ == rhs.safe_) &&
+    (this->breakpoint_ == rhs.breakpoint_);
 }
 
 
-bool mstate_ncsb::lt(const mstate& rhs) const
+bool mstate_ncsb::operator<(const mstate_ncsb& rhs) const
 { // {{{
-  const mstate_ncsb* rhs_ncsb = dynamic_cast<const mstate_ncsb*>(&rhs);
-  assert(rhs_ncsb);
-
-  if (this->active_ != rhs_ncsb->active_) { return this->active_ < rhs_ncsb->active_; }
-  if (this->check_ != rhs_ncsb->check_) { return this->check_ < rhs_ncsb->check_; }
-  if (this->safe_ != rhs_ncsb->safe_) { return this->safe_ < rhs_ncsb->safe_; }
-  if (this->breakpoint_ != rhs_ncsb->breakpoint_) { return this->breakpoint_ < rhs_ncsb->breakpoint_; }
+  if (this->active_ != rhs.active_) { return this->active_ < rhs.active_; }
+  if (this->check_ != rhs.check_) { return this->check_ < rhs.check_; }
+  if (this->safe_ != rhs.safe_) { return this->safe_ < rhs.safe_; }
+  if (this->breakpoint_ != rhs.breakpoint_) { return this->breakpoint_ < rhs.breakpoint_; }
 
   return false;   // if all are equal
-} // lt() }}}
+} // operator<() }}}
+
+
+size_t mstate_ncsb::hash() const
+{ // {{{
+  size_t res = this->active_;
+  res = kofola::hash_combine(res, this->check_.hash());
+  res = kofola::hash_combine(res, this->safe_.hash());
+  res = kofola::hash_combine(res, this->breakpoint_.hash());
+  return res;
+} // hash() }}}
+
+
+void mstate_ncsb::save(checkpoint_writer& out) const
+{ // {{{
+  out.write_bool(this->active_);
+  out.write_bitset(this->check_);
+  out.write_bitset(this->safe_);
+  out.write_bitset(this->breakpoint_);
+} // save() }}}
 
 
 complement_ncsb::complement_ncsb(const cmpl_info& info, unsigned part_index)
@@ -111,109 +81,96 @@ complement_ncsb::complement_ncsb(const cmpl_info& info, unsigned part_index)
 mstate_set complement_ncsb::get_init() const
 { // {{{
   DEBUG_PRINT_LN("init NCSB for partition " + std::to_string(this->part_index_));
-  std::set<unsigned> init_state;
+  state_bitset init_state;
 
   unsigned orig_init = this->info_.aut_->get_init_state_number();
   if (this->info_.st_to_part_map_.at(orig_init) == this->part_index_) {
     init_state.insert(orig_init);
   }
 
-  std::shared_ptr<mstate> ms(new mstate_ncsb(init_state, {}, {}, false));
-  mstate_set result = {ms};
+  mstate_set result = {mstate_ncsb(init_state, {}, {}, false)};
   return result;
 } // get_init() }}}
 
 mstate_col_set complement_ncsb::get_succ_track(
-  const std::set<unsigned>&  glob_reached,
-  const mstate*              src,
-  const bdd&                 symbol) const
+  const state_bitset&        glob_reached,
+  const mstate&              src,
+  unsigned                   symbol) const
 {
-  const mstate_ncsb* src_ncsb = dynamic_cast<const mstate_ncsb*>(src);
+  const mstate_ncsb* src_ncsb = std::get_if<mstate_ncsb>(&src);
   assert(src_ncsb);
   assert(!src_ncsb->active_);
 
   // check that safe states do not see accepting transition in the same SCC
   if (contains_accepting_outgoing_transitions_in_scc(
-      this->info_.aut_,
-      this->info_.st_to_part_map_,
-      this->info_.scc_info_,
-      src_ncsb->safe_, symbol)) {
+      this->info_.post_table_, src_ncsb->safe_, symbol)) {
     return {};
   }
 
-  std::set<unsigned> succ_safe = kofola::get_all_successors_in_scc(
-    this->info_.aut_, this->info_.scc_info_, src_ncsb->safe_, symbol);
+  state_bitset succ_safe = kofola::get_all_successors_in_scc(
+    this->info_.post_table_, src_ncsb->safe_, symbol);
 
-  std::set<unsigned> succ_states;
-  for (unsigned st : glob_reached) {
-    if (this->info_.st_to_part_map_.at(st) == this->part_index_) {
-      if (succ_safe.find(st) == succ_safe.end()) { // if not in safe
-        succ_states.insert(st);
-      }
-    }
-  }
+  // reached states of the partition that are not safe
+  state_bitset succ_states = (glob_reached & this->part_states_) - succ_safe;
 
   // intersect with what is really reachable (for simulation pruning)
   // TODO: make intersection with glob_reached()
 
-  std::shared_ptr<mstate> ms(new mstate_ncsb(succ_states, succ_safe, {}, false));
-  mstate_col_set result = {{ms, {}}}; return result;
+  mstate_col_set result = {{mstate_ncsb(succ_states, succ_safe, {}, false), {}}};
+  return result;
 } // get_succ_track() }}}
 
-mstate_set complement_ncsb::lift_track_to_active(const mstate* src) const
+mstate_set complement_ncsb::lift_track_to_active(const mstate& src) const
 { // {{{
-  const mstate_ncsb* src_ncsb = dynamic_cast<const mstate_ncsb*>(src);
+  const mstate_ncsb* src_ncsb = std::get_if<mstate_ncsb>(&src);
   assert(src_ncsb);
   assert(!src_ncsb->active_);
 
-  std::shared_ptr<mstate> ms(new mstate_ncsb(src_ncsb->check_, src_ncsb->safe_, src_ncsb->check_, true));
-  return {ms};
+  return {mstate_ncsb(src_ncsb->check_, src_ncsb->safe_, src_ncsb->check_, true)};
 } // lift_track_to_active() }}}
 
 mstate_col_set complement_ncsb::get_succ_active(
-  const std::set<unsigned>&  glob_reached,
-  const mstate*              src,
-  const bdd&                 symbol) const
+  const state_bitset&        glob_reached,
+  const mstate&              src,
+  unsigned                   symbol) const
 {
   DEBUG_PRINT_LN("computing successor for glob_reached = " + std::to_string(glob_reached) +
-    ", " + std::to_string(*src) + " over " + std::to_string(symbol));
-  const mstate_ncsb* src_ncsb = dynamic_cast<const mstate_ncsb*>(src);
+    ", " + std::to_string(src) + " over " + std::to_string(symbol));
+  const mstate_ncsb* src_ncsb = std::get_if<mstate_ncsb>(&src);
   assert(src_ncsb);
   assert(src_ncsb->active_);
 
   DEBUG_PRINT_LN("tracking successor of: " + std::to_string(*src_ncsb));
-  mstate_ncsb tmp(src_ncsb->check_, src_ncsb->safe_, {}, false);
-  mstate_col_set track_succ = this->get_succ_track(glob_reached, &tmp, symbol);
+  const mstate tmp = mstate_ncsb(src_ncsb->check_, src_ncsb->safe_, {}, false);
+  mstate_col_set track_succ = this->get_succ_track(glob_reached, tmp, symbol);
 
   if (track_succ.size() == 0) { return {};}
   assert(track_succ.size() == 1);
 
-  const mstate_ncsb* track_ms = dynamic_cast<const mstate_ncsb*>(track_succ[0].first.get());
+  const mstate_ncsb* track_ms = std::get_if<mstate_ncsb>(&track_succ[0].first);
   assert(track_ms);
 
   DEBUG_PRINT_LN("obtained track ms: " + std::to_string(*track_ms));
 
-  std::set<unsigned> tmp_break = kofola::get_all_successors_in_scc(
-    this->info_.aut_, this->info_.scc_info_, src_ncsb->breakpoint_, symbol);
+  state_bitset tmp_break = kofola::get_all_successors_in_scc(
+    this->info_.post_table_, src_ncsb->breakpoint_, symbol);
 
   DEBUG_PRINT_LN("tmp_break = " + std::to_string(tmp_break));
 
-  std::set<unsigned> succ_break = get_set_difference(tmp_break, track_ms->safe_);
+  state_bitset succ_break = get_set_difference(tmp_break, track_ms->safe_);
   if (succ_break.empty()) { // if we hit breakpoint
     mstate_col_set result;
     if (this->use_round_robin()) {
-      std::shared_ptr<mstate> ms(new mstate_ncsb(track_ms->check_, track_ms->safe_, {}, false));
-      result.push_back({ms, {0}});
+      result.push_back({mstate_ncsb(track_ms->check_, track_ms->safe_, {}, false), {0}});
     } else { // no round robing
-      std::shared_ptr<mstate> ms(new mstate_ncsb(track_ms->check_, track_ms->safe_, track_ms->check_, true));
-      result.push_back({ms, {0}});
+      result.push_back({mstate_ncsb(track_ms->check_, track_ms->safe_, track_ms->check_, true), {0}});
     }
     return result;
   } else { // not breakpoint
     mstate_col_set result;
-    std::shared_ptr<mstate> ms(new mstate_ncsb(track_ms->check_, track_ms->safe_, succ_break, true));
-    DEBUG_PRINT_LN("standard successor: " + ms->to_string());
-    result.push_back({ms, {}});
+    mstate_ncsb ms(track_ms->check_, track_ms->safe_, succ_break, true);
+    DEBUG_PRINT_LN("standard successor: " + ms.to_string());
+    result.push_back({std::move(ms), {}});
 
     // let us generate decreasing successor if the following three conditions hold:
     //   1) src_ncsb->breakpoint_ contains no accepting state
@@ -234,23 +191,31 @@ mstate_col_set complement_ncsb::get_succ_active(
 
     // 3) delta(src_ncsb->breakpoint_, symbol) contains no accepting condition
     if (contains_accepting_outgoing_transitions_in_scc(
-        this->info_.aut_,
-        this->info_.st_to_part_map_,
-        this->info_.scc_info_,
-        src_ncsb->breakpoint_, symbol)) {
+        this->info_.post_table_, src_ncsb->breakpoint_, symbol)) {
       return result;
     }
 
     // add the decreasing successor
-    std::set<unsigned> decr_safe = get_set_union(track_ms->safe_, succ_break);
-    std::set<unsigned> decr_check = get_set_difference(track_ms->check_, decr_safe);
-    std::shared_ptr<mstate> decr_ms(new mstate_ncsb(decr_check, decr_safe, decr_check, true));
-    DEBUG_PRINT_LN("decreasing successor: " + decr_ms->to_string());
-    result.push_back({decr_ms, {0}});
+    state_bitset decr_safe = get_set_union(track_ms->safe_, succ_break);
+    state_bitset decr_check = get_set_difference(track_ms->check_, decr_safe);
+    mstate_ncsb decr_ms(decr_check, decr_safe, decr_check, true);
+    DEBUG_PRINT_LN("decreasing successor: " + decr_ms.to_string());
+    result.push_back({std::move(decr_ms), {0}});
 
     return result;
   }
 }
 
+abstract_complement_alg::mstate complement_ncsb::load_mstate(
+  checkpoint_reader&         in) const
+{ // {{{
+  const bool active = in.read_bool();
+  state_bitset check = in.read_bitset();
+  state_bitset safe = in.read_bitset();
+  state_bitset breakpoint = in.read_bitset();
+
+  return mstate_ncsb(check, safe, breakpoint, active);
+} // load_mstate() }}}
+
 complement_ncsb::~complement_ncsb()
 { }
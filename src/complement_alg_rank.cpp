@@ -14,60 +14,8 @@ namespace { // {{{
 const unsigned BOX = UINT_MAX;
 
 
-/// partial macrostate for the given component
-class mstate_rank : public abstract_complement_alg::mstate
-{ // {{{
-private: // DATA MEMBERS
-
-  bool active_;
-  std::set<unsigned> states_;       // {} when !is_waiting_
-  bool is_waiting_;                 // true - waiting, false - tight
-  std::set<unsigned> breakpoint_;   // {} when !active_ || is_waiting_
-  ranking f_;                       // {} when is_waiting_
-  int i_;                           // -1 when !active_ || is_waiting_
-
-public: // METHODS
-
-  /// constructor
-  mstate_rank(
-    const std::set<unsigned>&  states,
-    bool                       is_waiting,
-    const std::set<unsigned>&  breakpoint,
-    const ranking&             f,
-    int                        i,
-    bool                       active
-  ) : states_(states),
-    is_waiting_(is_waiting),
-    breakpoint_(breakpoint),
-    f_(f),
-    i_(i),
-    active_(active)
-  { }
-
-  virtual std::string to_string() const override;
-  virtual bool is_active() const override { return this->active_; }
-  virtual bool eq(const mstate& rhs) const override;
-  virtual bool lt(const mstate& rhs) const override;
-  virtual ~mstate_rank() override { }
-
-  bool invariants_hold() const;
-
-  friend class kofola::complement_rank;
-
-  friend std::set<unsigned> get_successors_with_box(
-    const std::set<unsigned>&  glob_reach,
-    const mstate_rank&         rank_state,
-    unsigned                   part_index,
-    const cmpl_info&           info);
-
-  friend std::vector<ranking> get_maxrank(
-    const std::set<unsigned>&  glob_reach,
-    const mstate_rank&         rank_state,
-    const RankRestriction&     rank_restr,
-    unsigned                   part_index,
-    const bdd&                 symbol,
-    const cmpl_info&           info);
-}; // mstate_rank }}}
+} // anonymous namespace }}}
+
 
 bool mstate_rank::invariants_hold() const
 { // {{{
@@ -112,57 +60,83 @@ std::string mstate_rank::to_string() const
 } // to_string() }}}
 
 
-bool mstate_rank::eq(const mstate& rhs) const
+bool mstate_rank::operator==(const mstate_rank& rhs) const
 {
-  const mstate_rank* rhs_rank = dynamic_cast<const mstate_rank*>(&rhs);
-  assert(rhs_rank);
-
-  return this->active_ == rhs_rank->active_ &&
-    this->is_waiting_ == rhs_rank->is_waiting_ &&
-    this->states_ == rhs_rank->states_ &&
-    this->breakpoint_ == rhs_rank->breakpoint_ &&
-    this->f_ == rhs_rank->f_ &&
-    this->i_ == rhs_rank->i_;
+  return this->active_ == rhs.active_ &&
+    this->is_waiting_ == rhs.is_waiting_ &&
+    this->states_ == rhs.states_ &&
+    this->breakpoint_ == rhs.breakpoint_ &&
+    this->f_ == rhs.f_ &&
+    this->i_ == rhs.i_;
 }
 
-bool mstate_rank::lt(const mstate& rhs) const
+bool mstate_rank::operator<(const mstate_rank& rhs) const
 {
-  const mstate_rank* rhs_rank = dynamic_cast<const mstate_rank*>(&rhs);
-  assert(rhs_rank);
-
-  if (this->active_ == rhs_rank->active_) {
-    if (this->is_waiting_ == rhs_rank->is_waiting_) {
-      if (this->i_ == rhs_rank->i_) {
-        if (this->states_ == rhs_rank->states_) {
-          if (this->breakpoint_ == rhs_rank->breakpoint_) {
-            return this->f_ < rhs_rank->f_;
+  if (this->active_ == rhs.active_) {
+    if (this->is_waiting_ == rhs.is_waiting_) {
+      if (this->i_ == rhs.i_) {
+        if (this->states_ == rhs.states_) {
+          if (this->breakpoint_ == rhs.breakpoint_) {
+            return this->f_ < rhs.f_;
           } else {
-            return this->breakpoint_ < rhs_rank->breakpoint_;
+            return this->breakpoint_ < rhs.breakpoint_;
           }
         } else {
-          return this->states_ < rhs_rank->states_;
+          return this->states_ < rhs.states_;
         }
       } else {
-        return this->i_ < rhs_rank->i_;
+        return this->i_ < rhs.i_;
       }
     } else {
-      return this->is_waiting_ < rhs_rank->is_waiting_;
+      return this->is_waiting_ < rhs.is_waiting_;
     }
   } else {
-    return this->active_ < rhs_rank->active_;
+    return this->active_ < rhs.active_;
   }
 }
 
 
+size_t mstate_rank::hash() const
+{ // {{{
+  size_t res = kofola::hash_combine(this->active_, this->is_waiting_);
+  res = kofola::hash_combine(res, this->i_);
+  res = kofola::hash_range(this->states_.begin(), this->states_.end(), res);
+  res = kofola::hash_range(this->breakpoint_.begin(), this->breakpoint_.end(), res);
+  for (const auto& pr : this->f_) { // NB: eq() ignores the max rank of f_
+    res = kofola::hash_combine(res, pr.first);
+    res = kofola::hash_combine(res, pr.second);
+  }
+  return res;
+} // hash() }}}
+
+
+void mstate_rank::save(checkpoint_writer& out) const
+{ // {{{
+  out.write_bool(this->active_);
+  out.write_bool(this->is_waiting_);
+  out.write_uint_range(this->states_);
+  out.write_uint_range(this->breakpoint_);
+  out.write_uint(this->f_.get_max_rank());
+  out.write_uint(this->f_.size());
+  for (const auto& pr : this->f_) {
+    out.write_int(pr.first);
+    out.write_int(pr.second);
+  }
+  out.write_int(this->i_);
+} // save() }}}
+
+
+namespace { // {{{
+
 /// returns true iff 'pred' is a predecessor of 'state'
 bool is_predecessor_of(unsigned pred, unsigned state, const cmpl_info& info)
 {
-  return kofola::is_in(state, info.reachable_vector_[pred]);
+  return info.reach_.reaches(pred, state);
 }
 
 
 std::set<unsigned> get_successors_with_box(
-  const std::set<unsigned>&  glob_reach,
+  const state_bitset&        glob_reach,
   const mstate_rank&         rank_state,
   unsigned                   part_index,
   const cmpl_info&           info)
@@ -191,8 +165,7 @@ std::set<unsigned> get_successors_with_box(
         if (info.st_to_part_map_.at(state) != part_index) {
           unsigned state_scc_index = info.scc_info_.scc_of(state);
           for (unsigned part_scc_index : info.part_to_scc_map_.at(part_index)) {
-            if (kofola::is_in(state_scc_index,
-                info.scc_to_pred_sccs_map_.at(part_scc_index))) {
+            if (info.reach_.scc_reaches(state_scc_index, part_scc_index)) {
               succ.insert(BOX);
               break;
             }
@@ -207,7 +180,9 @@ std::set<unsigned> get_successors_with_box(
 
 
 /// retrieves the WAITING part of an automaton
-static waiting get_waiting_part(const spot::const_twa_graph_ptr& aut)
+static waiting get_waiting_part(
+  const spot::const_twa_graph_ptr&  aut,
+  const minterm_alphabet&           alphabet)
 { // {{{
   std::set<std::set<unsigned>> states;
   std::map<std::set<unsigned>, std::set<std::set<unsigned>>> trans;
@@ -227,33 +202,11 @@ static waiting get_waiting_part(const spot::const_twa_graph_ptr& aut)
     stack.pop();
     std::set<std::set<unsigned>> succ;
 
-    // outgoing symbols
-    std::vector<bdd> alphabet;
-
-    bdd msupport = bddtrue;
-    bdd n_s_compat = bddfalse;
-
-    // const std::set<unsigned> &reach_set = state;
-    // compute the occurred variables in the outgoing transitions of ms, stored in msupport
-    for (unsigned s : state)
-    {
-      for (const auto &out : aut->out(s)) { // FIXME: this should be pre-computed for every state
-        msupport &= bdd_support(out.cond);
-        n_s_compat |= out.cond;
-      }
-    }
-
-    bdd all = n_s_compat;
-
-    while (all != bddfalse)
-    {
-      bdd letter = bdd_satoneset(all, msupport, bddfalse);
-      all -= letter;
-      alphabet.push_back(letter);
-    }
+    // outgoing letters
+    std::vector<unsigned> letters = alphabet.get_enabled_letters(state);
 
     std::vector<std::set<unsigned>> alphabet_map;
-    for (unsigned i=0; i<alphabet.size(); i++)
+    for (unsigned i=0; i<letters.size(); i++)
     {
       alphabet_map.push_back(std::set<unsigned>());
     }
@@ -262,9 +215,10 @@ static waiting get_waiting_part(const spot::const_twa_graph_ptr& aut)
     {
       for (const auto &t : aut->out(s))
       {
-        for (unsigned i=0; i<alphabet.size(); i++)
+        unsigned edge = aut->edge_number(t);
+        for (unsigned i=0; i<letters.size(); i++)
         {
-          if (bdd_implies(alphabet[i], t.cond))
+          if (alphabet.edge_has_letter(edge, letters[i]))
           {
             alphabet_map[i].insert(t.dst);
           }
@@ -343,22 +297,16 @@ std::vector<ranking> cart_product(
 
 
 std::set<int> get_all_successors_acc(
-  const spot::const_twa_graph_ptr&  aut,
+  const post_image_table&           posts,
   const spot::scc_info&             scc_info,
   const std::set<unsigned>&         current_states,
-  const bdd&                        symbol,
+  unsigned                          symbol,
   unsigned                          part_index)
 { // {{{
   std::set<int> successors;
-  spot::acc_cond::mark_t acc = {0};
-
-  for (unsigned s : current_states) {
-    for (const auto &t : aut->out(s)) {
-      if (!bdd_implies(symbol, t.cond)) { continue; }
-
-      if (t.acc == acc && scc_info.scc_of(t.dst) == part_index) {
-        successors.insert((int)t.dst);
-      }
+  for (unsigned dst : posts.get_post(current_states, symbol, post_image_table::ACC)) {
+    if (scc_info.scc_of(dst) == part_index) {
+      successors.insert((int)dst);
     }
   }
 
@@ -410,8 +358,10 @@ void check_tight(std::vector<ranking>& rankings)
   rankings = result;
 } // check_tight() }}}
 
+} // anonymous namespace }}}
+
 
-std::vector<ranking> get_tight_rankings(
+std::vector<ranking> kofola::get_tight_rankings(
   const std::vector<std::tuple<int, int, bool>>& mp)
 { // {{{
   std::vector<ranking> rankings;
@@ -451,11 +401,14 @@ std::vector<ranking> get_tight_rankings(
 } // get_tight_rankings() }}}
 
 
+namespace { // {{{
+
+
 std::vector<ranking> get_succ_rankings(
   const ranking&                                  r,
   const std::vector<std::tuple<int, int, bool>>&  restr,
-  const std::set<unsigned>&                       glob_reached,
-  const bdd&                                      symbol,
+  const state_bitset&                             glob_reached,
+  unsigned                                        symbol,
   unsigned                                        part_index,
   const cmpl_info&                                info)
 { // {{{
@@ -497,7 +450,7 @@ std::vector<ranking> get_succ_rankings(
 
       if (state != BOX) {
         std::set<int> succ = get_all_successors_acc(
-          info.aut_, info.scc_info_, {state}, symbol, part_index);
+          info.post_table_, info.scc_info_, {state}, symbol, part_index);
 
         unsigned rank = (r.at(state) % 2 == 0 ? r.at(state) : r.at(state) - 1);
         for (auto s : succ) {
@@ -518,11 +471,11 @@ std::vector<ranking> get_succ_rankings(
 
 
 std::vector<ranking> get_maxrank(
-  const std::set<unsigned>&  glob_reached,
+  const state_bitset&        glob_reached,
   const mstate_rank&         rank_state,
   const RankRestriction&     rank_restr,
   unsigned                   part_index,
-  const bdd&                 symbol,
+  unsigned                   symbol,
   const cmpl_info&           info)
 { // {{{
   std::vector<std::tuple<int, int, bool>> restr;
@@ -555,7 +508,7 @@ std::vector<ranking> get_maxrank(
 
 complement_rank::complement_rank(const cmpl_info& info, unsigned part_index) :
   abstract_complement_alg(info, part_index),
-  waiting_(get_waiting_part(info.aut_))
+  waiting_(get_waiting_part(info.aut_, info.alphabet_))
 { // {{{
   // compute rank restrictions
   unsigned states_in_part = 0;
@@ -577,6 +530,18 @@ complement_rank::complement_rank(const cmpl_info& info, unsigned part_index) :
     this->rank_restr_.insert({mst, 2*(nonacc + 1)});
   }
 
+  // states whose SCC is a predecessor of some SCC of the partition
+  this->relevant_states_ = this->part_states_;
+  for (unsigned st = 0; st < this->info_.aut_->num_states(); ++st) {
+    unsigned st_scc_index = this->info_.scc_info_.scc_of(st);
+    for (unsigned part_scc_index : this->info_.part_to_scc_map_.at(part_index)) {
+      if (this->info_.reach_.scc_reaches(st_scc_index, part_scc_index)) {
+        this->relevant_states_.insert(st);
+        break;
+      }
+    }
+  }
+
   DEBUG_PRINT_LN("waiting_ for partition " + std::to_string(part_index) + ": " +
     std::to_string(this->waiting_));
   DEBUG_PRINT_LN("rank_restr_ for partition " + std::to_string(part_index) + ": " +
@@ -598,42 +563,42 @@ mstate_set complement_rank::get_init() const
     init_state.insert(BOX);
   }
 
-  std::shared_ptr<mstate> ms(new mstate_rank(
+  mstate_rank ms(
     init_state,        // reachable states (S)
     true,              // is it Waiting?
     {},                // breakpoint (O)
     {},                // ranking (f)
     -1,                // index of tracked rank (i)
-    false));           // active
-  mstate_set result = {ms};
+    false);            // active
+  mstate_set result = {std::move(ms)};
   return result;
 } // get_init() }}}
 
 
 mstate_col_set complement_rank::get_succ_track(
-  const std::set<unsigned>&  glob_reached,
-  const mstate*              src,
-  const bdd&                 symbol) const
+  const state_bitset&        glob_reached,
+  const mstate&              src,
+  unsigned                   symbol) const
 { // {{{
-  const mstate_rank* src_rank = dynamic_cast<const mstate_rank*>(src);
+  const mstate_rank* src_rank = std::get_if<mstate_rank>(&src);
   assert(src_rank);
   assert(!src_rank->active_);
   assert(src_rank->invariants_hold());
 
-  DEBUG_PRINT_LN("computing tracking successor of " + std::to_string(src_rank));
+  DEBUG_PRINT_LN("computing tracking successor of " + std::to_string(*src_rank));
 
   if (src_rank->is_waiting_) { // WAITING
     std::set<unsigned> succs = get_successors_with_box(glob_reached, *src_rank,
       this->part_index_, this->info_);
 
-    std::shared_ptr<mstate> ms(new mstate_rank(
+    mstate_rank ms(
       succs,             // reachable states (S)
       true,              // is it Waiting?
       {},                // breakpoint (O)
       {},                // ranking (f)
       -1,                // index of tracked rank (i)
-      false));           // active
-    mstate_col_set result = {{ms, {}}};
+      false);            // active
+    mstate_col_set result = {{std::move(ms), {}}};
     return result;
   } else { // TIGHT
     std::vector<ranking> maxrank = get_maxrank(glob_reached, *src_rank,
@@ -642,31 +607,31 @@ mstate_col_set complement_rank::get_succ_track(
     if (maxrank.size() == 0) { return {}; }
     assert(maxrank.size() == 1);
 
-    std::shared_ptr<mstate> ms(new mstate_rank(
+    mstate_rank ms(
       {},                // reachable states (S)
       false,             // is it Waiting?
       {},                // breakpoint (O)
       maxrank[0],        // ranking (f)
       -1,                // index of tracked rank (i)
-      false));           // active
-    mstate_col_set result = {{ms, {}}};
+      false);            // active
+    mstate_col_set result = {{std::move(ms), {}}};
     return result;
   }
 } // get_succ_track() }}}
 
 
-mstate_set complement_rank::lift_track_to_active(const mstate* src) const
+mstate_set complement_rank::lift_track_to_active(const mstate& src) const
 { // {{{
-  const mstate_rank* src_rank = dynamic_cast<const mstate_rank*>(src);
+  const mstate_rank* src_rank = std::get_if<mstate_rank>(&src);
   assert(src_rank);
   assert(!src_rank->active_);
   assert(src_rank->invariants_hold());
 
   mstate_set result;
   if (src_rank->is_waiting_) { // src is from WAITING
-    std::shared_ptr<mstate_rank> src_cpy(new mstate_rank(*src_rank));
-    src_cpy->active_ = true;
-    result.push_back(src_cpy);          // one option is to stay in WAITING
+    mstate_rank src_cpy(*src_rank);
+    src_cpy.active_ = true;
+    result.push_back(std::move(src_cpy));   // one option is to stay in WAITING
 
     // and let's compute the successors that move to TIGHT
     std::vector<std::tuple<int, int, bool>> r;
@@ -687,14 +652,13 @@ mstate_set complement_rank::lift_track_to_active(const mstate* src) const
       for (auto pr : rnking) { // construct breakpoint
         if (pr.second == 0) { breakpoint.insert(pr.first); }
       }
-      std::shared_ptr<mstate> ms(new mstate_rank(
+      result.push_back(mstate_rank(
         {},                // reachable states (S)
         false,             // is it Waiting?
         breakpoint,        // breakpoint (O)
         rnking,            // ranking (f)
         0,                 // index of tracked rank (i)
         true));            // active
-      result.push_back(ms);
     }
   } else { // src is from TIGHT
     std::set<unsigned> breakpoint;
@@ -702,14 +666,13 @@ mstate_set complement_rank::lift_track_to_active(const mstate* src) const
       if (pr.second == 0) { breakpoint.insert(pr.first); }
     }
 
-    std::shared_ptr<mstate> ms(new mstate_rank(
+    result.push_back(mstate_rank(
       {},                // reachable states (S)
       false,             // is it Waiting?
       breakpoint,        // breakpoint (O)
       src_rank->f_,      // ranking (f)
       0,                 // index of tracked rank (i)
       true));            // active
-    result.push_back(ms);
   }
 
   DEBUG_PRINT_LN("complement_rank::lift returning " + std::to_string(result));
@@ -718,30 +681,29 @@ mstate_set complement_rank::lift_track_to_active(const mstate* src) const
 
 
 mstate_col_set complement_rank::get_succ_active(
-  const std::set<unsigned>&  glob_reached,
-  const mstate*              src,
-  const bdd&                 symbol) const
+  const state_bitset&        glob_reached,
+  const mstate&              src,
+  unsigned                   symbol) const
 { // {{{
-  const mstate_rank* src_rank = dynamic_cast<const mstate_rank*>(src);
+  const mstate_rank* src_rank = std::get_if<mstate_rank>(&src);
   assert(src_rank);
   assert(src_rank->active_);
   assert(src_rank->invariants_hold());
 
   DEBUG_PRINT_LN("tracking successor of: " + std::to_string(*src_rank));
-  mstate_rank tmp(
+  const mstate tmp = mstate_rank(
     src_rank->states_,       // reachable states (S)
     src_rank->is_waiting_,   // is it Waiting?
     {},                      // breakpoint (O)
     src_rank->f_,            // ranking (f)
     -1,                      // index of tracked rank (i)
     false);                  // active
-  mstate_col_set track_succ = this->get_succ_track(glob_reached, &tmp, symbol);
+  mstate_col_set track_succ = this->get_succ_track(glob_reached, tmp, symbol);
 
   if (track_succ.size() == 0) { return {};}
   assert(track_succ.size() == 1);
 
-  const mstate_rank* track_ms = dynamic_cast<const mstate_rank*>(
-    track_succ[0].first.get());
+  const mstate_rank* track_ms = std::get_if<mstate_rank>(&track_succ[0].first);
   assert(track_ms);
 
   DEBUG_PRINT_LN("obtained track ms: " + std::to_string(*track_ms));
@@ -751,13 +713,12 @@ mstate_col_set complement_rank::get_succ_active(
         (src_rank->states_.size() == 1 && kofola::is_in(BOX, src_rank->states_))) {
       // in case src does not track any state from the partition block
 
-      std::shared_ptr<mstate> ms(new mstate_rank(*track_ms));
-      return {{ms, {0}}};
+      return {{*track_ms, {0}}};
     } else {
-      mstate_set lifted = this->lift_track_to_active(track_ms);
+      mstate_set lifted = this->lift_track_to_active(track_succ[0].first);
       mstate_col_set result;
-      for (const auto& ms : lifted) {
-        result.push_back({ms, {}});
+      for (auto& ms : lifted) {
+        result.push_back({std::move(ms), {}});
       }
       return result;
     }
@@ -880,25 +841,23 @@ mstate_col_set complement_rank::get_succ_active(
 
     mstate_col_set result;
     if (eta_3.size() > 0 and std::find(U.begin(), U.end(), eta_3[0]) == U.end()) {
-      std::shared_ptr<mstate> tmp_mstate(new mstate_rank(eta_3[0]));
-      result.push_back({tmp_mstate, {}});
+      result.push_back({eta_3[0], {}});
     }
 
     if (eta_4.size() > 0 and std::find(U.begin(), U.end(), eta_4[0]) == U.end()) {
-      std::shared_ptr<mstate> tmp_mstate(new mstate_rank(eta_4[0]));
-      result.push_back({tmp_mstate, {}});
+      result.push_back({eta_4[0], {}});
     }
 
     for (const mstate_rank& s : U) { // accepting transitions
       // switch to track
-      std::shared_ptr<mstate> new_state(new mstate_rank(
+      mstate_rank new_state(
         {},        // reachable states (S)
         false,     // is it Waiting?
         {},        // breakpoint (O)
         s.f_,      // ranking (f)
         -1,        // index of tracked rank (i)
-        false));   // active
-      result.push_back({new_state, {0}});
+        false);    // active
+      result.push_back({std::move(new_state), {0}});
     }
 
     return result;
@@ -906,5 +865,26 @@ mstate_col_set complement_rank::get_succ_active(
 } // get_succ_active() }}}
 
 
+abstract_complement_alg::mstate complement_rank::load_mstate(
+  checkpoint_reader&         in) const
+{ // {{{
+  const bool active = in.read_bool();
+  const bool is_waiting = in.read_bool();
+  std::vector<unsigned> states = in.read_uint_vector();
+  std::vector<unsigned> breakpoint = in.read_uint_vector();
+  ranking f;
+  f.set_max_rank(in.read_uint());
+  for (uint64_t size = in.read_uint(); size > 0; --size) {
+    const int state = in.read_int();
+    f[state] = in.read_int();
+  }
+  const int i = in.read_int();
+
+  return mstate_rank(
+    std::set<unsigned>(states.begin(), states.end()), is_waiting,
+    std::set<unsigned>(breakpoint.begin(), breakpoint.end()), f, i, active);
+} // load_mstate() }}}
+
+
 complement_rank::~complement_rank()
 { }
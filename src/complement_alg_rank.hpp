@@ -24,6 +24,10 @@ private: // DATA MEMBERS
   /// maximum rank for every macrostate in WAITING
   RankRestriction rank_restr_;
 
+  /// states of the partition and states that can reach it (the reached ones
+  /// from outside the partition give BOX)
+  state_bitset relevant_states_;
+
 public: // METHODS
 
   /// constructor
@@ -32,16 +36,21 @@ public: // METHODS
   virtual mstate_set get_init() const override;
 
   virtual mstate_col_set get_succ_track(
-    const std::set<unsigned>&  glob_reached,
-    const mstate*              src,
-    const bdd&                 symbol) const override;
+    const state_bitset&        glob_reached,
+    const mstate&              src,
+    unsigned                   symbol) const override;
 
-  virtual mstate_set lift_track_to_active(const mstate* src) const override;
+  virtual mstate_set lift_track_to_active(const mstate& src) const override;
 
   virtual mstate_col_set get_succ_active(
-    const std::set<unsigned>&  glob_reached,
-    const mstate*              src,
-    const bdd&                 symbol) const override;
+    const state_bitset&        glob_reached,
+    const mstate&              src,
+    unsigned                   symbol) const override;
+
+  virtual mstate load_mstate(checkpoint_reader& in) const override;
+
+  virtual state_bitset restrict_reached(const state_bitset& glob_reached) const override
+  { return glob_reached & this->relevant_states_; }
 
   virtual bool use_round_robin() const override { return true; }
 
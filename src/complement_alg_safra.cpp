@@ -8,35 +8,14 @@
 #include "complement_alg_safra.hpp"
 #include "safra_tree.hpp"
 
+#include <stdexcept>
+
 using namespace kofola;
 using mstate_set = abstract_complement_alg::mstate_set;
 using mstate_col_set = abstract_complement_alg::mstate_col_set;
 using kofola::safra::safra_tree;
 
 namespace { // {{{
-/// partial macrostate for the given component
-class mstate_safra : public abstract_complement_alg::mstate
-{ // {{{
-private: // DATA MEMBERS
-
-  /// the corresponding Safra tree
-  safra_tree st_;
-
-public: // METHODS
-
-  /// constructor
-  explicit mstate_safra(const safra_tree& st) : st_(st)
-  { }
-
-  virtual std::string to_string() const override;
-  virtual bool is_active() const override { return true; }
-  virtual bool eq(const mstate& rhs) const override;
-  virtual bool lt(const mstate& rhs) const override;
-  virtual ~mstate_safra() override { };
-
-  friend class kofola::complement_safra;
-}; // mstate_safra }}}
-
 
 // Returns true if lhs has a smaller nesting pattern than rhs
 // If lhs and rhs are the same, return false.
@@ -90,12 +69,7 @@ bool compare_braces(const std::vector<int>& braces, int a, int b)
 
 
 bool is_simulation_bigger(unsigned j, unsigned i, const Simulation& sim)
-{ // {{{
-  for (const auto& st_st_pair : sim) {
-    if (st_st_pair.first == i && st_st_pair.second == j) { return true; }
-  }
-  return false;
-} // is_simulation_bigger() }}}
+{ return sim.simulates(j, i); }
 
 
 void simulation_reduce(safra_tree& next, const cmpl_info& info)
@@ -290,20 +264,38 @@ std::string mstate_safra::to_string() const
 } // to_string() }}}
 
 
-bool mstate_safra::lt(const mstate& rhs) const
+bool mstate_safra::operator<(const mstate_safra& rhs) const
+{ // {{{
+  return this->st_ < rhs.st_;
+} // operator<() }}}
+
+
+bool mstate_safra::operator==(const mstate_safra& rhs) const
+{ // {{{
+  return this->st_ == rhs.st_;
+} // operator==() }}}
+
+
+size_t mstate_safra::hash() const
 { // {{{
-  const mstate_safra* rhs_safra = dynamic_cast<const mstate_safra*>(&rhs);
-  assert(rhs_safra);
-  return this->st_ < rhs_safra->st_;
-} // lt() }}}
+  size_t res = 0;
+  for (const auto& lab : this->st_.labels_) {
+    res = kofola::hash_combine(res, lab.first);
+    res = kofola::hash_combine(res, lab.second);
+  }
+  return kofola::hash_range(this->st_.braces_.begin(), this->st_.braces_.end(), res);
+} // hash() }}}
 
 
-bool mstate_safra::eq(const mstate& rhs) const
+void mstate_safra::save(checkpoint_writer& out) const
 { // {{{
-  const mstate_safra* rhs_safra = dynamic_cast<const mstate_safra*>(&rhs);
-  assert(rhs_safra);
-  return this->st_ == rhs_safra->st_;
-} // eq() }}}
+  out.write_uint(this->st_.labels_.size());
+  for (const auto& lab : this->st_.labels_) {
+    out.write_uint(lab.first);
+    out.write_int(lab.second);
+  }
+  out.write_int_range(this->st_.braces_);
+} // save() }}}
 
 
 complement_safra::complement_safra(const cmpl_info& info, unsigned part_index) :
@@ -326,37 +318,35 @@ mstate_set complement_safra::get_init() const
     stree.braces_.push_back(-1);
   }
 
-  std::shared_ptr<mstate> ms(new mstate_safra(stree));
-  result.push_back(ms);
+  result.push_back(mstate_safra(stree));
   return result;
 } // get_init() }}}
 
 
 mstate_col_set complement_safra::get_succ_track(
-  const std::set<unsigned>&  glob_reached,
-  const mstate*              src,
-  const bdd&                 symbol) const
+  const state_bitset&        glob_reached,
+  const mstate&              src,
+  unsigned                   symbol) const
 { // {{{
   assert(false);
 } // get_succ_track() }}}
 
 
-mstate_set complement_safra::lift_track_to_active(const mstate* src) const
+mstate_set complement_safra::lift_track_to_active(const mstate& src) const
 { // {{{
-  const mstate_safra* src_safra = dynamic_cast<const mstate_safra*>(src);
+  const mstate_safra* src_safra = std::get_if<mstate_safra>(&src);
   assert(src_safra);
 
-  std::shared_ptr<mstate> ms(new mstate_safra(src_safra->st_));
-  return {ms};
+  return {mstate_safra(src_safra->st_)};
 } // lift_track_to_active() }}}
 
 
 mstate_col_set complement_safra::get_succ_active(
-  const std::set<unsigned>&  glob_reached,
-  const mstate*              src,
-  const bdd&                 symbol) const
+  const state_bitset&        glob_reached,
+  const mstate&              src,
+  unsigned                   symbol) const
 { // {{{
-  const mstate_safra* src_safra = dynamic_cast<const mstate_safra*>(src);
+  const mstate_safra* src_safra = std::get_if<mstate_safra>(&src);
   assert(src_safra);
 
   // all states in the scc_index should be on the same order
@@ -368,13 +358,14 @@ mstate_col_set complement_safra::get_succ_active(
   // std::map<unsigned, int> curr_nodes;
   std::vector<int> braces = src_safra->st_.braces_;
   std::map<unsigned, int> succ_nodes;
-  std::set<unsigned> succs;
+  state_bitset succs;
 
   // first deal with all states already in the SCCs
   for (const auto &node : src_safra->st_.labels_) {
     const unsigned state = node.first;
     for (const auto &tr : this->info_.aut_->out(state)) {
-      if (!bdd_implies(symbol, tr.cond)) { continue; }
+      if (!this->info_.alphabet_.edge_has_letter(
+          this->info_.aut_->edge_number(tr), symbol)) { continue; }
 
       const unsigned dst = tr.dst;
       if (!kofola::is_in(dst, glob_reached)) { continue; }
@@ -430,7 +421,7 @@ mstate_col_set complement_safra::get_succ_active(
   }
 
   // newly incoming states
-  std::set<unsigned> reach_diff = kofola::get_set_difference(glob_reached, succs);
+  state_bitset reach_diff = kofola::get_set_difference(glob_reached, succs);
   DEBUG_PRINT_LN("newly incoming states: " + std::to_string(reach_diff));
 
   // std::cout << "After computation of nondet inside " << i << " size = " <<
@@ -468,19 +459,43 @@ mstate_col_set complement_safra::get_succ_active(
 
   // now compute the colour
   unsigned colour = determine_color(next);
-  std::shared_ptr<mstate> ms(new mstate_safra(next));
+  mstate_safra ms(next);
 
-  DEBUG_PRINT_LN("Done computing color for trans to " + ms->to_string() + ": "
+  DEBUG_PRINT_LN("Done computing color for trans to " + ms.to_string() + ": "
     + std::to_string(colour));
   if (static_cast<int>(colour) >= 0) {
-    this->min_colour_ = std::min(this->min_colour_, static_cast<int>(colour));
-    this->max_colour_ = std::max(this->max_colour_, static_cast<int>(colour));
+    std::lock_guard<std::mutex> lock(this->colour_mtx_);
+    if (this->acc_fixed_) {
+      // the acceptance condition has already been handed out
+      if (static_cast<int>(colour) > this->max_colour_) {
+        throw std::runtime_error("complement_safra: colour " +
+          std::to_string(colour) + " exceeds the fixed bound " +
+          std::to_string(this->max_colour_));
+      }
+    } else {
+      this->min_colour_ = std::min(this->min_colour_, static_cast<int>(colour));
+      this->max_colour_ = std::max(this->max_colour_, static_cast<int>(colour));
+    }
   }
 
-  return {{ms, {colour}}};
+  return {{std::move(ms), {colour}}};
 } // get_succ_active() }}}
 
 
+abstract_complement_alg::mstate complement_safra::load_mstate(
+  checkpoint_reader&         in) const
+{ // {{{
+  safra_tree st;
+  for (uint64_t num_labels = in.read_uint(); num_labels > 0; --num_labels) {
+    const unsigned state = in.read_uint();
+    st.labels_.emplace_back(state, in.read_int());
+  }
+  st.braces_ = in.read_int_vector();
+
+  return mstate_safra(st);
+} // load_mstate() }}}
+
+
 spot::acc_cond complement_safra::get_acc_cond() const
 { // {{{
   if (this->max_colour_ < 0) { // no colour was generated
@@ -523,5 +538,41 @@ unsigned complement_safra::get_min_colour() const
   return this->min_colour_;
 }
 
+void complement_safra::fix_acc_cond()
+{ // {{{
+  // determine_color() emits 2*b (red) or 2*b + 1 (green) for some brace b of
+  // the successor tree, so every colour is smaller than twice the number of
+  // its braces.  A tree returned by determine_color() keeps only braces that
+  // label some state directly, hence it has at most n braces (n = number of
+  // states).  get_succ_active() adds to these at most one new brace per
+  // outgoing edge of the labelled states (each edge is visited at most once;
+  // a brace whose state later gets a smaller nesting pattern is not removed)
+  // and one per newly incoming state.  This gives at most 2n + |E| braces.
+  // The maximum colour needs to be even (it is also used for transitions
+  // without any colour).  The bound is checked in get_succ_active().
+  const unsigned max_braces = 2 * this->info_.aut_->num_states() +
+    this->info_.aut_->num_edges();
+  std::lock_guard<std::mutex> lock(this->colour_mtx_);
+  this->min_colour_ = 0;
+  this->max_colour_ = 2 * max_braces;
+  this->acc_fixed_ = true;
+} // fix_acc_cond() }}}
+
+void complement_safra::save_state(checkpoint_writer& out) const
+{ // {{{
+  std::lock_guard<std::mutex> lock(this->colour_mtx_);
+  out.write_int(this->min_colour_);
+  out.write_int(this->max_colour_);
+  out.write_bool(this->acc_fixed_);
+} // save_state() }}}
+
+void complement_safra::load_state(checkpoint_reader& in)
+{ // {{{
+  std::lock_guard<std::mutex> lock(this->colour_mtx_);
+  this->min_colour_ = in.read_int();
+  this->max_colour_ = in.read_int();
+  this->acc_fixed_ = in.read_bool();
+} // load_state() }}}
+
 complement_safra::~complement_safra()
 { }
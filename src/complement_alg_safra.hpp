@@ -9,6 +9,8 @@
 
 #include "abstract_complement_alg.hpp"
 
+#include <mutex>
+
 namespace kofola { // {{{
 
 /// implementation of determinization-based complementation algorithm for
@@ -19,9 +21,12 @@ class complement_safra : public abstract_complement_alg
 private:// DATA MEMBERS
 
   // to keep track of minimum/maximum colours (mutable to be usable in const
-  // methods)
+  // methods; successors can be computed by several threads at once)
   mutable int min_colour_ = INT_MAX;
   mutable int max_colour_ = -1;
+  mutable std::mutex colour_mtx_;
+  /// set if the range of colours was fixed by fix_acc_cond()
+  bool acc_fixed_ = false;
 
 public: // METHODS
 
@@ -31,16 +36,22 @@ public: // METHODS
   virtual mstate_set get_init() const override;
 
   virtual mstate_col_set get_succ_track(
-    const std::set<unsigned>&  glob_reached,
-    const mstate*              src,
-    const bdd&                 symbol) const override;
+    const state_bitset&        glob_reached,
+    const mstate&              src,
+    unsigned                   symbol) const override;
 
-  virtual mstate_set lift_track_to_active(const mstate* src) const override;
+  virtual mstate_set lift_track_to_active(const mstate& src) const override;
 
   virtual mstate_col_set get_succ_active(
-    const std::set<unsigned>&  glob_reached,
-    const mstate*              src,
-    const bdd&                 symbol) const override;
+    const state_bitset&        glob_reached,
+    const mstate&              src,
+    unsigned                   symbol) const override;
+
+  virtual mstate load_mstate(checkpoint_reader& in) const override;
+
+  /// the successors depend on all reached states
+  virtual state_bitset restrict_reached(const state_bitset& glob_reached) const override
+  { return glob_reached; }
 
   virtual bool use_round_robin() const override { return false; }
 
@@ -50,6 +61,14 @@ public: // METHODS
 
   virtual unsigned get_min_colour() const override;
 
+  /// uses a conservative range of colours given by the number of states
+  virtual void fix_acc_cond() override;
+
+  /// the range of colours seen so far is a part of a checkpoint
+  virtual void save_state(checkpoint_writer& out) const override;
+
+  virtual void load_state(checkpoint_reader& in) override;
+
   virtual ~complement_safra() override;
 }; // complement_safra }}}
 } // namespace kofola }}}
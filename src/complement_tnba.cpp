@@ -18,7 +18,12 @@
 #include "kofola.hpp"
 #include "simulation.hpp"
 #include "types.hpp"
+#include "checkpoint.hpp"
 #include "decomposer.hpp"
+#include "intern_table.hpp"
+#include "succ_cache.hpp"
+#include "work_stealing.hpp"
+#include "stats.hpp"
 
 #include "abstract_complement_alg.hpp"
 #include "complement_alg_mh.hpp"
@@ -26,11 +31,15 @@
 #include "complement_alg_safra.hpp"
 #include "complement_alg_rank.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <map>
+#include <mutex>
 #include <set>
 #include <stack>
 #include <queue>
+#include <unordered_map>
 
 #include <spot/misc/hashfunc.hh>
 #include <spot/twaalgos/dot.hh>
@@ -50,6 +59,17 @@
 #include <spot/twaalgos/hoa.hh>
 #include <spot/misc/version.hh>
 #include <spot/twa/acc.hh>
+#include <spot/misc/minato.hh>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Complementation of Buchi automara based on SCC decomposition
 // We classify three types of SCCs in the input NBA:
@@ -59,58 +79,70 @@
 
 namespace cola
 {
-  bool all_trans_acc(
-    const spot::const_twa_graph_ptr&  aut,
-    unsigned                          current_state,
-    unsigned                          scc,
-    const spot::scc_info&             si)
+  // Saturation: if all transitions leaving a state q inside its SCC are
+  // accepting, the transitions entering q inside the SCC can be made accepting
+  // as well.  This may make other states saturated, so a worklist of saturated
+  // states is processed, where every state counts its non-accepting
+  // transitions inside its SCC.  Each state is processed once and each
+  // transition is made accepting at most once.
+  spot::twa_graph_ptr
+  saturation(const spot::const_twa_graph_ptr& aut, const spot::scc_info& si)
   {
-    auto current_scc = si.scc_of(current_state);
-
-    for (auto &t : aut->out(current_state))
+    spot::twa_graph_ptr aut_new = spot::make_twa_graph(aut, spot::twa::prop_set::all());
+    const unsigned num_states = aut_new->num_states();
+
+    // transitions inside SCCs entering every state (compressed rows: those
+    // entering q are pred_edges[pred_begin[q] .. pred_begin[q+1]-1]) and the
+    // number of non-accepting ones leaving every state
+    std::vector<unsigned> pred_begin(num_states + 1, 0);
+    std::vector<unsigned> num_rejecting(num_states, 0);
+    for (auto &t : aut_new->edges())
     {
-      if (si.scc_of(t.dst) == current_scc)
+      if (si.scc_of(t.src) == si.scc_of(t.dst))
       {
+        ++pred_begin[t.dst + 1];
         if (not t.acc)
-          return false;
+          ++num_rejecting[t.src];
       }
     }
+    for (unsigned q = 0; q < num_states; q++)
+      pred_begin[q + 1] += pred_begin[q];
 
-    return true;
-  }
+    std::vector<unsigned> pred_edges(pred_begin[num_states]);
+    std::vector<unsigned> pos(pred_begin.begin(), pred_begin.end() - 1);
+    for (auto &t : aut_new->edges())
+    {
+      if (si.scc_of(t.src) == si.scc_of(t.dst))
+        pred_edges[pos[t.dst]++] = aut_new->edge_number(t);
+    }
 
-  spot::twa_graph_ptr
-  saturation(const spot::const_twa_graph_ptr& aut, const spot::scc_info& si)
-  {
-    spot::twa_graph_ptr aut_new = spot::make_twa_graph(aut, spot::twa::prop_set::all());
-    bool change;
+    // states of SCCs (unreachable states are not in any)
+    std::vector<unsigned> worklist;
     for (unsigned i = 0; i < si.scc_count(); i++)
     {
-      do
+      for (auto state : si.states_of(i))
+      {
+        if (num_rejecting[state] == 0)
+          worklist.push_back(state);
+      }
+    }
+
+    while (!worklist.empty())
+    {
+      unsigned state = worklist.back();
+      worklist.pop_back();
+      for (unsigned i = pred_begin[state]; i < pred_begin[state + 1]; i++)
       {
-        change = false;
-        for (auto state : si.states_of(i))
+        auto &t = aut_new->edge_storage(pred_edges[i]);
+        if (not t.acc)
         {
-          if (all_trans_acc(aut_new, state, i, si))
-          {
-            for (auto s : si.states_of(i))
-            {
-              for (auto &t : aut_new->out(s))
-              {
-                if (t.dst == state)
-                {
-                  if (not t.acc)
-                  {
-                    t.acc = spot::acc_cond::mark_t{0};
-                    change = true;
-                  }
-                }
-              }
-            }
-          }
+          t.acc = spot::acc_cond::mark_t{0};
+          if (--num_rejecting[t.src] == 0)
+            worklist.push_back(t.src);
         }
-      } while (change);
+      }
     }
+
     return aut_new;
   }
 
@@ -125,8 +157,10 @@ namespace cola
     // Direct simulation on source automaton.
     kofola::Simulation dir_sim_;
 
-    // vector of reachable states for every state
-    kofola::ReachableVector reachable_vector_;
+    // Pairs of the direct simulation used for pruning reached states: the
+    // bigger state is in an SCC that cannot be reached from the SCC of the
+    // smaller one.
+    kofola::Simulation prune_sim_;
 
     // SCCs information of the source automaton.
     spot::scc_info &si_;
@@ -137,12 +171,6 @@ namespace cola
     // Number of states in the input automaton.
     unsigned nb_states_;
 
-    // state_simulator
-    state_simulator simulator_;
-
-    // delayed simulation
-    delayed_simulation delayed_simulator_;
-
     // The parity automata being built.
     spot::twa_graph_ptr res_;
 
@@ -319,14 +347,15 @@ namespace cola
           support_(nb_states_),
           compat_(nb_states_),
           is_accepting_(aut->num_states(), false),
-          simulator_(aut, si, implications, om.get(USE_SIMULATION) > 0),
-          delayed_simulator_(aut, om),
           show_names_(om.get(VERBOSE_LEVEL) >= 1)
     {
 
+      // the simulation is not used by the construction, it is computed only
+      // to be printed
       if (om.get(VERBOSE_LEVEL) >= 2)
       {
-        simulator_.output_simulation();
+        state_simulator simulator(aut, si, implications, om.get(USE_SIMULATION) > 0);
+        simulator.output_simulation();
       }
       res_ = spot::make_twa_graph(aut->get_dict());
       res_->copy_ap_of(aut);
@@ -382,6 +411,19 @@ namespace cola
       // std::cerr << "IWA: " << weaksccs_.size() << ", DET: " << acc_detsccs_.size() << ", NAC: " << acc_nondetsccs_.size() << std::endl;
     }
 
+    ~tnba_complement()
+    { // {{{
+      // the spool is left open if the construction was aborted
+      if (nullptr != this->hoa_spool_) { std::fclose(this->hoa_spool_); }
+    } // ~tnba_complement() }}}
+
+    /// makes run_new() write the result to 'os' in HOA as it is being
+    /// explored (run_new() then returns nullptr)
+    void set_hoa_stream(std::ostream* os)
+    {
+      this->hoa_stream_ = os;
+    }
+
     unsigned
     get_num_states()
     {
@@ -399,6 +441,7 @@ namespace cola
       // compute simulation
       std::vector<bdd> implications;
       this->aut_ = spot::simulation(this->aut_, &implications, -1);
+      this->dir_sim_ = kofola::Simulation(implications.size());
 
       // get vector of simulated states
       std::vector<std::vector<char>> implies(
@@ -418,7 +461,7 @@ namespace cola
             // j simulates i and j cannot reach i
             bool i_implies_j = bdd_implies(implications[i], implications[j]);
             if (i_implies_j) {
-              dir_sim_.push_back({i, j});
+              dir_sim_.add(i, j);
             }
           }
         }
@@ -457,60 +500,6 @@ namespace cola
     //   }
     // }
 
-    std::set<int> reachable_vertices(std::vector<std::vector<int>> list, std::set<int> from)
-    {
-      std::set<int> all(from);
-      std::stack<int> stack;
-      int item;
-      for (int it : all)
-        stack.push(it);
-
-      while (stack.size() > 0)
-      {
-        item = stack.top();
-        stack.pop();
-        for (int dst : list[item])
-        {
-          if (all.find(dst) == all.end())
-          {
-            stack.push(dst);
-            all.insert(dst);
-          }
-        }
-      }
-      return all;
-    }
-
-    std::vector<std::set<int>> get_reachable_vector()
-    {
-      std::vector<std::set<int>> reachable_vector;
-
-      std::vector<std::set<int>> list_set(aut_->num_states());
-      std::vector<std::vector<int>> list_vector(aut_->num_states());
-
-      for (unsigned s = 0; s < aut_->num_states(); s++)
-      {
-        reachable_vector.push_back(std::set<int>());
-        list_set[s] = std::set<int>();
-
-        // iterate over all transitions from s
-        for (const auto &t : aut_->out(s))
-        {
-          list_set[s].insert(t.dst);
-        }
-
-        list_vector[s] = std::vector<int>(list_set[s].begin(), list_set[s].end());
-      }
-
-      for (int s = 0; s < aut_->num_states(); s++)
-      {
-        std::set<int> tmp({s});
-        reachable_vector[s] = reachable_vertices(list_vector, tmp);
-      }
-
-      return reachable_vector;
-    }
-
     // void get_initial_state(complement_mstate &init_state, int &active_index, unsigned &orig_init, std::vector<std::vector<unsigned>> &iw_sccs, std::vector<std::pair<std::vector<unsigned>, std::vector<unsigned>>> &acc_detsccs, std::vector<rank_state> &na_sccs)
     // {
     //   // weak SCCs
@@ -1210,131 +1199,54 @@ namespace cola
     using abs_cmpl_alg_p = std::unique_ptr<kofola::abstract_complement_alg>;
     using vec_algorithms = std::vector<abs_cmpl_alg_p>;
 
-    using abs_cmpl_ms_p = std::shared_ptr<kofola::abstract_complement_alg::mstate>;
-    using vec_macrostates = std::vector<abs_cmpl_ms_p>;
-
-    /// the uberstate - combination of all partial macrostates
+    using mstate = kofola::abstract_complement_alg::mstate;
+
+    /// table of partial macrostates of one partition
+    using mstate_table = kofola::concurrent_intern_table<mstate,
+      kofola::abstract_complement_alg::mstate_hash>;
+    /// table of sets of reached states
+    using reach_set_table = kofola::concurrent_intern_table<kofola::state_bitset,
+      kofola::state_bitset_hash>;
+
+    /// the uberstate - combination of all partial macrostates; the uberstate
+    /// is a view of a flat tuple of numbers
+    ///
+    ///   (reached set, active SCC, partial macrostate 0, ..., partial macrostate k-1)
+    ///
+    /// stored in 'uberstates_', where the reached set and the partial
+    /// macrostates are given by their numbers in 'reach_sets_' and
+    /// 'part_macrostates_'
     class uberstate
     { // {{{
+    public:  // CONSTANTS
+
+      /// positions of the components in the tuple
+      static const size_t REACH_SET_POS = 0;
+      static const size_t ACTIVE_SCC_POS = 1;
+      static const size_t PART_MACROSTATES_POS = 2;
+
     private:  // DATA MEMBERS
 
-      /// all reached states
-      std::set<unsigned> reached_states_;
-      /// vector of partial macrostates
-      vec_macrostates part_macrostates_;
-      /// index of the active component for round robin
-      int active_scc_;
+      /// the tuple (owned by the table of uberstates)
+      const unsigned* tuple_;
 
     public:  // METHODS
 
       /// constructor
-      uberstate(const std::set<unsigned>& reached_states,
-                const vec_macrostates& part_macrostates,
-                int active_scc) :
-        reached_states_(reached_states),
-        part_macrostates_(part_macrostates),
-        active_scc_(active_scc)
+      explicit uberstate(const unsigned* tuple) : tuple_(tuple)
       { }
 
-      /// move constructor
-      uberstate(uberstate&& us) = default;
-
-      /// deleted copy constructor and assignment operator
-      uberstate(const uberstate& us) :
-        reached_states_(us.reached_states_),
-        part_macrostates_(us.part_macrostates_),
-        active_scc_(us.active_scc_)
-      { }
-
-      uberstate& operator=(const uberstate& us) = delete;
-
-      /// converts to string
-      std::string to_string() const
-      { // {{{
-        std::string result;
-        result += "<" + std::to_string(this->reached_states_);
-        result += " |" + std::to_string(this->active_scc_) + "| ";
+      /// returns the number of the set of all reached states
+      unsigned get_reach_set_id() const
+      { return this->tuple_[REACH_SET_POS]; }
 
-        for (size_t i = 0; i < this->part_macrostates_.size(); ++i) {
-          result += "c" + std::to_string(i) + ": " +
-            this->part_macrostates_[i]->to_string();
-          if (this->part_macrostates_.size() != i + 1) {
-            result += ", ";
-          }
-        }
-
-        result += ">";
-        return result;
-      } // to_string() }}}
-
-      /// output stream operator
-      friend std::ostream& operator<<(std::ostream& os, const uberstate& us)
-      {
-        os << us.to_string();
-        return os;
-      }
-
-      /// returns the set of all reached states
-      const std::set<unsigned>& get_reach_set() const
-      { return this->reached_states_; }
-
-      /// returns the partial macrostates
-      const vec_macrostates& get_part_macrostates() const
-      { return this->part_macrostates_; }
+      /// returns the number of the i-th partial macrostate
+      unsigned get_part_macrostate_id(size_t i) const
+      { return this->tuple_[PART_MACROSTATES_POS + i]; }
 
       /// returns the index of the active SCC (INACTIVE_SCC if no active)
-      const int get_active_scc() const
-      { return this->active_scc_; }
-
-      /// total ordering operator to allow use in std::set and std::map
-      bool operator<(const uberstate& rhs) const
-      { // {{{
-        assert(this->part_macrostates_.size() == rhs.part_macrostates_.size());
-
-        // let's start by comparing active SCC indices
-        if (this->active_scc_ != rhs.active_scc_) {
-          return this->active_scc_ < rhs.active_scc_;
-        }
-
-        // continue by comparing reached_states_
-        // FIXME: inefficient - in C++20, we would use the flying saucer
-        // operator <=>
-        if (this->reached_states_ != rhs.reached_states_) {
-          return this->reached_states_ < rhs.reached_states_;
-        }
-
-        // then, compare the partial macrostates lexicographically
-        const size_t length = this->part_macrostates_.size();
-        for (size_t i = 0; i < length; ++i) {
-          if (*(this->part_macrostates_[i]) != *(rhs.part_macrostates_[i])) {
-            return *(this->part_macrostates_[i]) < *(rhs.part_macrostates_[i]);
-          }
-        }
-
-        // they are equal
-        return false;
-      } // operator< }}}
-
-      bool operator==(const uberstate& rhs) const
-      { // {{{
-        assert(this->part_macrostates_.size() == rhs.part_macrostates_.size());
-
-        if (this->active_scc_ != rhs.active_scc_ ||
-            this->reached_states_ != rhs.reached_states_) {
-          return false;
-        }
-
-        // then, compare the partial macrostates
-        const size_t length = this->part_macrostates_.size();
-        for (size_t i = 0; i < length; ++i) {
-          if (*(this->part_macrostates_[i]) != *(rhs.part_macrostates_[i])) {
-            return false;
-          }
-        }
-
-        return true;
-      } // operator== }}}
-
+      int get_active_scc() const
+      { return static_cast<int>(this->tuple_[ACTIVE_SCC_POS]); }
     }; // uberstate }}}
 
     /// target of a transition (including colours)
@@ -1347,28 +1259,75 @@ namespace cola
     /// vec_state_col where colours are tagged by their partition
     using vec_state_taggedcol = std::vector<state_taggedcol>;
 
-    /// functor for comparison of uberstate pointers
-    struct uberstate_ptr_less_ftor
-    {
-      bool operator()(const uberstate* lhs, const uberstate* rhs) const
-      {
-        assert(lhs && rhs);
-        return *lhs < *rhs;
-      }
-    };
-
-
-    // Here we have a bidirectional map between uberstates and state
-    // identifiers (unsigned).  The uberstates are physically stored only at
-    // 'num_to_uberstate_map_', the reason being that they contain vectors of
-    // unique_ptr (no copy is therefore allowed).
-
-    /// maps uberstates to state numbers
-    std::map<const uberstate*, unsigned, uberstate_ptr_less_ftor> uberstate_to_num_map_;
-    /// maps state numbers to uberstates
-    std::vector<std::shared_ptr<uberstate>> num_to_uberstate_map_;
-    /// counter of states (to be assigned to uberstates) - 0 is reserved for sink
-    unsigned cnt_state_ = 0;
+    /// all outgoing transitions of an uberstate (grouped by symbols)
+    using uberstate_post = std::vector<std::pair<bdd, vec_state_taggedcol>>;
+
+    // Uberstates are stored as tuples in 'uberstates_', the number of a tuple
+    // is the state number of the uberstate.  Reached sets and partial
+    // macrostates are stored only once in 'reach_sets_' and
+    // 'part_macrostates_' (one table for every partition) and referred to by
+    // their numbers.  The sink state occupies a tuple that is not indexed.
+    // All the tables are thread-safe, so that uberstates can be explored by
+    // several threads.  The numbers are assigned in the order of discovery
+    // (and not consecutively when using more threads), so the final
+    // automaton is renumbered canonically (see renumber_canonically()).
+
+    /// table of uberstates
+    kofola::concurrent_tuple_table uberstates_;
+    /// table of sets of reached states
+    reach_set_table reach_sets_;
+    /// tables of partial macrostates (one for every partition)
+    std::vector<std::unique_ptr<mstate_table>> part_macrostates_;
+    /// caches of successors of partial macrostates (one for every partition)
+    std::vector<std::unique_ptr<kofola::succ_cache>> succ_caches_;
+
+    /// counters for checking the budgets (see check_budgets())
+    std::chrono::steady_clock::time_point start_time_;
+    std::atomic<size_t> num_discovered_{0};
+    std::atomic<size_t> num_expanded_{0};
+    /// counters reported in the statistics (see publish_stats())
+    std::atomic<size_t> num_letters_{0};
+    std::atomic<size_t> num_transitions_{0};
+    std::atomic<size_t> num_cartesian_tuples_{0};
+    std::atomic<size_t> max_cartesian_size_{0};
+    /// numbers of calls of get_succ_*() of the algorithm of every partition
+    std::unique_ptr<std::atomic<size_t>[]> num_part_succ_calls_;
+    /// time and memory are checked after every BUDGET_CHECK_PERIOD expansions
+    static const size_t BUDGET_CHECK_PERIOD = 256;
+    /// number of the sink state (UINT_MAX if not created)
+    unsigned sink_state_ = UINT_MAX;
+    std::once_flag sink_flag_;
+
+    /// BuDDy is not thread-safe: every operation with BDDs (including
+    /// copying and destroying of bdd objects) must hold this lock
+    std::mutex bdd_mutex_;
+
+    /// number of shards of the uberstate table for parallel exploration
+    static const size_t NUM_SHARDS = 64;
+
+    /// stream for writing the result in HOA during the exploration (nullptr
+    /// if the result is built in memory)
+    std::ostream* hoa_stream_ = nullptr;
+    /// temporary file with the streamed body of the result
+    std::FILE* hoa_spool_ = nullptr;
+    /// numbers of states in the streamed result
+    std::unordered_map<unsigned, unsigned> stream_num_;
+    /// maps BDD variables to indices of atomic propositions
+    std::map<int, unsigned> var_to_ap_;
+
+    // partitions of the input automaton, the information for complementation
+    // (which refers to them), and the algorithms for the partitions; set up
+    // by prepare()
+    kofola::PartitionToTypeMap part_to_type_map_;
+    kofola::StateToPartitionMap st_part_map_;
+    kofola::PartitionToSCCMap part_to_scc_map_;
+    std::unique_ptr<kofola::scc_reachability> reach_;
+    std::unique_ptr<kofola::cmpl_info> info_;
+    vec_algorithms alg_vec_;
+    /// the alphabet of the input automaton split into letters
+    std::unique_ptr<kofola::minterm_alphabet> alphabet_;
+    /// successors of states of the input automaton over letters
+    std::unique_ptr<kofola::post_image_table> post_table_;
 
     // reserved colours
     // static const unsigned SINK_COLOUR = 0;
@@ -1379,103 +1338,140 @@ namespace cola
     /// index of active SCC if no SCC is active
     static const int INACTIVE_SCC = -1;
 
-    /// accessor into the uberstate table
-    unsigned uberstate_to_num(const uberstate& us) const
-    { // {{{
-      auto it = this->uberstate_to_num_map_.find(&us);
-      if (this->uberstate_to_num_map_.end() != it) {
-        return it->second;
-      } else {
-        assert(false);
-      }
-    } // uberstate_to_num() }}}
-
     /// translates state number to uberstate
-    const uberstate& num_to_uberstate(unsigned num) const
+    uberstate num_to_uberstate(unsigned num) const
     { // {{{
-      assert(num < this->num_to_uberstate_map_.size());
-      assert(this->num_to_uberstate_map_[num]);
-      return *this->num_to_uberstate_map_[num];
+      assert(this->uberstates_.contains(num));
+      return uberstate(this->uberstates_[num]);
     } // num_to_uberstate() }}}
 
-    /// inserts an uberstate (by moving) and returns its assigned number (if
-    /// not present), or just returns the number of an equal uberstate (if
-    /// present)
-    unsigned insert_uberstate(uberstate&& us)
+    /// returns the set of all reached states of an uberstate
+    const kofola::state_bitset& get_reach_set(const uberstate& us) const
+    { return this->reach_sets_[us.get_reach_set_id()]; }
+
+    /// returns the i-th partial macrostate of an uberstate
+    const mstate& get_part_macrostate(
+      const uberstate&  us,
+      size_t            i) const
+    { return (*this->part_macrostates_[i])[us.get_part_macrostate_id(i)]; }
+
+    /// converts an uberstate to string
+    std::string uberstate_to_string(const uberstate& us) const
     { // {{{
-      DEBUG_PRINT_LN("inserting uberstate " + us.to_string());
-      auto it = this->uberstate_to_num_map_.find(&us);
-      if (this->uberstate_to_num_map_.end() == it) { // not found
-        DEBUG_PRINT_LN("not found!");
-        std::shared_ptr<uberstate> ptr(new uberstate(us));
-        this->num_to_uberstate_map_.push_back(ptr);
-        assert(this->num_to_uberstate_map_.size() == this->cnt_state_ + 1);  // invariant
-        DEBUG_PRINT_LN("inserting at position " + std::to_string(this->cnt_state_));
-        const uberstate* us_new = this->num_to_uberstate_map_[this->cnt_state_].get();
-        assert(*ptr == *us_new);
-        if (this->cnt_state_ == 192) {
-          DEBUG_PRINT_LN("uberstate_to_num_map_: ")
-          for (const auto& elem : this->uberstate_to_num_map_) {
-            DEBUG_PRINT_LN(std::to_string(*elem.first) + " -> " + std::to_string(elem.second));
-          }
+      std::string result;
+      result += "<" + std::to_string(this->get_reach_set(us));
+      result += " |" + std::to_string(us.get_active_scc()) + "| ";
+
+      const size_t length = this->part_macrostates_.size();
+      for (size_t i = 0; i < length; ++i) {
+        result += "c" + std::to_string(i) + ": " +
+          std::to_string(this->get_part_macrostate(us, i));
+        if (length != i + 1) {
+          result += ", ";
         }
-        auto jt_bool_pair = this->uberstate_to_num_map_.insert({us_new, this->cnt_state_});
-        if (!jt_bool_pair.second) {
-          DEBUG_PRINT_LN("jt_bool_pair: " + std::to_string(*jt_bool_pair.first->first));
-          DEBUG_PRINT_LN("previous pos: " + std::to_string(jt_bool_pair.first->second));
-          assert(false);
-          assert(jt_bool_pair.second);    // insertion happened
-        }
-        ++this->cnt_state_;
-        DEBUG_PRINT_LN("inserted as " + std::to_string(jt_bool_pair.first->second));
-        return jt_bool_pair.first->second;
+      }
+
+      result += ">";
+      return result;
+    } // uberstate_to_string() }}}
+
+    /// returns the number of a set of reached states (inserts it if needed)
+    unsigned intern_reach_set(const kofola::state_bitset& reach_set)
+    { return this->reach_sets_.insert(reach_set).first; }
+
+    /// returns the number of a partial macrostate of the i-th partition
+    /// (inserts it if needed)
+    unsigned intern_part_macrostate(size_t i, mstate ms)
+    { return this->part_macrostates_[i]->insert(std::move(ms)).first; }
+
+    /// inserts an uberstate given as a tuple and returns its assigned number
+    /// (if not present), or just returns the number of an equal uberstate (if
+    /// present); the second component says whether the uberstate is new
+    std::pair<unsigned, bool> insert_uberstate(const std::vector<unsigned>& tuple)
+    { // {{{
+      assert(tuple.size() == this->uberstates_.width());
+      auto id_bool_pair = this->uberstates_.insert(tuple.data());
+      if (id_bool_pair.second) { // not found
+        DEBUG_PRINT_LN("inserted uberstate " +
+          this->uberstate_to_string(num_to_uberstate(id_bool_pair.first)) +
+          " at position " + std::to_string(id_bool_pair.first));
       } else { // found
-        DEBUG_PRINT_LN("found as " + std::to_string(it->second));
-        return it->second;
+        DEBUG_PRINT_LN("found as " + std::to_string(id_bool_pair.first));
       }
+
+      return id_bool_pair;
     } // insert_uberstate() }}}
 
+    /// returns the number of the sink state (creates it if needed)
+    unsigned get_sink()
+    { // {{{
+      std::call_once(this->sink_flag_, [this]{
+          std::vector<unsigned> placeholder(this->uberstates_.width(), UINT_MAX);
+          this->sink_state_ = this->uberstates_.append(placeholder.data());
+          DEBUG_PRINT_LN("creating a sink state: " + std::to_string(this->sink_state_));
+        });
+      return this->sink_state_;
+    } // get_sink() }}}
+
+    /// total ordering of uberstates given by their contents (unlike their
+    /// numbers, this does not depend on the order of exploration)
+    bool uberstate_content_lt(unsigned lhs, unsigned rhs) const
+    { // {{{
+      if (lhs == rhs) { return false; }
+      if (this->sink_state_ == lhs || this->sink_state_ == rhs) {
+        return this->sink_state_ == lhs;    // sink goes first
+      }
+
+      const uberstate lhs_us = num_to_uberstate(lhs);
+      const uberstate rhs_us = num_to_uberstate(rhs);
+      if (lhs_us.get_active_scc() != rhs_us.get_active_scc()) {
+        return lhs_us.get_active_scc() < rhs_us.get_active_scc();
+      }
+
+      if (lhs_us.get_reach_set_id() != rhs_us.get_reach_set_id()) {
+        return this->get_reach_set(lhs_us) < this->get_reach_set(rhs_us);
+      }
+
+      for (size_t i = 0; i < this->part_macrostates_.size(); ++i) {
+        if (lhs_us.get_part_macrostate_id(i) != rhs_us.get_part_macrostate_id(i)) {
+          return this->get_part_macrostate(lhs_us, i) <
+            this->get_part_macrostate(rhs_us, i);
+        }
+      }
+
+      assert(false);    // different uberstates cannot have equal contents
+      return false;
+    } // uberstate_content_lt() }}}
 
-    /// computes the Cartesian product of a vector of sets (no repetitions
-    /// assumed in the inputs)
-    template<class A>
-    std::vector<std::vector<A>> compute_cartesian_prod(
-      const std::vector<std::vector<A>> vec_of_sets)
+
+    /// enumerates the Cartesian product of a vector of sets one tuple at a
+    /// time (like an odometer); 'func' is called with the vector of indices
+    /// into the sets (the same buffer is reused for all tuples)
+    template <class A, class F>
+    static void for_each_cartesian_prod(
+      const std::vector<std::vector<A>>&  vec_of_sets,
+      F                                   func)
     { // {{{
       const size_t length = vec_of_sets.size();
-      std::vector<std::vector<A>> result;
+      for (const auto& set : vec_of_sets) {
+        if (set.empty()) { return; }
+      }
 
       // this vector will iterate over all possible tuples of indices
       std::vector<size_t> indices(length, 0);
-
       while (true) {
-        std::vector<A> vec;
-        for (size_t i = 0; i < length; ++i) {
-          assert(indices[i] < vec_of_sets[i].size());
-          vec.push_back(vec_of_sets[i][indices[i]]);
-        }
-
-        assert(vec.size() == length);
-        result.push_back(std::move(vec));
+        func(static_cast<const std::vector<size_t>&>(indices));
 
         // generate the next vector of indices, if possible
-        bool generated = false;
-        for (size_t j = 0; j < length; ++j) {
-          ++(indices[j]);
-          if (indices[j] < vec_of_sets[j].size()) { // indices is set
-            generated = true;
-            break;
-          }
-          else { // we need to move into the next index
-            indices[j] = 0;
-          }
+        size_t j = 0;
+        for (; j < length; ++j) {
+          if (++(indices[j]) < vec_of_sets[j].size()) { break; }
+          indices[j] = 0;     // we need to move into the next index
         }
 
-        if (!generated) { break; }
+        if (j == length) { break; }
       }
-
-      return result;
-    } // compute_cartesian_prod() }}}
+    } // for_each_cartesian_prod() }}}
 
     /// removes duplicit values (warning: can change order!)
     template <class T>
@@ -1520,117 +1516,125 @@ namespace cola
     } // create_part_to_scc_map() }}}
 
 
-    static kofola::SCCToSCCSetMap create_scc_to_pred_sccs_map(
-      const spot::scc_info&           si,
-      const kofola::ReachableVector&  reach_vec)
-    { // {{{
-      DEBUG_PRINT_LN("in create_scc_to_pred_sccs_map");
-      DEBUG_PRINT_LN("reach_vec = " + std::to_string(reach_vec));
-      for (unsigned state = 0; state < si.get_aut()->num_states(); ++state) {
-        DEBUG_PRINT_LN("SCC of state " + std::to_string(state) + " = " +
-            std::to_string(si.scc_of(state)));
-      }
-
-      kofola::SCCToSCCSetMap scc_to_pred_sccs_map;
-
-      for (size_t st = 0; st < reach_vec.size(); ++st) {
-        unsigned st_scc_index = si.scc_of(st);
-        if (static_cast<int>(st_scc_index) < 0) { // SCC unreachable
-          DEBUG_PRINT_LN("wrong scc");
-          continue;
-        }
-        for (unsigned dst : reach_vec[st_scc_index]) {
-          unsigned dst_scc_index = si.scc_of(dst);
-          auto it_bool_pair = scc_to_pred_sccs_map.insert(
-            {dst_scc_index, {st_scc_index}});
-          if (!it_bool_pair.second) { // if no insertion happened
-            it_bool_pair.first->second.insert(st_scc_index);
-          }
-        }
-      }
-
-      DEBUG_PRINT_LN("scc_to_pred_sccs_map: " + std::to_string(scc_to_pred_sccs_map));
-      return scc_to_pred_sccs_map;
-    } // create_scc_to_pred_sccs_map() }}}
-
+    /// successors of the partial macrostates of an uberstate over a symbol
+    /// (as computed by the algorithms, not yet combined into uberstates)
+    struct part_succs
+    {
+      /// all states reached over the symbol
+      kofola::state_bitset all_succ;
+      /// numbers of successors of all partial macrostates with colours (empty
+      /// if some partial macrostate has no successor)
+      std::vector<kofola::succ_cache::value> succs;
+    };
 
-    /// gets all successors of an uberstate wrt a vector of algorithms and a
-    /// symbol
-    vec_state_taggedcol get_succ_uberstates(
+    /// computes the successors of all partial macrostates of an uberstate
+    /// over a letter of 'alphabet_' (does not work with BDDs)
+    part_succs compute_part_succs(
       const vec_algorithms&  algos,
       const uberstate&       src,
-      const bdd&             symbol)
+      unsigned               symbol)
     { // {{{
-      DEBUG_PRINT_LN("Processing uberstate " + std::to_string(src) +
+      DEBUG_PRINT_LN("Processing uberstate " + this->uberstate_to_string(src) +
         " for symbol " + std::to_string(symbol));
-      using mstate = kofola::abstract_complement_alg::mstate;
-      using mstate_set = kofola::abstract_complement_alg::mstate_set;
-      using mstate_col = kofola::abstract_complement_alg::mstate_col;
-      using mstate_taggedcol = std::pair<std::shared_ptr<mstate>, std::set<std::pair<unsigned, unsigned>>>;
       using mstate_col_set = kofola::abstract_complement_alg::mstate_col_set;
-      using mstate_taggedcol_set = std::vector<mstate_taggedcol>;
 
-      assert(algos.size() == src.get_part_macrostates().size());
+      assert(algos.size() + uberstate::PART_MACROSTATES_POS == this->uberstates_.width());
       const int active_index = src.get_active_scc();
-      std::set<unsigned> all_succ = kofola::get_all_successors(
-        this->aut_, src.get_reach_set(), symbol);
+      part_succs result;
+      kofola::state_bitset& all_succ = result.all_succ;
+      all_succ = kofola::get_all_successors(
+        *this->post_table_, this->get_reach_set(src), symbol);
 
       DEBUG_PRINT_LN("all succ over " + std::to_string(symbol) + "= " + std::to_string(all_succ));
       if (this->decomp_options_.iw_sim ||
           this->decomp_options_.det_sim) { // if doing simulation reduction
                                            // TODO: distinguish iw_sim and det_sim
-        std::set<unsigned> pruned_succ = all_succ;
-
-        std::set<unsigned> to_remove;
-        for (const auto& pr : this->dir_sim_) {
-          unsigned smaller = pr.first;
-          unsigned bigger = pr.second;
-          if (smaller == bigger ||  // identity
-              !kofola::is_in(smaller, all_succ) ||
-              !kofola::is_in(bigger, all_succ)
-            ) { // the pair is irrelevant
-            continue;
-          }
+        all_succ = this->prune_sim_.remove_dominated(all_succ);
+        DEBUG_PRINT_LN("pruned succ = " + std::to_string(all_succ));
+      }
 
-          // if (kofola::is_in(bigger, this->reachable_vector_[smaller]) &&
-          //     !kofola::is_in(smaller, this->reachable_vector_[bigger])) {
-          if (this->si_.scc_of(smaller) > this->si_.scc_of(bigger)) {
-            // we assume that if SCC A is reachable from SCC B, then #(A) < #(B) (this is how spot seems to order SCCs)
-            DEBUG_PRINT_LN("removing " + std::to_string(smaller) +
-              " because of " + std::to_string(bigger));
-            pruned_succ.erase(smaller);
+      // successors computed by the algorithms (i.e., not found in the caches)
+      // are interned and cached only if all partial macrostates have some, so
+      // that the tables do not fill with partial macrostates of no uberstate
+      std::vector<size_t> computed_parts;
+      std::vector<std::pair<kofola::succ_cache::key, mstate_col_set>> computed;
+      result.succs.resize(algos.size());
+      for (size_t i = 0; i < algos.size(); ++i) {
+        const mstate& ms = this->get_part_macrostate(src, i);
+        const bool active = (active_index == i || !algos[i]->use_round_robin());
+
+        // many uberstates share partial macrostates, so try the cache first
+        kofola::succ_cache::key key = {src.get_part_macrostate_id(i), symbol,
+          active, algos[i]->restrict_reached(all_succ)};
+        if (this->succ_caches_[i]->find(key, result.succs[i])) {
+          if (result.succs[i].empty()) { // one empty set of successor macrostates
+            result.succs.clear();
+            return result;
           }
+          continue;
         }
-        DEBUG_PRINT_LN("pruned succ = " + std::to_string(pruned_succ));
-        all_succ = pruned_succ;
-      }
 
-
-      const vec_macrostates& prev_part_macro = src.get_part_macrostates();
-      // this container collects all sets of pairs of macrostates and colours,
-      // later, we will turn it into the Cartesian product
-      std::vector<mstate_taggedcol_set> succ_part_macro_col;
-      for (size_t i = 0; i < algos.size(); ++i) {
-        const kofola::abstract_complement_alg::mstate* ms = prev_part_macro[i].get();
+        ++this->num_part_succ_calls_[i];
         mstate_col_set mcs;
-        if (active_index == i || !algos[i]->use_round_robin()) {
+        if (active) {
           mcs = algos[i]->get_succ_active(all_succ, ms, symbol);
         } else {
           mcs = algos[i]->get_succ_track(all_succ, ms, symbol);
         }
 
         if (mcs.empty()) { // one empty set of successor macrostates
-          return {};
+          this->succ_caches_[i]->insert(std::move(key), {});
+          result.succs.clear();
+          return result;
+        }
+
+        computed_parts.push_back(i);
+        computed.emplace_back(std::move(key), std::move(mcs));
+      }
+
+      for (size_t j = 0; j < computed_parts.size(); ++j) {
+        const size_t i = computed_parts[j];
+        kofola::succ_cache::value& ids = result.succs[i];
+        for (auto& ms_col : computed[j].second) {
+          ids.emplace_back(this->intern_part_macrostate(i, std::move(ms_col.first)),
+            std::move(ms_col.second));
         }
+        this->succ_caches_[i]->insert(std::move(computed[j].first), ids);
+      }
+
+      return result;
+    } // compute_part_succs() }}}
+
+    /// combines successors of partial macrostates into successor uberstates
+    /// (does not work with BDDs); numbers of newly discovered uberstates are
+    /// appended to 'new_states'
+    vec_state_taggedcol combine_part_succs(
+      const vec_algorithms&   algos,
+      const uberstate&        src,
+      const part_succs&       ps,
+      std::vector<unsigned>&  new_states)
+    { // {{{
+      using mstate_set = kofola::abstract_complement_alg::mstate_set;
+      // partial macrostates are represented by their numbers
+      using id_taggedcol = std::pair<unsigned, std::set<std::pair<unsigned, unsigned>>>;
+      using id_taggedcol_set = std::vector<id_taggedcol>;
+
+      if (ps.succs.empty()) { return {}; }
+      assert(algos.size() == ps.succs.size());
+      const int active_index = src.get_active_scc();
 
-        // tagged colours
-        mstate_taggedcol_set tagged_mcs;
-        for (const auto& mstate_col : mcs) {
+      // this container collects all sets of pairs of macrostates and colours,
+      // later, we will turn it into the Cartesian product
+      std::vector<id_taggedcol_set> succ_part_macro_col;
+      for (size_t i = 0; i < algos.size(); ++i) {
+        // interned macrostates with tagged colours
+        id_taggedcol_set tagged_mcs;
+        for (const auto& id_col : ps.succs[i]) {
           std::set<std::pair<unsigned, unsigned>> new_taggedcols;
-          for (const auto& col : mstate_col.second) {
+          for (const auto& col : id_col.second) {
             new_taggedcols.insert({i, col});
           }
-          tagged_mcs.push_back({mstate_col.first, new_taggedcols});
+          tagged_mcs.push_back({id_col.first, std::move(new_taggedcols)});
         }
 
         succ_part_macro_col.emplace_back(std::move(tagged_mcs));
@@ -1639,117 +1643,548 @@ namespace cola
       DEBUG_PRINT_LN("generated partial macrostates + colours: " +
         std::to_string(succ_part_macro_col));
 
-      // compute the Cartesian product of the partial macrostates (+ colours)
-      std::vector<std::vector<mstate_taggedcol>> cp =
-        compute_cartesian_prod(succ_part_macro_col);
+      size_t prod_size = 1;
+      for (const auto& tagged_mcs : succ_part_macro_col) { prod_size *= tagged_mcs.size(); }
+      this->num_cartesian_tuples_ += prod_size;
+      size_t max_size = this->max_cartesian_size_;
+      while (prod_size > max_size &&
+        !this->max_cartesian_size_.compare_exchange_weak(max_size, prod_size))
+      { }
 
-      // generate uberstates
-      vec_state_taggedcol result;
-      for (const auto& vec : cp) {
-        vec_macrostates vm;
+      // generate uberstates from the Cartesian product of the partial
+      // macrostates (+ colours), one at a time, dropping duplicate successors
+      std::vector<unsigned> tuple(this->uberstates_.width());
+      tuple[uberstate::REACH_SET_POS] = this->intern_reach_set(ps.all_succ);
+      unsigned* part_ids = tuple.data() + uberstate::PART_MACROSTATES_POS;
+      std::set<state_taggedcol> unique_succs;
+      for_each_cartesian_prod(succ_part_macro_col,
+        [&](const std::vector<size_t>& indices) {
         std::set<std::pair<unsigned, unsigned>> cols;
-        for (const auto& ms_col : vec) {
-          vm.push_back(ms_col.first);
-          cols.insert(ms_col.second.begin(), ms_col.second.end());
-        }
-
-        unsigned us_num = UINT_MAX;   // canary value
-        if (INACTIVE_SCC == active_index) { // no round robin
-          DEBUG_PRINT_LN("inserting")
-          us_num = insert_uberstate(uberstate(all_succ, vm, INACTIVE_SCC));
-          DEBUG_PRINT_LN("inserted")
-        } else { // round robin
-          if (vm[active_index]->is_active()) { // the same SCC active
-            us_num = insert_uberstate(uberstate(all_succ, vm, active_index));
-          } else { // another SCC active
+        for (size_t i = 0; i < indices.size(); ++i) {
+          const id_taggedcol& id_col = succ_part_macro_col[i][indices[i]];
+          part_ids[i] = id_col.first;
+          cols.insert(id_col.second.begin(), id_col.second.end());
+        }
+
+        int new_active = active_index;
+        if (INACTIVE_SCC != active_index) { // round robin
+          const mstate& active_ms =
+            (*this->part_macrostates_[active_index])[part_ids[active_index]];
+          if (!kofola::is_active(active_ms)) { // another SCC active
             int next_active = get_next_active_scc(algos, active_index);
             DEBUG_PRINT_LN("next active index: " + std::to_string(next_active));
             assert(INACTIVE_SCC != next_active);
 
             // now we need to lift the macrostate for next_active from track to active
-            mstate_set active_macros = algos[next_active]->lift_track_to_active(vm[next_active].get());
+            const mstate& track_ms =
+              (*this->part_macrostates_[next_active])[part_ids[next_active]];
+            mstate_set active_macros = algos[next_active]->lift_track_to_active(track_ms);
             assert(active_macros.size() == 1); // FIXME: this should be made proper
-            vm[next_active] = active_macros[0];
-            us_num = insert_uberstate(uberstate(all_succ, vm, next_active));
+            part_ids[next_active] =
+              this->intern_part_macrostate(next_active, std::move(active_macros[0]));
+            new_active = next_active;
           }
         }
-        result.emplace_back(us_num, std::move(cols));
-      }
 
-      DEBUG_PRINT_LN("computed successors: " + std::to_string(result));
+        tuple[uberstate::ACTIVE_SCC_POS] = static_cast<unsigned>(new_active);
+        auto id_bool_pair = this->insert_uberstate(tuple);
+        if (id_bool_pair.second) { new_states.push_back(id_bool_pair.first); }
+        unique_succs.emplace(id_bool_pair.first, std::move(cols));
+      });
 
-      remove_duplicit(result);
+      vec_state_taggedcol result(unique_succs.begin(), unique_succs.end());
+      DEBUG_PRINT_LN("computed successors: " + std::to_string(result));
 
       return result;
-    } // get_succ_uberstates() }}}
-
-    /// gets all initial uberstates wrt a vector of algorithms
-    std::vector<unsigned> get_initial_uberstates(const vec_algorithms& alg_vec)
+    } // combine_part_succs() }}}
+
+    /// computes the post of an uberstate and appends it to 'posts'; numbers
+    /// of newly discovered uberstates are appended to 'new_states'
+    void expand_uberstate(
+      const vec_algorithms&                              algos,
+      unsigned                                           us_num,
+      std::vector<std::pair<unsigned, uberstate_post>>&  posts,
+      std::vector<unsigned>&                             new_states)
     { // {{{
-      std::set<unsigned> initial_states = {aut_->get_init_state_number()};
-
-      int init_active = get_next_active_scc(alg_vec, INACTIVE_SCC);
-      DEBUG_PRINT_LN("initial active partition: " + std::to_string(init_active));
-
-      using mstate_set = kofola::abstract_complement_alg::mstate_set;
-      std::vector<mstate_set> vec_mstate_sets;
-      for (size_t i = 0; i < alg_vec.size(); ++i) { // get outputs of all procedures
-        mstate_set init_mstates = alg_vec[i]->get_init();
-        if (i == init_active || !alg_vec[i]->use_round_robin()) { // make the partial macrostate active
-          mstate_set new_mstates;
-          for (const auto& st : init_mstates) {
-            mstate_set lifted = alg_vec[i]->lift_track_to_active(st.get());
-            new_mstates.insert(new_mstates.end(), lifted.begin(), lifted.end());
-          }
-          remove_duplicit(new_mstates);
-          init_mstates = std::move(new_mstates);
+      const uberstate us = num_to_uberstate(us_num);
+      DEBUG_PRINT_LN("processing " + std::to_string(us_num) + ": " + this->uberstate_to_string(us));
+
+      // The successors are computed over the letters of 'alphabet_' without
+      // BuDDy (so the threads do not wait for each other).  Letters with the
+      // same successors are grouped, and only the labels of the groups are
+      // built as BDDs in the end (under the BDD lock).
+      const kofola::state_bitset& reach_set = this->get_reach_set(us);
+      std::vector<unsigned> enabled = this->alphabet_->get_enabled_letters(reach_set);
+      this->num_letters_ += enabled.size();
+
+      std::vector<std::vector<unsigned>> group_letters;
+      std::vector<vec_state_taggedcol> group_succs;
+      std::map<vec_state_taggedcol, size_t> succs_to_group;
+      for (unsigned letter : enabled) {
+        DEBUG_PRINT_LN("symbol: " + std::to_string(letter));
+
+        part_succs ps = this->compute_part_succs(algos, us, letter);
+        vec_state_taggedcol succs = this->combine_part_succs(algos, us, ps, new_states);
+        if (succs.empty()) { continue; }
+
+        auto it_bool_pair = succs_to_group.insert({succs, group_succs.size()});
+        if (it_bool_pair.second) { // new group
+          group_letters.push_back({letter});
+          group_succs.emplace_back(std::move(succs));
+        } else {
+          group_letters[it_bool_pair.first->second].push_back(letter);
         }
-        if (init_mstates.empty()) { return {};}   // one empty set terminates
-        vec_mstate_sets.emplace_back(std::move(init_mstates));
       }
 
-      DEBUG_PRINT_LN("obtained vector of sets of partial macrostates: " + std::to_string(vec_mstate_sets));
+      // letters not enabled in any reached state lead to the sink
+      std::vector<unsigned> disabled;
+      for (unsigned letter = 0, i = 0; letter < this->alphabet_->size(); ++letter) {
+        if (i < enabled.size() && enabled[i] == letter) { ++i; }
+        else { disabled.push_back(letter); }
+      }
+      const unsigned sink_state = disabled.empty()? UINT_MAX : this->get_sink();
 
-      // compute the cartesian product from the vector of sets of macrostates
-      std::vector<vec_macrostates> cp = compute_cartesian_prod(vec_mstate_sets);
+      size_t num_trans = disabled.empty()? 0 : 1;
+      for (const auto& succs : group_succs) { num_trans += succs.size(); }
+      this->num_transitions_ += num_trans;
 
-      DEBUG_PRINT_LN("initial macrostates: " + std::to_string(cp));
+      std::lock_guard<std::mutex> bdd_lock(this->bdd_mutex_);
+      uberstate_post post;
+      if (!disabled.empty()) {
+        vec_state_taggedcol succs = {{sink_state, {}}};
+        post.emplace_back(this->alphabet_->letters_to_bdd(disabled), std::move(succs));
+      }
+      for (size_t i = 0; i < group_succs.size(); ++i) {
+        post.emplace_back(this->alphabet_->letters_to_bdd(group_letters[i]),
+          std::move(group_succs[i]));
+      }
 
-      std::vector<unsigned> result;
-      for (const auto& vec : cp) {
-        unsigned us_num = insert_uberstate(uberstate(initial_states, vec, init_active));
-        result.push_back(us_num);
+      if (nullptr != this->hoa_spool_) { // streaming
+        this->spool_post(us_num, post);
+        post.clear();
+      } else {
+        posts.emplace_back(us_num, std::move(post));
+      }
+    } // expand_uberstate() }}}
+
+    /// renumbers the explored states canonically: in the breadth-first
+    /// order from the initial states, where successors over a symbol are
+    /// ordered by their contents; the result therefore does not depend on
+    /// the order of exploration (e.g., on the number of threads).
+    /// 'init_vec' is translated and 'canon_to_raw' maps new numbers to the
+    /// original ones.
+    std::map<unsigned, uberstate_post> renumber_canonically(
+      std::map<unsigned, uberstate_post>&  raw_states,
+      std::vector<unsigned>&               init_vec,
+      std::vector<unsigned>&               canon_to_raw)
+    { // {{{
+      auto us_lt = [this](unsigned lhs, unsigned rhs) {
+          return this->uberstate_content_lt(lhs, rhs);
+        };
+      auto taggedcol_lt = [this](const state_taggedcol& lhs, const state_taggedcol& rhs) {
+          if (lhs.first != rhs.first) {
+            return this->uberstate_content_lt(lhs.first, rhs.first);
+          }
+          return lhs.second < rhs.second;
+        };
+
+      std::unordered_map<unsigned, unsigned> raw_to_canon;
+      std::queue<unsigned> bfs_queue;
+      canon_to_raw.clear();
+      auto visit = [&](unsigned raw) {
+          if (raw_to_canon.insert({raw, canon_to_raw.size()}).second) {
+            canon_to_raw.push_back(raw);
+            bfs_queue.push(raw);
+          }
+        };
+
+      std::sort(init_vec.begin(), init_vec.end(), us_lt);
+      for (unsigned state : init_vec) { visit(state); }
+      while (!bfs_queue.empty()) {
+        unsigned raw = bfs_queue.front();
+        bfs_queue.pop();
+        for (auto& symbol_succs : raw_states.at(raw)) {
+          vec_state_taggedcol& succs = symbol_succs.second;
+          std::sort(succs.begin(), succs.end(), taggedcol_lt);
+          for (const auto& tgt_cols : succs) { visit(tgt_cols.first); }
+        }
       }
 
-      // sort and remove duplicates
-      remove_duplicit(result);
+      assert(canon_to_raw.size() == raw_states.size());
+      std::map<unsigned, uberstate_post> result;
+      for (unsigned canon = 0; canon < canon_to_raw.size(); ++canon) {
+        uberstate_post& post = raw_states.at(canon_to_raw[canon]);
+        for (auto& symbol_succs : post) {
+          for (auto& tgt_cols : symbol_succs.second) {
+            tgt_cols.first = raw_to_canon.at(tgt_cols.first);
+          }
+        }
+        result.insert({canon, std::move(post)});
+      }
+
+      for (unsigned& state : init_vec) { state = raw_to_canon.at(state); }
 
       return result;
-    } // get_initial_uberstates() }}}
+    } // renumber_canonically() }}}
 
+    /// acceptance condition of the complement together with the information
+    /// needed to translate colours tagged by partitions into its colours
+    struct result_acceptance
+    {
+      spot::acc_cond cond;
+      // TODO: vector should suffice
+      std::map<unsigned, unsigned> part_col_offset;
+      std::vector<spot::acc_cond> vec_acc_code;
+    };
 
-    /// partitions the SCCs of the input automaton according to decomposition
-    /// options, returns a triple (num_partitions, partition_types,
-    /// state_to_partition_map, scc_to_partition_map)
-    static std::tuple<size_t,
-                      kofola::PartitionToTypeMap,
-                      kofola::StateToPartitionMap,
-                      kofola::SCCToPartitionMap
-                      >
-    create_partitions(
-      const spot::scc_info&        scc_inf,
-      const compl_decomp_options&  opt)
+    /// computes the acceptance condition of the complement (needs to be
+    /// called after the exploration)
+    static result_acceptance compute_acceptance(
+      const vec_algorithms&  alg_vec,
+      bool                   is_sink_created)
     { // {{{
-      using kofola::PartitionType;
+      result_acceptance result;
+      size_t num_colours = RESERVED_COLOURS;
+      int rr_colour = -1;     // colour for round robin
 
-      std::string scc_types = get_scc_types(scc_inf);
-      size_t part_index = 0;
+      spot::acc_cond::acc_code sink_acc_code = spot::acc_cond::acc_code::inf({SINK_COLOUR});
+      spot::acc_cond::acc_code alg_acc_code = spot::acc_cond::acc_code::t();
+      for (size_t i = 0; i < alg_vec.size(); ++i) { // sum up acceptance conditions
+        const auto& alg = alg_vec[i];
 
-      kofola::PartitionToTypeMap part_to_type_map;
-      kofola::StateToPartitionMap st_to_part_map;
-      kofola::SCCToPartitionMap scc_to_part_map;   // -1 is invalid partition
+        const spot::acc_cond& cond = alg->get_acc_cond();
+        result.vec_acc_code.push_back(cond);
+        spot::acc_cond::acc_code cond_code = cond.get_acceptance();
+        if (alg->use_round_robin()) {
+          if (rr_colour < 0) {  // the first round robin
+            rr_colour = num_colours;
+            ++num_colours;
+            alg_acc_code &= spot::acc_cond::acc_code::inf({static_cast<unsigned>(rr_colour)});
+          }
 
-      int iwa_index = -1;
+          result.part_col_offset[i] = rr_colour;
+        } else {
+          cond_code <<= num_colours;
+          alg_acc_code &= cond_code;
+          result.part_col_offset[i] = num_colours;
+          num_colours += cond.num_sets();
+        }
+      }
+
+      DEBUG_PRINT_LN("colour offsets: " + std::to_string(result.part_col_offset));
+      DEBUG_PRINT_LN("vec_acc_code: " + std::to_string(result.vec_acc_code));
+
+      spot::acc_cond::acc_code final_code = alg_acc_code;
+      if (is_sink_created) {                // accept also in sink, if created
+        final_code |= sink_acc_code;
+      }
+
+      result.cond = spot::acc_cond(num_colours, final_code);
+      return result;
+    } // compute_acceptance() }}}
+
+    /// translates colours tagged by partitions into colours of the complement
+    static std::vector<unsigned> translate_colours(
+      const vec_algorithms&                          alg_vec,
+      const result_acceptance&                       acc,
+      const std::set<std::pair<unsigned, unsigned>>& cols)
+    { // {{{
+      std::vector<unsigned> new_cols;
+      for (const std::pair<unsigned, unsigned>& part_col_pair : cols) {
+        const unsigned part_index = part_col_pair.first;
+        const unsigned colour = part_col_pair.second;
+
+        if (UINT_MAX == colour) { // FIXME: this is a special way
+          // of dealing with determinization-based (this should set the
+          // colour to the maximum colour) - try to make more uniform
+
+          unsigned max_col = acc.vec_acc_code[part_index].num_sets() - 1;
+          new_cols.push_back(acc.part_col_offset.at(part_index) + max_col);
+        } else { // standard transition
+          unsigned shift = alg_vec[part_index]->get_min_colour(); // how much to decrement the colour
+          new_cols.push_back(acc.part_col_offset.at(part_index) + colour - shift);
+        }
+      }
+
+      return new_cols;
+    } // translate_colours() }}}
+
+    // Streaming of the result: the body of the automaton is written into a
+    // temporary file (the spool) as soon as an uberstate is expanded, with
+    // colours still tagged by partitions (the acceptance condition is known
+    // only after the exploration, since the range of colours used by the
+    // determinization-based algorithm is not known in advance).  In the end,
+    // the header is written to 'hoa_stream_' and the spool is copied after
+    // it, translating the colours.  Edges are spooled as lines
+    //
+    //   [label] target<TAB>part,colour part,colour ...
+    //
+    // States get consecutive numbers in the order they are first seen, which
+    // does not depend on the run only with a single thread (so main() does
+    // not allow streaming with more threads).
+
+    /// converts a BDD into a HOA label (a disjunction of cubes); needs to
+    /// hold 'bdd_mutex_'
+    std::string bdd_to_hoa_label(const bdd& cond) const
+    { // {{{
+      if (bddtrue == cond) { return "t"; }
+      if (bddfalse == cond) { return "f"; }
+
+      std::string result;
+      spot::minato_isop isop(cond);
+      bdd cube;
+      while ((cube = isop.next()) != bddfalse) {
+        std::string conj;
+        while (cube != bddtrue) {
+          int var = bdd_var(cube);
+          bdd high = bdd_high(cube);
+          if (!conj.empty()) { conj += "&"; }
+          if (bddfalse == high) { // negative literal
+            conj += "!";
+            cube = bdd_low(cube);
+          } else {
+            cube = high;
+          }
+          conj += std::to_string(this->var_to_ap_.at(var));
+        }
+
+        if (!result.empty()) { result += " | "; }
+        result += (conj.empty())? "t" : conj;
+      }
+
+      return result;
+    } // bdd_to_hoa_label() }}}
+
+    /// returns the number of a state in the streamed automaton; needs to hold
+    /// 'bdd_mutex_'
+    unsigned get_stream_num(unsigned us_num)
+    { // {{{
+      auto it_bool_pair = this->stream_num_.insert({us_num, this->stream_num_.size()});
+      return it_bool_pair.first->second;
+    } // get_stream_num() }}}
+
+    /// prepares the spool for streaming
+    void start_spool()
+    { // {{{
+      this->hoa_spool_ = std::tmpfile();
+      if (nullptr == this->hoa_spool_) {
+        throw std::runtime_error("cannot create a temporary file for streaming");
+      }
+
+      const auto& aps = this->aut_->ap();
+      for (unsigned i = 0; i < aps.size(); ++i) {
+        this->var_to_ap_[this->aut_->get_dict()->varnum(aps[i])] = i;
+      }
+    } // start_spool() }}}
+
+    /// writes a string into the spool
+    void spool_write(const std::string& str)
+    { // {{{
+      if (str.size() != std::fwrite(str.data(), 1, str.size(), this->hoa_spool_)) {
+        throw std::runtime_error("error writing to a temporary file for streaming");
+      }
+    } // spool_write() }}}
+
+    /// writes the post of an uberstate into the spool; needs to hold
+    /// 'bdd_mutex_'
+    void spool_post(unsigned us_num, const uberstate_post& post)
+    { // {{{
+      std::string text = "State: " + std::to_string(this->get_stream_num(us_num));
+      if (this->show_names_) {
+        text += " \"" +
+          escape_hoa_string(this->uberstate_to_string(num_to_uberstate(us_num))) + "\"";
+      }
+      text += "\n";
+
+      for (const auto& symbol_succs : post) {
+        const std::string label = "[" + this->bdd_to_hoa_label(symbol_succs.first) + "] ";
+        for (const auto& tgt_cols : symbol_succs.second) {
+          text += label + std::to_string(this->get_stream_num(tgt_cols.first)) + "\t";
+          for (const auto& part_col : tgt_cols.second) {
+            text += std::to_string(part_col.first) + "," +
+              std::to_string(part_col.second) + " ";
+          }
+          text += "\n";
+        }
+      }
+
+      this->spool_write(text);
+    } // spool_post() }}}
+
+    /// writes the sink state into the spool
+    void spool_sink()
+    { // {{{
+      const unsigned sink = this->get_stream_num(this->sink_state_);
+      std::string text = "State: " + std::to_string(sink);
+      if (this->show_names_) { text += " \"SINK\""; }
+      text += "\n[t] " + std::to_string(sink) + " {" +
+        std::to_string(SINK_COLOUR) + "}\t\n";
+      this->spool_write(text);
+    } // spool_sink() }}}
+
+    /// escapes a string to be used in HOA
+    static std::string escape_hoa_string(const std::string& str)
+    { // {{{
+      std::string result;
+      for (char c : str) {
+        if ('"' == c || '\\' == c) { result += '\\'; }
+        result += c;
+      }
+      return result;
+    } // escape_hoa_string() }}}
+
+    /// writes the streamed automaton (header + translated spool) into
+    /// 'hoa_stream_'
+    void write_streamed_hoa(
+      const vec_algorithms&         alg_vec,
+      const result_acceptance&      acc,
+      const std::vector<unsigned>&  init_vec)
+    { // {{{
+      assert(nullptr != this->hoa_spool_);
+      std::ostream& os = *this->hoa_stream_;
+
+      os << "HOA: v1\n";
+      os << "States: " << this->stream_num_.size() << "\n";
+      for (unsigned state : init_vec) { // HOA allows more initial states
+        os << "Start: " << this->stream_num_.at(state) << "\n";
+      }
+      const auto& aps = this->aut_->ap();
+      os << "AP: " << aps.size();
+      for (const auto& ap : aps) {
+        os << " \"" << escape_hoa_string(ap.ap_name()) << "\"";
+      }
+      os << "\n";
+      os << "Acceptance: " << acc.cond.num_sets() << " " << acc.cond.get_acceptance() << "\n";
+      os << "properties: trans-labels explicit-labels trans-acc\n";
+      os << "--BODY--\n";
+
+      std::rewind(this->hoa_spool_);
+      std::string line;
+      while (read_line(this->hoa_spool_, line)) {
+        if (0 == line.compare(0, 6, "State:")) { // state line
+          os << line << "\n";
+          continue;
+        }
+
+        size_t tab = line.find('\t');
+        assert(std::string::npos != tab);
+
+        os << line.substr(0, tab);
+        std::set<std::pair<unsigned, unsigned>> cols;
+        std::istringstream tags(line.substr(tab + 1));
+        unsigned part;
+        unsigned colour;
+        char comma;
+        while (tags >> part >> comma >> colour) {
+          cols.insert({part, colour});
+        }
+        if (!cols.empty()) {
+          std::vector<unsigned> new_cols = translate_colours(alg_vec, acc, cols);
+          std::sort(new_cols.begin(), new_cols.end());
+          new_cols.erase(std::unique(new_cols.begin(), new_cols.end()), new_cols.end());
+          os << " {";
+          for (size_t i = 0; i < new_cols.size(); ++i) {
+            os << ((0 == i)? "" : " ") << new_cols[i];
+          }
+          os << "}";
+        }
+        os << "\n";
+      }
+      os << "--END--\n";
+
+      std::fclose(this->hoa_spool_);
+      this->hoa_spool_ = nullptr;
+    } // write_streamed_hoa() }}}
+
+    /// reads a line (without the newline) from a file
+    static bool read_line(std::FILE* file, std::string& line)
+    { // {{{
+      line.clear();
+      int c;
+      while (EOF != (c = std::fgetc(file))) {
+        if ('\n' == c) { return true; }
+        line += static_cast<char>(c);
+      }
+
+      return !line.empty();
+    } // read_line() }}}
+
+    /// gets all initial uberstates wrt a vector of algorithms
+    std::vector<unsigned> get_initial_uberstates(const vec_algorithms& alg_vec)
+    { // {{{
+      kofola::state_bitset initial_states = {aut_->get_init_state_number()};
+
+      int init_active = get_next_active_scc(alg_vec, INACTIVE_SCC);
+      DEBUG_PRINT_LN("initial active partition: " + std::to_string(init_active));
+
+      using mstate_set = kofola::abstract_complement_alg::mstate_set;
+      std::vector<std::vector<unsigned>> vec_mstate_sets;
+      for (size_t i = 0; i < alg_vec.size(); ++i) { // get outputs of all procedures
+        mstate_set init_mstates = alg_vec[i]->get_init();
+        if (i == init_active || !alg_vec[i]->use_round_robin()) { // make the partial macrostate active
+          mstate_set new_mstates;
+          for (const auto& st : init_mstates) {
+            mstate_set lifted = alg_vec[i]->lift_track_to_active(st);
+            new_mstates.insert(new_mstates.end(), lifted.begin(), lifted.end());
+          }
+          init_mstates = std::move(new_mstates);
+        }
+        if (init_mstates.empty()) { return {};}   // one empty set terminates
+
+        std::vector<unsigned> init_ids;
+        for (const auto& st : init_mstates) {
+          init_ids.push_back(this->intern_part_macrostate(i, st));
+        }
+        remove_duplicit(init_ids);
+        vec_mstate_sets.emplace_back(std::move(init_ids));
+      }
+
+      DEBUG_PRINT_LN("obtained vector of sets of partial macrostates: " + std::to_string(vec_mstate_sets));
+
+      // the Cartesian product of the sets of macrostates gives the initial
+      // uberstates
+      std::vector<unsigned> tuple(this->uberstates_.width());
+      tuple[uberstate::REACH_SET_POS] = this->intern_reach_set(initial_states);
+      tuple[uberstate::ACTIVE_SCC_POS] = static_cast<unsigned>(init_active);
+      std::vector<unsigned> result;
+      for_each_cartesian_prod(vec_mstate_sets,
+        [&](const std::vector<size_t>& indices) {
+        for (size_t i = 0; i < indices.size(); ++i) {
+          tuple[uberstate::PART_MACROSTATES_POS + i] = vec_mstate_sets[i][indices[i]];
+        }
+        unsigned us_num = this->insert_uberstate(tuple).first;
+        result.push_back(us_num);
+      });
+
+      // sort and remove duplicates
+      remove_duplicit(result);
+
+      return result;
+    } // get_initial_uberstates() }}}
+
+
+    /// partitions the SCCs of the input automaton according to decomposition
+    /// options, returns a triple (num_partitions, partition_types,
+    /// state_to_partition_map, scc_to_partition_map)
+    static std::tuple<size_t,
+                      kofola::PartitionToTypeMap,
+                      kofola::StateToPartitionMap,
+                      kofola::SCCToPartitionMap
+                      >
+    create_partitions(
+      const spot::scc_info&        scc_inf,
+      const compl_decomp_options&  opt)
+    { // {{{
+      using kofola::PartitionType;
+
+      std::string scc_types = get_scc_types(scc_inf);
+      size_t part_index = 0;
+
+      kofola::PartitionToTypeMap part_to_type_map;
+      kofola::StateToPartitionMap st_to_part_map;
+      kofola::SCCToPartitionMap scc_to_part_map;   // -1 is invalid partition
+
+      int iwa_index = -1;
       int dac_index = -1;
 
       // When merging IWAs, move the IWA partition to the front.  This makes it
@@ -1877,19 +2312,42 @@ namespace cola
     } // select_algorithms() }}}
 
 
-    /// new modular complementation procedure
-    spot::twa_graph_ptr
-    run_new()
+    /// preprocesses the input automaton, selects the algorithms for its
+    /// partitions and prepares the tables of uberstates; needs to be called
+    /// before the uberstates are explored
+    void prepare()
     { // {{{
-      this->si_ = spot::scc_info(this->aut_, spot::scc_info_options::ALL);
+      // the given SCCs may be of another automaton (e.g., before preprocessing)
+      if (this->si_.get_aut() != this->aut_) {
+        this->si_ = spot::scc_info(this->aut_, spot::scc_info_options::ALL);
+      }
 
+      {
+        kofola::phase_timer timer("simulation");
       // if (this->decomp_options_.iw_sim || this->decomp_options_.det_sim) {
         this->reduce_and_compute_simulation();
       // }
+      }
 
-      this->si_ = spot::scc_info(this->aut_, spot::scc_info_options::ALL);
-      this->aut_ = saturation(this->aut_, this->si_);
-      this->si_ = spot::scc_info(this->aut_, spot::scc_info_options::ALL);
+      {
+        kofola::phase_timer timer("saturation");
+        this->si_ = spot::scc_info(this->aut_, spot::scc_info_options::ALL);
+        this->aut_ = saturation(this->aut_, this->si_);
+        this->si_ = spot::scc_info(this->aut_, spot::scc_info_options::ALL);
+      }
+
+      // select pairs of the simulation for pruning of reached states
+      this->prune_sim_ = kofola::Simulation(this->dir_sim_.num_states());
+      for (unsigned smaller = 0; smaller < this->dir_sim_.num_states(); ++smaller) {
+        for (unsigned bigger : this->dir_sim_.get_simulators(smaller)) {
+          // if (kofola::is_in(bigger, this->reachable_vector_[smaller]) &&
+          //     !kofola::is_in(smaller, this->reachable_vector_[bigger])) {
+          if (this->si_.scc_of(smaller) > this->si_.scc_of(bigger)) {
+            // we assume that if SCC A is reachable from SCC B, then #(A) < #(B) (this is how spot seems to order SCCs)
+            this->prune_sim_.add(smaller, bigger);
+          }
+        }
+      }
 
       if (kofola::LOG_VERBOSITY > 0) {
         DEBUG_PRINT_LN("Complementing the following aut:");
@@ -1928,44 +2386,39 @@ namespace cola
         this->is_accepting_[i] = accepting && has_transitions;
       }
 
-      // here, we check whether SCC numbering provided by Spot is compatible
-      // with the reachability relation, to be used in advanced simulation-based pruning
-      std::vector<std::set<int>> aux_reach = this->get_reachable_vector();
-      for (unsigned st = 0; st < this->aut_->num_states(); ++st) {
-        const std::set<int>& old_set = aux_reach[st];
-        std::set<unsigned> new_set;
-        for (const auto& el : old_set) {
-          assert(el >= 0);
-          assert(this->si_.scc_of(st) >= this->si_.scc_of(el));     // check scc numbering is reverse-compatible with reachability
-          new_set.insert(static_cast<unsigned>(el));
-        }
+      // split the alphabet and precompute successors over letters, so that
+      // the exploration can work with letters instead of BDDs; with a memory
+      // budget, the table may take at most a quarter of it
+      this->alphabet_ = std::make_unique<kofola::minterm_alphabet>(this->aut_);
+      const size_t max_table_bytes = (size_t(this->decomp_options_.max_memory) << 20) / 4;
+      this->post_table_ = std::make_unique<kofola::post_image_table>(
+        this->aut_, *this->alphabet_, this->si_, max_table_bytes);
 
-        this->reachable_vector_.push_back(new_set);
-      }
+      // reachability between SCCs (on the condensation of the automaton)
+      this->reach_ = std::make_unique<kofola::scc_reachability>(this->si_);
 
 
+      kofola::phase_timer partitioning_timer("partitioning");
       auto partitions = create_partitions(this->si_, this->decomp_options_);
       const size_t num_partitions = std::get<0>(partitions);
-      kofola::PartitionToTypeMap part_to_type_map = std::get<1>(partitions);
-      kofola::StateToPartitionMap st_part_map = std::get<2>(partitions);
+      this->part_to_type_map_ = std::get<1>(partitions);
+      this->st_part_map_ = std::get<2>(partitions);
       kofola::SCCToPartitionMap scc_part_map = std::get<3>(partitions);
 
-      kofola::PartitionToSCCMap part_to_scc_map =
-        create_part_to_scc_map(scc_part_map);
-      kofola::SCCToSCCSetMap scc_to_pred_sccs_map =
-        create_scc_to_pred_sccs_map(this->si_, this->reachable_vector_);
+      this->part_to_scc_map_ = create_part_to_scc_map(scc_part_map);
 
 
       // collect information for complementation
-      kofola::cmpl_info info(
+      this->info_ = std::make_unique<kofola::cmpl_info>(
         this->aut_,             // automaton
         num_partitions,         // number of partitions
-        part_to_type_map,       // partition types
-        st_part_map,            // state to partition map
-        this->reachable_vector_,// vector of reachable states
-        part_to_scc_map,        // map of partitions to sets of SCCS they contain
-        scc_to_pred_sccs_map,   // maps SCCs to the sets of their predecessors
+        this->part_to_type_map_,// partition types
+        this->st_part_map_,     // state to partition map
+        this->part_to_scc_map_, // map of partitions to sets of SCCS they contain
+        *this->reach_,          // reachability between states and SCCs
         this->si_,              // SCC information
+        *this->alphabet_,       // letters
+        *this->post_table_,     // successors over letters
         this->dir_sim_,         // direct simulation
         this->is_accepting_,    // vector for acceptance of states
         this->decomp_options_); // options
@@ -1973,88 +2426,428 @@ namespace cola
       DEBUG_PRINT_LN("selecting algorithms");
 
       // creates a vector of algorithms, for every SCC of aut one
-      vec_algorithms alg_vec = select_algorithms(info);
+      this->alg_vec_ = select_algorithms(*this->info_);
 
       DEBUG_PRINT_LN("algorithms selected");
+      partitioning_timer.stop();
+
+      // prepare the tables of uberstates and their components
+      const size_t num_threads = std::max(1u, this->decomp_options_.threads);
+      this->uberstates_ = kofola::concurrent_tuple_table(
+        uberstate::PART_MACROSTATES_POS + num_partitions,
+        (num_threads > 1)? NUM_SHARDS : 1);
+      for (size_t i = 0; i < num_partitions; ++i) {
+        this->part_macrostates_.emplace_back(new mstate_table());
+        this->succ_caches_.emplace_back(new kofola::succ_cache());
+      }
+      this->num_part_succ_calls_.reset(new std::atomic<size_t>[num_partitions]);
+      for (size_t i = 0; i < num_partitions; ++i) {
+        this->num_part_succ_calls_[i] = 0;
+      }
+    } // prepare() }}}
 
-      // our structure for the automaton (TODO: hash table might be better)
-      std::map<unsigned, std::vector<std::pair<bdd, vec_state_taggedcol>>> compl_states;
 
-      // get initial uberstates
-      auto init_vec{this->get_initial_uberstates(alg_vec)};
-      std::stack<unsigned> todo;
-      for (unsigned state : init_vec) {
-        compl_states.insert({state, {}});
-        todo.push(state);
+    /// checks that the construction is within the budgets given in the
+    /// options after an uberstate was expanded and 'num_new' uberstates were
+    /// discovered; throws kofola::budget_exceeded otherwise
+    void check_budgets(size_t num_new, size_t todo_size)
+    { // {{{
+      const size_t discovered = (this->num_discovered_ += num_new);
+      const size_t expanded = ++this->num_expanded_;
+      const auto& opts = this->decomp_options_;
+
+      std::string resource;
+      if (opts.max_states > 0 && discovered > opts.max_states) {
+        resource = "states";
+      } else if (0 == expanded % BUDGET_CHECK_PERIOD) {
+        const auto elapsed = std::chrono::steady_clock::now() - this->start_time_;
+        if (opts.timeout > 0 && elapsed >= std::chrono::seconds(opts.timeout)) {
+          resource = "time";
+        } else if (opts.max_memory > 0 &&
+          kofola::get_peak_memory_mib() > opts.max_memory) {
+          resource = "memory";
+        }
       }
 
-      bool is_sink_created = false;
-      unsigned sink_state = static_cast<unsigned>(-1);
+      if (resource.empty()) { return; }
 
-      DEBUG_PRINT_LN("initial todo: " + std::to_string(todo));
+      // find the partition with the most partial macrostates
+      int max_part = -1;
+      size_t max_part_size = 0;
+      for (size_t i = 0; i < this->part_macrostates_.size(); ++i) {
+        if (this->part_macrostates_[i]->size() > max_part_size) {
+          max_part = i;
+          max_part_size = this->part_macrostates_[i]->size();
+        }
+      }
+
+      throw kofola::budget_exceeded(resource, discovered, expanded, todo_size,
+        max_part, max_part_size);
+    } // check_budgets() }}}
+
+
+    /// the order of tasks of the pool of workers corresponding to
+    /// decomp_options_.order
+    kofola::work_stealing_pool::task_order get_task_order() const
+    { // {{{
+      using task_order = kofola::work_stealing_pool::task_order;
+      switch (this->decomp_options_.order) {
+        case explore_order::DFS: return task_order::LIFO;
+        case explore_order::BFS: return task_order::FIFO;
+        default: return task_order::PRIORITY;
+      }
+    } // get_task_order() }}}
 
-      while (!todo.empty()) { // the main loop
-        // get next uberstate
-        unsigned us_num = todo.top();
-        todo.pop();
-        const uberstate& us = num_to_uberstate(us_num);
+    /// the priority of an uberstate in the pool of workers (lower values are
+    /// explored first)
+    size_t get_priority(unsigned us_num) const
+    { // {{{
+      const uberstate us = num_to_uberstate(us_num);
+      switch (this->decomp_options_.order) {
+        case explore_order::SMALL_REACH:
+          return this->get_reach_set(us).size();
+        case explore_order::ACTIVE: {
+          size_t num_tracking = 0;
+          for (size_t i = 0; i < this->part_macrostates_.size(); ++i) {
+            if (!kofola::is_active(this->get_part_macrostate(us, i))) { ++num_tracking; }
+          }
+          return num_tracking;
+        }
+        default: return 0;
+      }
+    } // get_priority() }}}
 
-        // get the post of 'us'
-        auto it = compl_states.find(us_num);
-        assert(compl_states.end() != it);
-        std::vector<std::pair<bdd, vec_state_taggedcol>>& us_post = it->second;
 
-        DEBUG_PRINT_LN("processing " + std::to_string(us_num) + ": " + us.to_string());
+    /// prints the numbers of hits and misses of the caches of successors
+    void print_succ_cache_stats() const
+    { // {{{
+      for (size_t i = 0; i < this->succ_caches_.size(); ++i) {
+        PRINT_VERBOSE_LVL(1, "info", "successor cache of partition " << i <<
+          ": " << this->succ_caches_[i]->hits() << " hits, " <<
+          this->succ_caches_[i]->misses() << " misses");
+      }
+    } // print_succ_cache_stats() }}}
 
-        // compute support of all available states
-        // TODO: this should be cached for each reach_set
-        bdd msupport = bddtrue;
-        bdd n_s_compat = bddfalse;
-        const std::set<unsigned> &reach_set = us.get_reach_set();
 
-        // compute the occurred variables in the outgoing transitions of ms, stored in msupport
-        for (unsigned s : reach_set)
-        {
-          msupport &= support_[s];
-          n_s_compat |= compat_[s];
-        }
-
-        // direct non-support symbols to sink
-        bdd all = n_s_compat;
-        if (all != bddtrue) {
-          if (!is_sink_created) { // first time encountering sink state
-            is_sink_created = true;
-            sink_state = this->cnt_state_;
-            ++this->cnt_state_;
-            this->num_to_uberstate_map_.push_back(nullptr);
-
-            DEBUG_PRINT_LN("creating a sink state: " + std::to_string(sink_state));
-            // create a sink state (its transitions)
-            compl_states.insert({sink_state, {{bddtrue, {{sink_state, {{UINT_MAX, SINK_COLOUR}}}}}}});
+    /// adds the counters of the exploration to kofola::STATS
+    void publish_stats() const
+    { // {{{
+      kofola::STATS.add("uberstates", this->num_discovered_);
+      kofola::STATS.add("expanded", this->num_expanded_);
+      kofola::STATS.add("transitions", this->num_transitions_);
+      kofola::STATS.add("letters", this->num_letters_);
+      kofola::STATS.add("cartesian_tuples", this->num_cartesian_tuples_);
+      kofola::STATS.set_max("max_cartesian_size", this->max_cartesian_size_);
+      for (size_t i = 0; i < this->alg_vec_.size(); ++i) {
+        const kofola::abstract_complement_alg* alg = this->alg_vec_[i].get();
+        std::string alg_name = "rank";
+        if (dynamic_cast<const kofola::complement_mh*>(alg)) { alg_name = "mh"; }
+        else if (dynamic_cast<const kofola::complement_ncsb*>(alg)) { alg_name = "ncsb"; }
+        else if (dynamic_cast<const kofola::complement_safra*>(alg)) { alg_name = "safra"; }
+        kofola::STATS.add("succ_calls_" + std::to_string(i) + "_" + alg_name,
+          this->num_part_succ_calls_[i]);
+      }
+    } // publish_stats() }}}
+
+
+    /// kind of checkpoints written by save_checkpoint()
+    static constexpr const char* CHECKPOINT_KIND = "complement";
+
+    /// writes a checkpoint of the exploration into
+    /// decomp_options_.checkpoint_file: the state of the algorithms, the
+    /// tables of reached sets, partial macrostates and uberstates, the posts
+    /// of the expanded uberstates, and the uberstates still to be expanded
+    /// ('todo'); no worker may be running
+    void save_checkpoint(
+      const std::vector<std::vector<std::pair<unsigned, uberstate_post>>>&  worker_posts,
+      const std::vector<unsigned>&                                          init_vec,
+      const std::vector<unsigned>&                                          todo)
+    { // {{{
+      kofola::checkpoint_writer out(this->decomp_options_.checkpoint_file,
+        CHECKPOINT_KIND, this->om_.get_str(CHECKPOINT_OPTIONS), this->aut_);
+
+      out.write_uint(this->alg_vec_.size());
+      for (size_t i = 0; i < this->alg_vec_.size(); ++i) {
+        out.write_uint(static_cast<unsigned>(this->part_to_type_map_.at(i)));
+        this->alg_vec_[i]->save_state(out);
+      }
+
+      // the tables are written in the order of numbers, so that inserting
+      // their elements in the same order gives them the same numbers
+      out.write_uint(this->reach_sets_.size());
+      for (unsigned i = 0; i < this->reach_sets_.size(); ++i) {
+        out.write_bitset(this->reach_sets_[i]);
+      }
+      for (const auto& table : this->part_macrostates_) {
+        out.write_uint(table->size());
+        for (unsigned i = 0; i < table->size(); ++i) { kofola::save_mstate(out, (*table)[i]); }
+      }
+
+      // uberstates are written shard by shard
+      const size_t num_shards = this->uberstates_.num_shards();
+      out.write_uint(num_shards);
+      out.write_uint(this->sink_state_);
+      for (size_t sh = 0; sh < num_shards; ++sh) {
+        const size_t size = this->uberstates_.shard_size(sh);
+        out.write_uint(size);
+        for (size_t i = 0; i < size; ++i) {
+          const unsigned* tuple = this->uberstates_[i * num_shards + sh];
+          for (size_t j = 0; j < this->uberstates_.width(); ++j) {
+            out.write_uint(tuple[j]);
+          }
+        }
+      }
+
+      size_t num_posts = 0;
+      for (const auto& posts : worker_posts) { num_posts += posts.size(); }
+      out.write_uint(num_posts);
+      for (const auto& posts : worker_posts) {
+        for (const auto& st_post_pair : posts) {
+          out.write_uint(st_post_pair.first);
+          out.write_uint(st_post_pair.second.size());
+          for (const auto& symbol_succs : st_post_pair.second) {
+            out.write_bdd(symbol_succs.first);
+            out.write_uint(symbol_succs.second.size());
+            for (const auto& tgt_cols : symbol_succs.second) {
+              out.write_uint(tgt_cols.first);
+              out.write_uint(tgt_cols.second.size());
+              for (const auto& part_col : tgt_cols.second) {
+                out.write_uint(part_col.first);
+                out.write_uint(part_col.second);
+              }
+            }
           }
-          vec_state_taggedcol succs = {{sink_state, {}}};
-          us_post.emplace_back(std::make_pair(!all, std::move(succs)));
         }
+      }
 
-        // iterate over all symbols
-        while (all != bddfalse) {
-          bdd letter = bdd_satoneset(all, msupport, bddfalse);
-          all -= letter;
+      out.write_uint_range(init_vec);
+      out.write_uint_range(todo);
+      out.write_uint(this->num_expanded_);
+      out.commit();
+
+      PRINT_VERBOSE_LVL(1, "info", "checkpoint " <<
+        this->decomp_options_.checkpoint_file << " written: " <<
+        this->num_discovered_ << " states discovered, " << todo.size() <<
+        " to be expanded");
+    } // save_checkpoint() }}}
+
+
+    /// restores the exploration from the checkpoint
+    /// decomp_options_.resume_file (written by save_checkpoint() for the
+    /// same input and options) after prepare(); the posts of the expanded
+    /// uberstates are appended to 'posts' and the uberstates to be expanded
+    /// are returned
+    std::vector<unsigned> load_checkpoint(
+      std::vector<std::pair<unsigned, uberstate_post>>&  posts,
+      std::vector<unsigned>&                             init_vec)
+    { // {{{
+      kofola::checkpoint_reader in(this->decomp_options_.resume_file,
+        CHECKPOINT_KIND, this->om_.get_str(CHECKPOINT_OPTIONS), this->aut_);
 
-          DEBUG_PRINT_LN("symbol: " + std::to_string(letter));
+      if (in.read_uint() != this->alg_vec_.size()) { in.fail("other partitions"); }
+      for (size_t i = 0; i < this->alg_vec_.size(); ++i) {
+        if (in.read_uint() != static_cast<unsigned>(this->part_to_type_map_.at(i))) {
+          in.fail("other partitions");
+        }
+        this->alg_vec_[i]->load_state(in);
+      }
 
-          vec_state_taggedcol succs = this->get_succ_uberstates(alg_vec, us, letter);
-          us_post.emplace_back(std::make_pair(letter, succs));
+      for (uint64_t i = 0, size = in.read_uint(); i < size; ++i) {
+        if (this->intern_reach_set(in.read_bitset()) != i) {
+          in.fail("repeated set of reached states");
+        }
+      }
+      for (size_t part = 0; part < this->part_macrostates_.size(); ++part) {
+        for (uint64_t i = 0, size = in.read_uint(); i < size; ++i) {
+          if (this->intern_part_macrostate(part, this->alg_vec_[part]->load_mstate(in)) != i) {
+            in.fail("repeated partial macrostate");
+          }
+        }
+      }
 
-          for (const auto& state_cols : succs) {
-            const unsigned& succ_state = state_cols.first;
+      const size_t num_shards = in.read_uint();
+      if (0 == num_shards) { in.fail("no shards"); }
+      this->uberstates_ = kofola::concurrent_tuple_table(
+        this->uberstates_.width(), num_shards);
+      const unsigned sink_state = in.read_uint();
+      std::vector<unsigned> tuple(this->uberstates_.width());
+      for (size_t sh = 0; sh < num_shards; ++sh) {
+        for (uint64_t i = 0, size = in.read_uint(); i < size; ++i) {
+          for (unsigned& val : tuple) { val = in.read_uint(); }
+          const unsigned us_num = i * num_shards + sh;
+          unsigned new_num;
+          if (sink_state == us_num) {
+            new_num = this->get_sink();
+          } else {
+            bool valid = (tuple[uberstate::REACH_SET_POS] < this->reach_sets_.size());
+            for (size_t part = 0; part < this->part_macrostates_.size(); ++part) {
+              valid = valid && (tuple[uberstate::PART_MACROSTATES_POS + part] <
+                this->part_macrostates_[part]->size());
+            }
+            if (!valid) { in.fail("invalid uberstate"); }
+            new_num = this->insert_uberstate(tuple).first;
+          }
+          if (new_num != us_num) { in.fail("the table of uberstates cannot be rebuilt"); }
+        }
+      }
 
-            auto it_bool_pair = compl_states.insert({succ_state, {}});
-            if (it_bool_pair.second) { // the successor state is new
-              todo.push(succ_state);
+      for (uint64_t num_posts = in.read_uint(); num_posts > 0; --num_posts) {
+        const unsigned us_num = in.read_uint();
+        uberstate_post post(in.read_uint());
+        for (auto& symbol_succs : post) {
+          symbol_succs.first = in.read_bdd();
+          symbol_succs.second.resize(in.read_uint());
+          for (auto& tgt_cols : symbol_succs.second) {
+            tgt_cols.first = in.read_uint();
+            for (uint64_t num_cols = in.read_uint(); num_cols > 0; --num_cols) {
+              const unsigned part = in.read_uint();
+              tgt_cols.second.insert({part, static_cast<unsigned>(in.read_uint())});
             }
           }
         }
+        posts.emplace_back(us_num, std::move(post));
+      }
+
+      init_vec = in.read_uint_vector();
+      std::vector<unsigned> todo = in.read_uint_vector();
+      this->num_expanded_ = in.read_uint();
+      this->num_discovered_ = this->uberstates_.size() -
+        ((UINT_MAX != this->sink_state_)? 1 : 0);
+
+      PRINT_VERBOSE_LVL(1, "info", "resumed from checkpoint " <<
+        this->decomp_options_.resume_file << ": " << this->num_discovered_ <<
+        " states discovered, " << todo.size() << " to be expanded");
+
+      return todo;
+    } // load_checkpoint() }}}
+
+
+    /// new modular complementation procedure
+    spot::twa_graph_ptr
+    run_new()
+    { // {{{
+      this->start_time_ = std::chrono::steady_clock::now();
+      this->prepare();
+      const vec_algorithms& alg_vec = this->alg_vec_;
+      const auto& opts = this->decomp_options_;
+      const bool checkpointing = !opts.checkpoint_file.empty();
+      if ((checkpointing || !opts.resume_file.empty()) && nullptr != this->hoa_stream_) {
+        throw std::runtime_error("checkpoints cannot be used when the result is streamed");
+      }
+
+      // every worker collects the posts of the uberstates it expanded
+      const size_t num_threads = std::max(1u, opts.threads);
+      std::vector<std::vector<std::pair<unsigned, uberstate_post>>> worker_posts(num_threads);
+      kofola::work_stealing_pool pool(num_threads, this->get_task_order());
+
+      // get initial uberstates (or the state of the exploration from a
+      // checkpoint)
+      std::vector<unsigned> init_vec;
+      if (opts.resume_file.empty()) {
+        init_vec = this->get_initial_uberstates(alg_vec);
+        for (unsigned state : init_vec) {
+          pool.push(0, state, this->get_priority(state));
+        }
+        this->num_discovered_ = init_vec.size();
+      } else {
+        std::vector<unsigned> todo = this->load_checkpoint(worker_posts[0], init_vec);
+        for (unsigned state : todo) {
+          pool.push(0, state, this->get_priority(state));
+        }
+      }
+
+      DEBUG_PRINT_LN("initial states: " + std::to_string(init_vec));
+
+      if (nullptr != this->hoa_stream_) { // prepare streaming of the result
+        this->start_spool();
+      }
+
+      // the main loop; for comparing exploration orders, the distances
+      // between numbers of consecutively expanded uberstates (locality in
+      // the table of uberstates) are summed.  When checkpointing, the
+      // workers are stopped after every checkpoint interval, the checkpoint
+      // is written, and the exploration continues.
+      std::vector<unsigned> last_expanded(num_threads, 0);
+      std::vector<size_t> sum_distances(num_threads, 0);
+      const auto checkpoint_interval = std::chrono::seconds(opts.checkpoint_interval);
+      auto last_checkpoint = std::chrono::steady_clock::now();
+      kofola::phase_timer exploration_timer("exploration");
+      while (true) {
+        try {
+          pool.run([&](size_t worker, unsigned us_num) {
+              sum_distances[worker] += (us_num > last_expanded[worker])?
+                us_num - last_expanded[worker] : last_expanded[worker] - us_num;
+              last_expanded[worker] = us_num;
+
+              std::vector<unsigned> new_states;
+              this->expand_uberstate(alg_vec, us_num, worker_posts[worker], new_states);
+              for (unsigned succ_state : new_states) {
+                pool.push(worker, succ_state, this->get_priority(succ_state));
+              }
+              // the task being processed is still pending
+              this->check_budgets(new_states.size(), pool.num_pending() - 1);
+
+              if (checkpointing &&
+                std::chrono::steady_clock::now() - last_checkpoint >= checkpoint_interval) {
+                pool.request_stop();
+              }
+            });
+        } catch (const kofola::budget_exceeded&) {
+          this->publish_stats();
+          // the workers finished their uberstates, so the work done so far
+          // can be saved and resumed later with a larger budget
+          if (checkpointing) { this->save_checkpoint(worker_posts, init_vec, pool.drain()); }
+          throw;
+        }
+
+        if (!pool.is_stopped()) { break; }
+
+        std::vector<unsigned> todo = pool.drain();
+        this->save_checkpoint(worker_posts, init_vec, todo);
+        for (unsigned state : todo) {
+          pool.push(0, state, this->get_priority(state));
+        }
+        last_checkpoint = std::chrono::steady_clock::now();
+      }
+      exploration_timer.stop();
+      this->publish_stats();
+      this->print_succ_cache_stats();
+      if (this->num_expanded_ > 0) {
+        size_t sum = 0;
+        for (size_t dist : sum_distances) { sum += dist; }
+        PRINT_VERBOSE_LVL(1, "info", "exploration: " << this->num_expanded_ <<
+          " states expanded, peak todo size " << pool.peak_pending() <<
+          ", mean distance of consecutive states " <<
+          static_cast<double>(sum) / this->num_expanded_);
+      }
+
+      const bool is_sink_created = (UINT_MAX != this->sink_state_);
+      if (nullptr != this->hoa_stream_) { // the result was streamed
+        if (is_sink_created) { this->spool_sink(); }
+        result_acceptance acc = this->compute_acceptance(alg_vec, is_sink_created);
+        this->write_streamed_hoa(alg_vec, acc, init_vec);
+        return nullptr;
+      }
+
+      // our structure for the automaton (TODO: hash table might be better)
+      std::map<unsigned, std::vector<std::pair<bdd, vec_state_taggedcol>>> compl_states;
+      for (auto& posts : worker_posts) {
+        for (auto& st_post_pair : posts) {
+          compl_states.insert(std::move(st_post_pair));
+        }
+        posts.clear();
+      }
+
+      if (is_sink_created) { // create the transitions of the sink state
+        compl_states.insert({this->sink_state_,
+          {{bddtrue, {{this->sink_state_, {{UINT_MAX, SINK_COLOUR}}}}}}});
+      }
+
+      std::vector<unsigned> canon_to_raw;
+      compl_states = this->renumber_canonically(compl_states, init_vec, canon_to_raw);
+      unsigned sink_state = static_cast<unsigned>(-1);
+      for (unsigned canon = 0; is_sink_created && canon < canon_to_raw.size(); ++canon) {
+        if (this->sink_state_ == canon_to_raw[canon]) { sink_state = canon; }
       }
 
       bool new_init_created = false;
@@ -2062,8 +2855,7 @@ namespace cola
         new_init_created = true;
         DEBUG_PRINT_LN("handling multiple initial states: " +
           std::to_string(init_vec));
-        unsigned new_init = this->cnt_state_;
-        ++this->cnt_state_;
+        unsigned new_init = compl_states.size();
         DEBUG_PRINT_LN("new init state: " + std::to_string(new_init));
         auto it_bool_pair = compl_states.insert({new_init, {}});
         assert(it_bool_pair.second);
@@ -2081,45 +2873,7 @@ namespace cola
 
       DEBUG_PRINT_LN(std::to_string(compl_states));
 
-      // TODO: vector should suffice
-      std::map<unsigned, unsigned> part_col_offset;
-      std::vector<spot::acc_cond> vec_acc_code;
-      size_t num_colours = RESERVED_COLOURS;
-      int rr_colour = -1;     // colour for round robin
-
-      spot::acc_cond::acc_code sink_acc_code = spot::acc_cond::acc_code::inf({SINK_COLOUR});
-      spot::acc_cond::acc_code alg_acc_code = spot::acc_cond::acc_code::t();
-      for (size_t i = 0; i < num_partitions; ++i) { // sum up acceptance conditions
-        const auto& alg = alg_vec[i];
-
-        const spot::acc_cond& cond = alg->get_acc_cond();
-        vec_acc_code.push_back(cond);
-        spot::acc_cond::acc_code cond_code = cond.get_acceptance();
-        if (alg->use_round_robin()) {
-          if (rr_colour < 0) {  // the first round robin
-            rr_colour = num_colours;
-            ++num_colours;
-            alg_acc_code &= spot::acc_cond::acc_code::inf({static_cast<unsigned>(rr_colour)});
-          }
-
-          part_col_offset[i] = rr_colour;
-        } else {
-          cond_code <<= num_colours;
-          alg_acc_code &= cond_code;
-          part_col_offset[i] = num_colours;
-          num_colours += cond.num_sets();
-        }
-      }
-
-      DEBUG_PRINT_LN("colour offsets: " + std::to_string(part_col_offset));
-      DEBUG_PRINT_LN("vec_acc_code: " + std::to_string(vec_acc_code));
-
-      spot::acc_cond::acc_code final_code = alg_acc_code;
-      if (is_sink_created) {                // accept also in sink, if created
-        final_code |= sink_acc_code;
-      }
-
-      spot::acc_cond result_cond(num_colours, final_code);
+      result_acceptance acc = this->compute_acceptance(alg_vec, is_sink_created);
 
       // convert the result into a spot automaton
       // FIXME: we should be directly constructing spot aut
@@ -2134,7 +2888,7 @@ namespace cola
                             false         // stutter inv
                         });
 
-      result->set_acceptance(result_cond);
+      result->set_acceptance(acc.cond);
       DEBUG_PRINT_LN("Acc = " + std::to_string(result->get_acceptance()));
 
 
@@ -2152,25 +2906,11 @@ namespace cola
           const bdd& symbol = bdd_vec_tgt_pair.first;
           for (const auto& tgt_col_pair : bdd_vec_tgt_pair.second) {
             const unsigned& tgt = tgt_col_pair.first;
-            const std::set<std::pair<unsigned, unsigned>>& cols = tgt_col_pair.second;
             std::vector<unsigned> new_cols;
-            for (const std::pair<unsigned, unsigned>& part_col_pair : cols) {
-              const unsigned part_index = part_col_pair.first;
-              const unsigned colour = part_col_pair.second;
-
-              if (src == sink_state) { // sink state
-                new_cols.push_back(SINK_COLOUR);
-                continue;
-              } else if (UINT_MAX == colour) { // FIXME: this is a special way
-                // of dealing with determinization-based (this should set the
-                // colour to the maximum colour) - try to make more uniform
-
-                unsigned max_col = vec_acc_code[part_index].num_sets() - 1;
-                new_cols.push_back(part_col_offset.at(part_index) + max_col);
-              } else { // standard transition
-                unsigned shift = alg_vec[part_index]->get_min_colour(); // how much to decrement the colour
-                new_cols.push_back(part_col_offset.at(part_index) + colour - shift);
-              }
+            if (src == sink_state) { // sink state
+              new_cols.push_back(SINK_COLOUR);
+            } else {
+              new_cols = this->translate_colours(alg_vec, acc, tgt_col_pair.second);
             }
             spot::acc_cond::mark_t spot_cols(new_cols.begin(), new_cols.end());
             result->new_edge(src, tgt, symbol, spot_cols);
@@ -2184,7 +2924,8 @@ namespace cola
             assert(init_vec.size() == 1);
             state_names->push_back("INIT");
           } else {
-            state_names->push_back(num_to_uberstate(src).to_string());
+            state_names->push_back(
+              this->uberstate_to_string(num_to_uberstate(canon_to_raw[src])));
           }
         }
       }
@@ -2202,15 +2943,321 @@ namespace cola
   };
 
 
-  spot::twa_graph_ptr complement_tnba(
+  /// state of the on-the-fly complement (given by the number of an uberstate)
+  class lazy_compl_state : public spot::state
+  { // {{{
+  private: // DATA MEMBERS
+
+    unsigned num_;
+
+  public: // METHODS
+
+    /// constructor
+    explicit lazy_compl_state(unsigned num) : num_(num)
+    { }
+
+    /// returns the number of the state
+    unsigned get_num() const { return this->num_; }
+
+    virtual int compare(const spot::state* other) const override
+    { // {{{
+      unsigned other_num = static_cast<const lazy_compl_state*>(other)->num_;
+      if (this->num_ < other_num) { return -1; }
+      return (this->num_ > other_num)? 1 : 0;
+    } // compare() }}}
+
+    virtual size_t hash() const override
+    { return spot::wang32_hash(this->num_); }
+
+    virtual lazy_compl_state* clone() const override
+    { return new lazy_compl_state(this->num_); }
+  }; // lazy_compl_state }}}
+
+
+  /// transition of the on-the-fly complement
+  struct lazy_compl_edge
+  {
+    bdd cond;
+    unsigned dst;
+    spot::acc_cond::mark_t acc;
+  };
+
+
+  /// iterator over (already computed) successors of a state of the
+  /// on-the-fly complement
+  class lazy_compl_succ_iterator : public spot::twa_succ_iterator
+  { // {{{
+  private: // DATA MEMBERS
+
+    /// the transitions (owned by the automaton)
+    const std::vector<lazy_compl_edge>& edges_;
+    size_t pos_ = 0;
+
+  public: // METHODS
+
+    /// constructor
+    explicit lazy_compl_succ_iterator(const std::vector<lazy_compl_edge>& edges) :
+      edges_(edges)
+    { }
+
+    virtual bool first() override
+    { // {{{
+      this->pos_ = 0;
+      return !this->done();
+    } // first() }}}
+
+    virtual bool next() override
+    { // {{{
+      ++this->pos_;
+      return !this->done();
+    } // next() }}}
+
+    virtual bool done() const override
+    { return this->pos_ >= this->edges_.size(); }
+
+    virtual const spot::state* dst() const override
+    { return new lazy_compl_state(this->edges_[this->pos_].dst); }
+
+    virtual bdd cond() const override
+    { return this->edges_[this->pos_].cond; }
+
+    virtual spot::acc_cond::mark_t acc() const override
+    { return this->edges_[this->pos_].acc; }
+  }; // lazy_compl_succ_iterator }}}
+
+
+  /// The complement explored on the fly: successors of an uberstate are
+  /// computed only when Spot asks for them (e.g., when checking emptiness of
+  /// a product), and they are kept for later queries.  Since the colours
+  /// cannot be collected during a full construction, the acceptance
+  /// condition is fixed in advance (see
+  /// abstract_complement_alg::fix_acc_cond()) and assumes a sink state.
+  class lazy_complement : public spot::twa
+  { // {{{
+  private: // CONSTANTS
+
+    /// number of the artificial initial state (used if there are more
+    /// initial uberstates)
+    static const unsigned NEW_INIT = UINT_MAX - 1;
+
+  private: // DATA MEMBERS
+
+    // the complementation procedure refers to the following objects, so they
+    // are owned here
+    spot::option_map om_;
+    spot::const_twa_graph_ptr aut_;
+    spot::scc_info si_;
+    std::vector<bdd> implications_;
+    compl_decomp_options decomp_options_;
+
+    /// the complementation procedure
+    mutable tnba_complement comp_;
+    /// initial uberstates
+    std::vector<unsigned> init_vec_;
+    /// acceptance condition of the complement
+    tnba_complement::result_acceptance acc_;
+    /// already computed transitions
+    mutable std::unordered_map<unsigned, std::vector<lazy_compl_edge>> edges_;
+
+    /// returns the transitions of a state (computes them if needed)
+    const std::vector<lazy_compl_edge>& get_edges(unsigned num) const
+    { // {{{
+      auto it = this->edges_.find(num);
+      if (this->edges_.end() != it) { return it->second; }
+
+      std::vector<lazy_compl_edge> edges;
+      if (NEW_INIT == num) { // transitions of all initial states
+        for (unsigned init : this->init_vec_) {
+          const auto& init_edges = this->get_edges(init);
+          edges.insert(edges.end(), init_edges.begin(), init_edges.end());
+        }
+      } else if (this->comp_.sink_state_ == num) {
+        edges.push_back({bddtrue, num, {tnba_complement::SINK_COLOUR}});
+      } else {
+        std::vector<std::pair<unsigned, tnba_complement::uberstate_post>> posts;
+        std::vector<unsigned> new_states;   // not needed here
+        this->comp_.expand_uberstate(this->comp_.alg_vec_, num, posts, new_states);
+        assert(posts.size() == 1);
+        for (const auto& sym_succs_pair : posts[0].second) {
+          for (const auto& tgt_col_pair : sym_succs_pair.second) {
+            std::vector<unsigned> cols = tnba_complement::translate_colours(
+              this->comp_.alg_vec_, this->acc_, tgt_col_pair.second);
+            edges.push_back({sym_succs_pair.first, tgt_col_pair.first,
+              spot::acc_cond::mark_t(cols.begin(), cols.end())});
+          }
+        }
+      }
+
+      return this->edges_.emplace(num, std::move(edges)).first->second;
+    } // get_edges() }}}
+
+  public: // METHODS
+
+    /// constructor ('si' and 'implications' are as for tnba_complement)
+    lazy_complement(
+      const spot::const_twa_graph_ptr&  aut,
+      spot::scc_info&&                  si,
+      std::vector<bdd>&&                implications,
+      const spot::option_map&           om,
+      const compl_decomp_options&       decomp_options) :
+      spot::twa(aut->get_dict()),
+      om_(om),
+      aut_(aut),
+      si_(std::move(si)),
+      implications_(std::move(implications)),
+      decomp_options_(decomp_options),
+      comp_(aut_, si_, om_, implications_, decomp_options_)
+    { // {{{
+      this->comp_.prepare();
+      for (const auto& alg : this->comp_.alg_vec_) {
+        alg->fix_acc_cond();
+      }
+      this->init_vec_ = this->comp_.get_initial_uberstates(this->comp_.alg_vec_);
+      this->acc_ = tnba_complement::compute_acceptance(this->comp_.alg_vec_, true);
+
+      this->copy_ap_of(this->aut_);
+      this->set_acceptance(this->acc_.cond);
+    } // lazy_complement() }}}
+
+    virtual const spot::state* get_init_state() const override
+    { // {{{
+      if (this->init_vec_.size() == 1) {
+        return new lazy_compl_state(this->init_vec_[0]);
+      } else { // no or more initial uberstates
+        return new lazy_compl_state(NEW_INIT);
+      }
+    } // get_init_state() }}}
+
+    virtual spot::twa_succ_iterator* succ_iter(const spot::state* st) const override
+    { // {{{
+      unsigned num = static_cast<const lazy_compl_state*>(st)->get_num();
+      return new lazy_compl_succ_iterator(this->get_edges(num));
+    } // succ_iter() }}}
+
+    virtual std::string format_state(const spot::state* st) const override
+    { // {{{
+      unsigned num = static_cast<const lazy_compl_state*>(st)->get_num();
+      if (NEW_INIT == num) { return "INIT"; }
+      if (this->comp_.sink_state_ == num) { return "SINK"; }
+      return this->comp_.uberstate_to_string(this->comp_.num_to_uberstate(num));
+    } // format_state() }}}
+  }; // lazy_complement }}}
+
+
+  /// The intersection of several automata explored on the fly: a state is a
+  /// tuple of states of the automata, numbered in a tuple_table.  The
+  /// successors of a tuple are computed edge by edge of the components,
+  /// dropping a combination as soon as the conjunction of its labels is
+  /// false, and are kept for later queries.  The colours of the i-th
+  /// automaton are shifted behind those of the previous ones and the
+  /// acceptance condition is the conjunction of the (shifted) conditions.
+  class lazy_product : public spot::twa
+  { // {{{
+  private: // DATA MEMBERS
+
+    /// the intersected automata
+    std::vector<spot::const_twa_graph_ptr> auts_;
+    /// the first colour of every automaton
+    std::vector<unsigned> offsets_;
+    /// the tuples of states
+    mutable kofola::tuple_table states_;
+    /// already computed transitions
+    mutable std::unordered_map<unsigned, std::vector<lazy_compl_edge>> edges_;
+
+    /// adds to 'edges' the products of the edges of the components from
+    /// 'index' on; 'tuple' holds targets for the components before 'index'
+    void add_edges(
+      const unsigned*               src,
+      size_t                        index,
+      const bdd&                    cond,
+      spot::acc_cond::mark_t        acc,
+      std::vector<unsigned>&        tuple,
+      std::vector<lazy_compl_edge>& edges) const
+    { // {{{
+      if (this->auts_.size() == index) {
+        unsigned dst = this->states_.insert(tuple.data()).first;
+        edges.push_back({cond, dst, acc});
+        return;
+      }
+
+      for (const auto& e : this->auts_[index]->out(src[index])) {
+        bdd new_cond = cond & e.cond;
+        if (bddfalse == new_cond) { continue; }
+        tuple[index] = e.dst;
+        this->add_edges(src, index + 1, new_cond, acc | (e.acc << this->offsets_[index]),
+          tuple, edges);
+      }
+    } // add_edges() }}}
+
+    /// returns the transitions of a state (computes them if needed)
+    const std::vector<lazy_compl_edge>& get_edges(unsigned num) const
+    { // {{{
+      auto it = this->edges_.find(num);
+      if (this->edges_.end() != it) { return it->second; }
+
+      // stored tuples do not move when other ones are inserted
+      std::vector<unsigned> tuple(this->auts_.size());
+      std::vector<lazy_compl_edge> edges;
+      this->add_edges(this->states_[num], 0, bddtrue, {}, tuple, edges);
+
+      return this->edges_.emplace(num, std::move(edges)).first->second;
+    } // get_edges() }}}
+
+  public: // METHODS
+
+    /// constructor
+    explicit lazy_product(const std::vector<spot::twa_graph_ptr>& auts) :
+      spot::twa(auts.front()->get_dict()),
+      auts_(auts.begin(), auts.end()),
+      states_(auts.size())
+    { // {{{
+      spot::acc_cond::acc_code code = spot::acc_cond::acc_code::t();
+      unsigned num_sets = 0;
+      std::vector<unsigned> init;
+      for (const auto& aut : this->auts_) {
+        this->offsets_.push_back(num_sets);
+        code &= aut->get_acceptance() << num_sets;
+        num_sets += aut->num_sets();
+        init.push_back(aut->get_init_state_number());
+        this->copy_ap_of(aut);
+      }
+
+      this->set_acceptance(num_sets, code);
+      this->states_.insert(init.data());
+    } // lazy_product() }}}
+
+    virtual const spot::state* get_init_state() const override
+    { return new lazy_compl_state(0); }
+
+    virtual spot::twa_succ_iterator* succ_iter(const spot::state* st) const override
+    { // {{{
+      unsigned num = static_cast<const lazy_compl_state*>(st)->get_num();
+      return new lazy_compl_succ_iterator(this->get_edges(num));
+    } // succ_iter() }}}
+
+    virtual std::string format_state(const spot::state* st) const override
+    { // {{{
+      const unsigned* tuple = this->states_[static_cast<const lazy_compl_state*>(st)->get_num()];
+      std::string result = "(";
+      for (size_t i = 0; i < this->auts_.size(); ++i) {
+        if (i > 0) { result += ", "; }
+        result += std::to_string(tuple[i]);
+      }
+      return result + ")";
+    } // format_state() }}}
+  }; // lazy_product }}}
+
+
+  /// removes useless parts of 'aut' and reduces it using simulation (if
+  /// enabled); the implications computed by the simulation are stored into
+  /// 'implications'
+  static spot::twa_graph_ptr reduce_input(
     const spot::twa_graph_ptr& aut,
     spot::option_map&          om,
-    compl_decomp_options       decomp_options)
+    std::vector<bdd>&          implications)
   {
     const int trans_pruning = om.get(NUM_TRANS_PRUNING);
     // now we compute the simulator
-    spot::twa_graph_ptr aut_reduced;
-    std::vector<bdd> implications;
     spot::twa_graph_ptr aut_tmp = nullptr;
     if (om.get(USE_SIMULATION) > 0)
     {
@@ -2219,77 +3266,343 @@ namespace cola
       aut_tmp = aut2;
     }
     if (aut_tmp)
-      aut_reduced = aut_tmp;
+      return aut_tmp;
     else
-      aut_reduced = aut;
+      return aut;
+  }
 
-    spot::scc_info scc(aut_reduced, spot::scc_info_options::ALL);
 
-    if (decomp_options.scc_compl)
+  /// Runs 'tasks' in at most 'num_workers' child processes at a time and
+  /// returns their results.  BuDDy is not thread-safe, so the tasks cannot
+  /// run in threads; a forked child works on its own copy of the BDD manager
+  /// and passes its result back in HOA through a temporary file, which is
+  /// parsed over 'dict'.  The statistics collected by a child are passed back
+  /// in another file next to it and merged into STATS.  A budget_exceeded
+  /// thrown in a child is rethrown in the parent, other failures are reported
+  /// as std::runtime_error; the other children are then killed.  If a child
+  /// cannot be created, the task is run in this process.
+  static std::vector<spot::twa_graph_ptr> run_forked(
+    const std::vector<std::function<spot::twa_graph_ptr()>>& tasks,
+    unsigned                                                 num_workers,
+    const spot::bdd_dict_ptr&                                dict)
+  { // {{{
+    std::vector<spot::twa_graph_ptr> results(tasks.size());
+    std::vector<std::string> paths(tasks.size());
+    std::map<pid_t, size_t> running;
+
+    const char* tmp_dir = std::getenv("TMPDIR");
+    const std::string tmp_template = std::string((nullptr != tmp_dir)? tmp_dir : "/tmp") +
+      "/cola-part-XXXXXX";
+
+    // waits for one child and reads its result
+    auto wait_for_child = [&]() {
+        int status = 0;
+        const pid_t pid = waitpid(-1, &status, 0);
+        auto it = running.find(pid);
+        if (-1 == pid || running.end() == it) {
+          throw std::runtime_error("lost a child process complementing a part");
+        }
+        const size_t i = it->second;
+        running.erase(it);
+
+        const std::string stats_path = paths[i] + ".stats";
+        std::ifstream stats_in(stats_path);
+        if (!stats_in || !kofola::STATS.merge(stats_in)) {
+          kofola::STATS.add("children_without_stats", 1);
+        }
+        stats_in.close();
+        std::remove(stats_path.c_str());
+
+        const int code = WIFEXITED(status)? WEXITSTATUS(status) : -1;
+        if (0 == code) {
+          spot::automaton_stream_parser parser(paths[i]);
+          spot::parsed_aut_ptr parsed = parser.parse(dict);
+          std::ostringstream errors;
+          if (!parsed->format_errors(errors) && parsed->aut) {
+            results[i] = parsed->aut;
+            std::remove(paths[i].c_str());
+            return;
+          }
+        }
+
+        std::ifstream in(paths[i]);
+        std::string reason;
+        std::getline(in, reason);
+        std::remove(paths[i].c_str());
+        if (3 == code) { // budget_exceeded: resource and statistics
+          std::istringstream iss(reason);
+          std::string resource;
+          size_t num_states = 0, num_expanded = 0, todo_size = 0, max_partition_size = 0;
+          int max_partition = -1;
+          iss >> resource >> num_states >> num_expanded >> todo_size >>
+            max_partition >> max_partition_size;
+          throw kofola::budget_exceeded(resource, num_states, num_expanded, todo_size,
+            max_partition, max_partition_size);
+        }
+
+        throw std::runtime_error("complementation of a part failed" +
+          (reason.empty()? std::string() : ": " + reason));
+      };
+
+    // on a failure, the children still running are killed, so that they do
+    // not outlive cola, and their files are removed
+    auto kill_children = [&]() {
+        for (const auto& pid_index_pair : running) {
+          kill(pid_index_pair.first, SIGKILL);
+          waitpid(pid_index_pair.first, nullptr, 0);
+          std::remove(paths[pid_index_pair.second].c_str());
+          std::remove((paths[pid_index_pair.second] + ".stats").c_str());
+        }
+        running.clear();
+      };
+
+    try {
+      for (size_t i = 0; i < tasks.size(); ++i) {
+        while (running.size() >= num_workers) { wait_for_child(); }
+
+        std::vector<char> path(tmp_template.begin(), tmp_template.end());
+        path.push_back('\0');
+        const int fd = mkstemp(path.data());
+        if (-1 == fd) {
+          results[i] = tasks[i]();
+          continue;
+        }
+        close(fd);
+        paths[i] = path.data();
+
+        std::cout.flush();
+        std::cerr.flush();
+        const pid_t pid = fork();
+        if (-1 == pid) {
+          std::remove(paths[i].c_str());
+          results[i] = tasks[i]();
+          continue;
+        }
+
+        if (0 == pid) { // child
+          kofola::STATS.clear();   // only the statistics of this part go back
+          int code = 0;
+          std::ofstream out(paths[i]);
+          try {
+            spot::print_hoa(out, tasks[i]()) << "\n";
+          } catch (const kofola::budget_exceeded& e) {
+            out.seekp(0);
+            out << e.resource << " " << e.num_states << " " << e.num_expanded <<
+              " " << e.todo_size << " " << e.max_partition << " " <<
+              e.max_partition_size << "\n";
+            code = 3;
+          } catch (const std::exception& e) {
+            out.seekp(0);
+            out << e.what() << "\n";
+            code = 1;
+          } catch (...) { // must not reach the handler of the parent below
+            code = 1;
+          }
+          out.close();
+          std::ofstream stats_out(paths[i] + ".stats");
+          kofola::STATS.save(stats_out);
+          stats_out.close();
+          _exit((0 == code && !out)? 1 : code);
+        }
+
+        running[pid] = i;
+      }
+
+      while (!running.empty()) { wait_for_child(); }
+    } catch (...) {
+      kill_children();
+      throw;
+    }
+
+    return results;
+  } // run_forked() }}}
+
+
+  /// returns the postprocessor for the complements of parts (see
+  /// complement_parts()) and their products
+  static spot::postprocessor get_part_postprocessor(
+    const compl_decomp_options& decomp_options)
+  { // {{{
+    spot::postprocessor p_post;
+    p_post.set_type(spot::postprocessor::Generic);
+    if (decomp_options.low_red_interm) {
+      p_post.set_level(spot::postprocessor::Low);
+    } else {
+      p_post.set_level(spot::postprocessor::High);
+    }
+
+    return p_post;
+  } // get_part_postprocessor() }}}
+
+
+  /// saturates (if enabled) and decomposes 'aut_reduced' and complements its
+  /// parts separately (in parallel with more threads); 'aut_reduced' and
+  /// 'scc' are updated by the saturation; returns no automata if there is
+  /// nothing to decompose
+  static std::vector<spot::twa_graph_ptr> complement_parts(
+    spot::twa_graph_ptr&        aut_reduced,
+    spot::scc_info&             scc,
+    spot::option_map&           om,
+    std::vector<bdd>&           implications,
+    const compl_decomp_options& decomp_options)
+  { // {{{
+    if (!decomp_options.checkpoint_file.empty() || !decomp_options.resume_file.empty()) {
+      throw std::runtime_error("checkpoints cannot be used when SCCs are complemented separately");
+    }
+
+    // saturation
+    if (decomp_options.sat)
     {
-      // saturation
-      if (decomp_options.sat)
-      {
-        aut_reduced = saturation(aut_reduced, scc);
-        spot::scc_info scc_sat(aut_reduced, spot::scc_info_options::ALL);
-        scc = scc_sat;
+      kofola::phase_timer timer("saturation");
+      aut_reduced = saturation(aut_reduced, scc);
+      spot::scc_info scc_sat(aut_reduced, spot::scc_info_options::ALL);
+      scc = scc_sat;
+    }
+
+    // decompose source automaton
+    kofola::phase_timer partitioning_timer("partitioning");
+    cola::decomposer decomp(aut_reduced, om);
+    auto decomposed = decomp.run(true, decomp_options.merge_iwa, decomp_options.merge_det);
+    partitioning_timer.stop();
+
+    spot::postprocessor p_pre;
+    p_pre.set_type(spot::postprocessor::Buchi);
+    p_pre.set_level(spot::postprocessor::High);
+
+    spot::postprocessor p_post = get_part_postprocessor(decomp_options);
+
+    // complements one part
+    auto complement_part = [&](const spot::twa_graph_ptr& part,
+                               compl_decomp_options part_options) {
+        auto aut_preprocessed = p_pre.run(part);
+        spot::scc_info part_scc(aut_preprocessed, spot::scc_info_options::ALL);
+
+        auto comp = cola::tnba_complement(aut_preprocessed, part_scc, om, implications, part_options);
+        auto dec_aut = comp.run_new();
+        // postprocessing for each automaton
+        kofola::phase_timer timer("postprocessing");
+        return p_post.run(dec_aut);
+      };
+
+    std::vector<spot::twa_graph_ptr> result;
+    if (decomp_options.threads > 1 && decomposed.size() > 1)
+    { // the parts are complemented in parallel, each one sequentially
+      compl_decomp_options part_options = decomp_options;
+      part_options.threads = 1;
+      std::vector<std::function<spot::twa_graph_ptr()>> tasks;
+      for (const auto& part : decomposed) {
+        tasks.push_back([&, part]() { return complement_part(part, part_options); });
+      }
+      result = run_forked(tasks, decomp_options.threads, aut_reduced->get_dict());
+    }
+    else
+    {
+      for (const auto& part : decomposed) {
+        result.push_back(complement_part(part, decomp_options));
       }
+    }
+
+    return result;
+  } // complement_parts() }}}
+
+
+  /// intersects the complements of parts (see complement_parts())
+  static spot::twa_graph_ptr intersect_parts(
+    std::vector<spot::twa_graph_ptr> auts,
+    const compl_decomp_options&      decomp_options)
+  { // {{{
+    assert(!auts.empty());
+    spot::postprocessor p_post = get_part_postprocessor(decomp_options);
 
-      // decompose source automaton
-      cola::decomposer decomp(aut_reduced, om);
-      auto decomposed = decomp.run(true, decomp_options.merge_iwa, decomp_options.merge_det);
+    if (decomp_options.lazy_product && auts.size() > 1)
+    { // only the reachable part of the product is built, reduced once
+      auto product = std::make_shared<lazy_product>(auts);
+      return p_post.run(spot::make_twa_graph(product, spot::twa::prop_set::all()));
+    }
+    else if (decomp_options.threads > 1)
+    {
+      // the products are reduced as a balanced tree, pairing the smallest
+      // automata in every round
+      while (auts.size() > 1) {
+        std::sort(auts.begin(), auts.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs->num_states() < rhs->num_states();
+          });
+
+        std::vector<std::function<spot::twa_graph_ptr()>> tasks;
+        for (size_t i = 0; i + 1 < auts.size(); i += 2) {
+          DEBUG_PRINT_LN("product of sizes " + std::to_string(auts[i]->num_states()) +
+            " and " + std::to_string(auts[i+1]->num_states()));
+          spot::twa_graph_ptr first_aut = auts[i];
+          spot::twa_graph_ptr second_aut = auts[i+1];
+          tasks.push_back([&, first_aut, second_aut]() {
+              return p_post.run(spot::product(first_aut, second_aut));
+            });
+        }
 
-      if (decomposed.size() > 0)
+        std::vector<spot::twa_graph_ptr> products = run_forked(tasks,
+          decomp_options.threads, auts.front()->get_dict());
+        if (auts.size() % 2 == 1) { products.push_back(auts.back()); }
+        auts = std::move(products);
+      }
+
+      return auts.front();
+    }
+    else
+    {
+      // comparison for priority queue - smallest automata should be at top
+      auto aut_cmp = [](const auto& lhs, const auto& rhs){ return lhs->num_states() > rhs->num_states();};
+      std::priority_queue<spot::twa_graph_ptr,
+        std::vector<spot::twa_graph_ptr>, decltype(aut_cmp)> aut_queue(aut_cmp);
+      for (auto part : auts)
       {
-        std::vector<spot::twa_graph_ptr> part_res;
+        aut_queue.push(part);
+      }
+
+      while (aut_queue.size() > 1) { // until single aut remains
+        auto first_aut = aut_queue.top();
+        aut_queue.pop();
+        DEBUG_PRINT_LN("first_aut size = " + std::to_string(first_aut->num_states()));
+        auto second_aut = aut_queue.top();
+        aut_queue.pop();
+        DEBUG_PRINT_LN("second_aut size = " + std::to_string(second_aut->num_states()));
+        auto product = spot::product(first_aut, second_aut);
+        product = p_post.run(product);
+        aut_queue.push(product);
+      }
 
-        spot::postprocessor p_pre;
-        p_pre.set_type(spot::postprocessor::Buchi);
-        p_pre.set_level(spot::postprocessor::High);
+      return aut_queue.top();
+    }
+  } // intersect_parts() }}}
 
-        spot::postprocessor p_post;
-        p_post.set_type(spot::postprocessor::Generic);
-        if (decomp_options.low_red_interm) {
-          p_post.set_level(spot::postprocessor::Low);
-        } else {
-          p_post.set_level(spot::postprocessor::High);
+
+  /// complements 'aut'; if 'os' is not nullptr, the result is written to
+  /// 'os' in HOA (streamed if possible) and nullptr is returned
+  static spot::twa_graph_ptr complement_tnba_impl(
+    const spot::twa_graph_ptr& aut,
+    spot::option_map&          om,
+    compl_decomp_options       decomp_options,
+    std::ostream*              os)
+  {
+    std::vector<bdd> implications;
+    kofola::phase_timer simulation_timer("simulation");
+    spot::twa_graph_ptr aut_reduced = reduce_input(aut, om, implications);
+    simulation_timer.stop();
+
+    if (decomp_options.scc_compl)
+    {
+      spot::scc_info scc(aut_reduced, spot::scc_info_options::ALL);
+      auto parts = complement_parts(aut_reduced, scc, om, implications, decomp_options);
+      if (!parts.empty())
+      {
+        kofola::phase_timer postprocessing_timer("postprocessing");
+        spot::twa_graph_ptr result = intersect_parts(parts, decomp_options);
+        postprocessing_timer.stop();
+        if (nullptr != os) { // the product cannot be streamed
+          spot::print_hoa(*os, result);
+          return nullptr;
         }
 
-        // comparison for priority queue - smallest automata should be at top
-        auto aut_cmp = [](const auto& lhs, const auto& rhs){ return lhs->num_states() > rhs->num_states();};
-        std::priority_queue<spot::twa_graph_ptr,
-          std::vector<spot::twa_graph_ptr>, decltype(aut_cmp)> aut_queue(aut_cmp);
-        for (auto aut : decomposed)
-        {
-          // if (decomp_options.scc_compl_high)
-          //   p.set_level(spot::postprocessor::High);
-          // else
-          //   p.set_level(spot::postprocessor::Low);
-          // complement each automaton
-          auto aut_preprocessed = p_pre.run(aut);
-          spot::scc_info part_scc(aut_preprocessed, spot::scc_info_options::ALL);
-
-          auto comp = cola::tnba_complement(aut_preprocessed, part_scc, om, implications, decomp_options);
-          auto dec_aut = comp.run_new();
-          // postprocessing for each automaton
-          // part_res.push_back(p_post.run(dec_aut));
-          aut_queue.push(p_post.run(dec_aut));
-        }
-
-        assert(!aut_queue.empty());
-        while (aut_queue.size() > 1) { // until single aut remains
-          auto first_aut = aut_queue.top();
-          aut_queue.pop();
-          DEBUG_PRINT_LN("first_aut size = " + std::to_string(first_aut->num_states()));
-          auto second_aut = aut_queue.top();
-          aut_queue.pop();
-          DEBUG_PRINT_LN("second_aut size = " + std::to_string(second_aut->num_states()));
-          auto result = spot::product(first_aut, second_aut);
-          result = p_post.run(result);
-          aut_queue.push(result);
-        }
-
-        return aut_queue.top();
+        return result;
       }
     }
 
@@ -2299,13 +3612,20 @@ namespace cola
     p.set_level(spot::postprocessor::High);
     spot::const_twa_graph_ptr aut_to_compl;
     aut_to_compl = p.run(aut_reduced);
+    // the SCCs are of the automaton to complement, so that they are reused
+    spot::scc_info scc(aut_to_compl, spot::scc_info_options::ALL);
 
     auto comp = cola::tnba_complement(aut_to_compl, scc, om, implications, decomp_options);
+    comp.set_hoa_stream(os);
     auto res = comp.run_new();
     DEBUG_PRINT_LN("finished call to run_new()");
+    if (nullptr != os) { // already written
+      return nullptr;
+    }
 
     // postprocessing
     if (!decomp_options.raw) {
+      kofola::phase_timer timer("postprocessing");
       spot::postprocessor p_post;
       if (decomp_options.tba) {
         p_post.set_type(spot::postprocessor::Buchi);
@@ -2319,4 +3639,56 @@ namespace cola
 
     return res;
   }
+
+
+  spot::twa_graph_ptr complement_tnba(
+    const spot::twa_graph_ptr& aut,
+    spot::option_map&          om,
+    compl_decomp_options       decomp_options)
+  {
+    return complement_tnba_impl(aut, om, decomp_options, nullptr);
+  }
+
+
+  void complement_tnba_stream(
+    const spot::twa_graph_ptr& aut,
+    spot::option_map&          om,
+    compl_decomp_options       decomp_options,
+    std::ostream&              os)
+  {
+    complement_tnba_impl(aut, om, decomp_options, &os);
+  }
+
+
+  spot::twa_ptr complement_tnba_lazy(
+    const spot::twa_graph_ptr& aut,
+    spot::option_map&          om,
+    compl_decomp_options       decomp_options)
+  {
+    std::vector<bdd> implications;
+    kofola::phase_timer simulation_timer("simulation");
+    spot::twa_graph_ptr aut_reduced = reduce_input(aut, om, implications);
+    simulation_timer.stop();
+
+    if (decomp_options.scc_compl)
+    { // the parts are complemented fully, only their product is lazy
+      spot::scc_info scc(aut_reduced, spot::scc_info_options::ALL);
+      auto parts = complement_parts(aut_reduced, scc, om, implications, decomp_options);
+      if (parts.size() == 1) {
+        return parts.front();
+      } else if (!parts.empty()) {
+        return std::make_shared<lazy_product>(parts);
+      }
+    }
+
+    // make sure the input is a BA
+    spot::postprocessor p;
+    p.set_type(spot::postprocessor::Buchi);
+    p.set_level(spot::postprocessor::High);
+    spot::const_twa_graph_ptr aut_to_compl = p.run(aut_reduced);
+    spot::scc_info scc(aut_to_compl, spot::scc_info_options::ALL);
+
+    return std::make_shared<lazy_complement>(aut_to_compl, std::move(scc),
+      std::move(implications), om, decomp_options);
+  }
 }
@@ -32,7 +32,7 @@ decomposer::run(bool nonacc_pred, bool merge_iwa, bool merge_det)
     std::vector<spot::twa_graph_ptr> result;
     spot::scc_info si(nba_, spot::scc_info_options::ALL);
 
-    std::vector<bool> reach_sccs = find_scc_paths(si);
+    kofola::scc_reachability reach(si);
 
     struct pair_compare
     {
@@ -93,7 +93,7 @@ decomposer::run(bool nonacc_pred, bool merge_iwa, bool merge_det)
             continue;
         }
 
-        spot::twa_graph_ptr aut = make_twa_with_scc(si, sccs, reach_sccs, nonacc_pred);
+        spot::twa_graph_ptr aut = make_twa_with_scc(si, sccs, reach, nonacc_pred);
         result.push_back(aut);
 
         -- num_nbas_;
@@ -113,22 +113,17 @@ decomposer::run(bool nonacc_pred, bool merge_iwa, bool merge_det)
     }
     if (! remaining_sccs.empty())
     {
-        spot::twa_graph_ptr aut = make_twa_with_scc(si, remaining_sccs, reach_sccs, nonacc_pred, merge_iwa, merge_det);
+        spot::twa_graph_ptr aut = make_twa_with_scc(si, remaining_sccs, reach, nonacc_pred, merge_iwa, merge_det);
         result.push_back(aut);
     }
     return result;
 }
 
 spot::twa_graph_ptr
-decomposer::make_twa_with_scc(spot::scc_info& si, std::set<unsigned> sccs, std::vector<bool>& reach_sccs, bool nonacc_pred, bool merge_iwa, bool merge_det)
+decomposer::make_twa_with_scc(spot::scc_info& si, std::set<unsigned> sccs, const kofola::scc_reachability& reach, bool nonacc_pred, bool merge_iwa, bool merge_det)
 {
     assert(! sccs.empty());
 
-    auto scc_reach = [&si, &reach_sccs](unsigned s, unsigned t) -> bool
-    {
-      return s == t || (reach_sccs[t + si.scc_count() * s]);
-    };
-    
     // now construct new DPAs
     spot::twa_graph_ptr res = spot::make_twa_graph(nba_->get_dict());
     res->copy_ap_of(nba_);
@@ -144,17 +139,16 @@ decomposer::make_twa_with_scc(spot::scc_info& si, std::set<unsigned> sccs, std::
     {
       res->new_state();
     }
-    auto is_good_scc = [&scc_reach, &sccs](unsigned scc_i) -> bool
+    // the SCCs that can reach some of the selected SCCs (computed once, so
+    // that checking an edge takes constant time)
+    kofola::state_bitset good_sccs;
+    for (auto scc : sccs)
     {
-        for(auto scc : sccs)
-        {
-            if (scc == scc_i) return true;
-            if (scc_reach(scc_i, scc))
-            {
-                return true;
-            }
-        }
-        return false;
+        good_sccs |= reach.pred_sccs(scc);
+    }
+    auto is_good_scc = [&good_sccs](unsigned scc_i) -> bool
+    {
+        return good_sccs.contains(scc_i);
     };
     for (auto &t : nba_->edges())
     {
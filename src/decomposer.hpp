@@ -13,6 +13,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "kofola.hpp"
+#include "reachability.hpp"
 
 #include <functional>
 #include <set>
@@ -34,7 +35,7 @@ namespace cola
         int num_nbas_;
 
         spot::twa_graph_ptr
-        make_twa_with_scc(spot::scc_info& si, std::set<unsigned> sccs, std::vector<bool>& reach_sccs, bool nonacc_pred = false, bool merge_iwa = false, bool merge_det = false);
+        make_twa_with_scc(spot::scc_info& si, std::set<unsigned> sccs, const kofola::scc_reachability& reach, bool nonacc_pred = false, bool merge_iwa = false, bool merge_det = false);
 
         public:
         decomposer(spot::twa_graph_ptr &nba, spot::option_map& om)
@@ -19,8 +19,10 @@
 #include "kofola.hpp"
 #include "simulation.hpp"
 #include "types.hpp"
+#include "checkpoint.hpp"
 //#include "struct.hpp"
 
+#include <chrono>
 #include <deque>
 #include <map>
 #include <set>
@@ -1645,14 +1647,184 @@ public:
     res_->set_acceptance(num_sets, acceptance);
   }
 
+  // the kind of checkpoints of the determinization
+  static constexpr const char* CHECKPOINT_KIND = "determinize";
+
+  void
+  save_labels(kofola::checkpoint_writer &out, const std::vector<label> &labels)
+  {
+    out.write_uint(labels.size());
+    for (const auto &lab : labels)
+    {
+      out.write_uint(lab.first);
+      out.write_int(lab.second);
+    }
+  }
+
+  std::vector<label>
+  load_labels(kofola::checkpoint_reader &in)
+  {
+    std::vector<label> labels(in.read_uint());
+    for (auto &lab : labels)
+    {
+      lab.first = in.read_uint();
+      lab.second = in.read_int();
+    }
+    return labels;
+  }
+
+  void
+  save_mstate(kofola::checkpoint_writer &out, const tnba_mstate &ms)
+  {
+    out.write_uint_range(ms.weak_set_);
+    out.write_uint_range(ms.break_set_);
+    for (const auto &labels : ms.detscc_labels_)
+      save_labels(out, labels);
+    for (unsigned i = 0; i < ms.nondetscc_labels_.size(); i++)
+    {
+      save_labels(out, ms.nondetscc_labels_[i]);
+      out.write_int_range(ms.nondetscc_breaces_[i]);
+    }
+  }
+
+  tnba_mstate
+  load_mstate(kofola::checkpoint_reader &in)
+  {
+    tnba_mstate ms(si_, acc_detsccs_.size(), acc_nondetsccs_.size());
+    for (unsigned s : in.read_uint_vector())
+      ms.weak_set_.insert(s);
+    for (unsigned s : in.read_uint_vector())
+      ms.break_set_.insert(s);
+    for (auto &labels : ms.detscc_labels_)
+      labels = load_labels(in);
+    for (unsigned i = 0; i < ms.nondetscc_labels_.size(); i++)
+    {
+      ms.nondetscc_labels_[i] = load_labels(in);
+      ms.nondetscc_breaces_[i] = in.read_int_vector();
+    }
+    return ms;
+  }
+
+  // writes the macrostates (in the order of their numbers), the edges built
+  // so far with their colours, and the states to process into a checkpoint
+  void
+  save_checkpoint(const std::string &path)
+  {
+    kofola::checkpoint_writer out(path, CHECKPOINT_KIND, om_.get_str(CHECKPOINT_OPTIONS), aut_);
+    std::vector<const tnba_mstate *> states(res_->num_states(), nullptr);
+    for (const auto &p : rank2n_)
+      states[p.second] = &p.first;
+    out.write_uint(states.size());
+    for (const tnba_mstate *ms : states)
+      save_mstate(out, *ms);
+    out.write_uint(res_->get_init_state_number());
+
+    out.write_uint(res_->num_edges());
+    for (const auto &t : res_->edges())
+    {
+      out.write_uint(t.src);
+      out.write_uint(t.dst);
+      out.write_bdd(t.cond);
+      out.write_int_range(trans2colors_.at(std::make_pair(t.src, t.cond)));
+    }
+    out.write_int_range(max_colors_);
+    out.write_int_range(min_colors_);
+
+    out.write_uint(todo_.size());
+    for (const auto &p : todo_)
+      out.write_uint(p.second);
+    out.commit();
+
+    if (om_.get(VERBOSE_LEVEL) >= 1)
+      std::cout << "Checkpoint " << path << " written: #States: " << res_->num_states()
+                << " #To process: " << todo_.size() << std::endl;
+  }
+
+  // replaces the construction by the one from a checkpoint written by
+  // save_checkpoint() for the same input and options
+  void
+  load_checkpoint(const std::string &path)
+  {
+    kofola::checkpoint_reader in(path, CHECKPOINT_KIND, om_.get_str(CHECKPOINT_OPTIONS), aut_);
+    rank2n_.clear();
+    trans2colors_.clear();
+    todo_.clear();
+    if (show_names_)
+      names_->clear();
+
+    unsigned num_states = in.read_uint();
+    if (num_states < res_->num_states())
+      in.fail("too few states");
+    std::vector<const tnba_mstate *> states;
+    for (unsigned i = 0; i < num_states; i++)
+    {
+      tnba_mstate ms = load_mstate(in);
+      if (i >= res_->num_states())
+        res_->new_state();
+      if (show_names_)
+        names_->push_back(get_name(ms));
+      auto p = rank2n_.emplace(ms, i);
+      if (!p.second)
+        in.fail("repeated macrostate");
+      states.push_back(&p.first->first);
+    }
+    unsigned init_state = in.read_uint();
+    if (init_state >= num_states)
+      in.fail("invalid initial state");
+    res_->set_init_state(init_state);
+
+    for (uint64_t num_edges = in.read_uint(); num_edges > 0; num_edges--)
+    {
+      unsigned src = in.read_uint();
+      unsigned dst = in.read_uint();
+      if (src >= num_states || dst >= num_states)
+        in.fail("invalid edge");
+      bdd letter = in.read_bdd();
+      res_->new_edge(src, dst, letter);
+      trans2colors_.emplace(std::make_pair(src, letter), in.read_int_vector());
+    }
+    std::vector<int> max_colors = in.read_int_vector();
+    std::vector<int> min_colors = in.read_int_vector();
+    if (max_colors.size() != max_colors_.size() || min_colors.size() != min_colors_.size())
+      in.fail("other accepting SCCs");
+    max_colors_ = max_colors;
+    min_colors_ = min_colors;
+
+    for (unsigned num : in.read_uint_vector())
+    {
+      if (num >= num_states)
+        in.fail("invalid state to process");
+      todo_.emplace_back(*states[num], num);
+    }
+
+    if (om_.get(VERBOSE_LEVEL) >= 1)
+      std::cout << "Resumed from checkpoint " << path << ": #States: " << res_->num_states()
+                << " #To process: " << todo_.size() << std::endl;
+  }
+
   spot::twa_graph_ptr
   run()
   {
+    // continue from a checkpoint and write checkpoints periodically
+    const std::string resume_file = om_.get_str(RESUME_FILE);
+    if (!resume_file.empty())
+      load_checkpoint(resume_file);
+    const std::string checkpoint_file = om_.get_str(CHECKPOINT_FILE);
+    const std::chrono::seconds checkpoint_interval(om_.get(CHECKPOINT_INTERVAL, 600));
+    auto last_checkpoint = std::chrono::steady_clock::now();
+
     // Main stuff happens here
     // std::unordered_map<bdd, std::vector<bdd>, spot::bdd_hash> cache;
     // todo_ is a queue for handling states
     while (!todo_.empty())
     {
+      if (!checkpoint_file.empty() &&
+          std::chrono::steady_clock::now() - last_checkpoint >= checkpoint_interval)
+      {
+        save_checkpoint(checkpoint_file);
+        last_checkpoint = std::chrono::steady_clock::now();
+      }
+
       auto top = todo_.front();
       todo_.pop_front();
       // pop current state, (N, Rnk)
@@ -0,0 +1,141 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// open-addressing hash index for numbered objects
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <spot/misc/hashfunc.hh>
+
+namespace kofola { // {{{
+
+/// mixes the hash of 'value' into 'seed'
+inline size_t hash_combine(size_t seed, size_t value)
+{ // {{{
+  return seed ^ (spot::wang32_hash(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+} // hash_combine() }}}
+
+/// computes a hash of a range of integral values
+template <class It>
+size_t hash_range(It begin, It end, size_t seed = 0)
+{ // {{{
+  for (; begin != end; ++begin) {
+    seed = hash_combine(seed, static_cast<size_t>(*begin));
+  }
+
+  return seed;
+} // hash_range() }}}
+
+
+/// An open-addressing (linear probing) index over objects that are stored
+/// elsewhere and identified by their numbers.  Every slot keeps the hash of
+/// the object together with its number, so the (possibly expensive) equality
+/// test is only called for objects with the same hash, and rehashing never
+/// needs to touch the objects themselves.
+class hash_index
+{ // {{{
+public: // CONSTANTS
+
+  /// returned by find() if no equal object is present
+  static const unsigned NOT_FOUND = UINT_MAX;
+
+private: // TYPES
+
+  struct slot
+  {
+    size_t hash;
+    unsigned id;    // NOT_FOUND marks an empty slot
+  };
+
+private: // DATA MEMBERS
+
+  /// the table (its size is always a power of two)
+  std::vector<slot> slots_;
+  /// number of occupied slots
+  size_t size_ = 0;
+
+  /// doubles the size of the table
+  void grow()
+  { // {{{
+    std::vector<slot> old(slots_.size() * 2, slot{0, NOT_FOUND});
+    old.swap(slots_);
+    const size_t mask = slots_.size() - 1;
+    for (const slot& sl : old) {
+      if (NOT_FOUND == sl.id) { continue; }
+      size_t pos = sl.hash & mask;
+      while (NOT_FOUND != slots_[pos].id) { pos = (pos + 1) & mask; }
+      slots_[pos] = sl;
+    }
+  } // grow() }}}
+
+public: // METHODS
+
+  /// constructor ('capacity' is rounded up to a power of two)
+  explicit hash_index(size_t capacity = 64)
+  { // {{{
+    size_t cap = 16;
+    while (cap < capacity) { cap *= 2; }
+    slots_.assign(cap, slot{0, NOT_FOUND});
+  } // hash_index() }}}
+
+  /// returns the number of an object with the hash 'hash' for which
+  /// 'eq(number)' holds, or NOT_FOUND
+  template <class Eq>
+  unsigned find(size_t hash, Eq&& eq) const
+  { // {{{
+    const size_t mask = slots_.size() - 1;
+    for (size_t pos = hash & mask; ; pos = (pos + 1) & mask) {
+      const slot& sl = slots_[pos];
+      if (NOT_FOUND == sl.id) { return NOT_FOUND; }
+      if (sl.hash == hash && eq(sl.id)) { return sl.id; }
+    }
+  } // find() }}}
+
+  /// looks up an object equal (wrt 'eq') to an object with the hash 'hash';
+  /// if there is none, 'id' is inserted; returns the number of the object in
+  /// the index and whether an insertion happened
+  template <class Eq>
+  std::pair<unsigned, bool> insert(size_t hash, unsigned id, Eq&& eq)
+  { // {{{
+    if (2 * (size_ + 1) > slots_.size()) { this->grow(); }
+
+    const size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    for ( ; NOT_FOUND != slots_[pos].id; pos = (pos + 1) & mask) {
+      const slot& sl = slots_[pos];
+      if (sl.hash == hash && eq(sl.id)) { return {sl.id, false}; }
+    }
+
+    slots_[pos] = slot{hash, id};
+    ++size_;
+    return {id, true};
+  } // insert() }}}
+
+  /// number of indexed objects
+  size_t size() const { return size_; }
+
+  /// removes all objects from the index
+  void clear()
+  { // {{{
+    slots_.assign(slots_.size(), slot{0, NOT_FOUND});
+    size_ = 0;
+  } // clear() }}}
+}; // hash_index }}}
+
+} // namespace kofola }}}
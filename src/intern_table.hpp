@@ -0,0 +1,314 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// tables storing every distinct object only once and numbering them
+
+#pragma once
+
+#include "hash_index.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace kofola { // {{{
+
+/// hash functor for containers of integral values
+struct range_hash
+{
+  template <class C>
+  size_t operator()(const C& cont) const
+  { return hash_range(cont.begin(), cont.end()); }
+};
+
+
+/// Stores every distinct value only once and numbers the values
+/// consecutively from 0.  References to stored values stay valid during the
+/// whole lifetime of the table.
+template <class T, class Hash = std::hash<T>, class Equal = std::equal_to<T>>
+class intern_table
+{ // {{{
+private: // DATA MEMBERS
+
+  /// the values (deque in order not to invalidate references)
+  std::deque<T> values_;
+  /// hash index over 'values_'
+  hash_index index_;
+
+  Hash hasher_;
+  Equal equal_;
+
+public: // METHODS
+
+  /// inserts a value (if not present); returns its number and whether an
+  /// insertion happened
+  template <class U>
+  std::pair<unsigned, bool> insert(U&& value)
+  { // {{{
+    auto id_bool_pair = this->index_.insert(this->hasher_(value),
+      this->values_.size(),
+      [&](unsigned id){ return this->equal_(this->values_[id], value); });
+    if (id_bool_pair.second) {
+      this->values_.emplace_back(std::forward<U>(value));
+    }
+
+    return id_bool_pair;
+  } // insert() }}}
+
+  /// returns the number of a value, or hash_index::NOT_FOUND
+  unsigned find(const T& value) const
+  { // {{{
+    return this->index_.find(this->hasher_(value),
+      [&](unsigned id){ return this->equal_(this->values_[id], value); });
+  } // find() }}}
+
+  /// returns the value with the given number
+  const T& operator[](unsigned id) const
+  { // {{{
+    assert(id < this->values_.size());
+    return this->values_[id];
+  } // operator[] }}}
+
+  /// number of stored values
+  size_t size() const { return this->values_.size(); }
+}; // intern_table }}}
+
+
+/// Stores distinct tuples of numbers of a fixed width and numbers them
+/// consecutively from 0.  The tuples are kept one after another in large
+/// chunks of memory that are never moved, so pointers to stored tuples stay
+/// valid.  Tuples are hashed and compared as raw memory.
+class tuple_table
+{ // {{{
+private: // CONSTANTS
+
+  /// number of tuples in one chunk
+  static const size_t CHUNK_TUPLES = 4096;
+
+private: // DATA MEMBERS
+
+  /// number of elements of every tuple
+  size_t width_;
+  /// the storage
+  std::vector<std::unique_ptr<unsigned[]>> chunks_;
+  /// number of stored tuples
+  size_t size_ = 0;
+  /// hash index over the stored tuples
+  hash_index index_;
+
+  /// copies a tuple at the end of the storage
+  void push(const unsigned* tuple)
+  { // {{{
+    if (this->size_ == this->chunks_.size() * CHUNK_TUPLES) {
+      this->chunks_.emplace_back(new unsigned[CHUNK_TUPLES * this->width_]);
+    }
+    unsigned* dst = this->chunks_.back().get() +
+      (this->size_ % CHUNK_TUPLES) * this->width_;
+    std::memcpy(dst, tuple, this->width_ * sizeof(unsigned));
+    ++this->size_;
+  } // push() }}}
+
+public: // METHODS
+
+  /// constructor
+  explicit tuple_table(size_t width = 0) : width_(width)
+  { }
+
+  /// computes the hash of a tuple
+  size_t hash_tuple(const unsigned* tuple) const
+  { return hash_range(tuple, tuple + this->width_); }
+
+  /// inserts a tuple (if not present); returns its number and whether an
+  /// insertion happened
+  std::pair<unsigned, bool> insert(const unsigned* tuple)
+  { return this->insert(tuple, this->hash_tuple(tuple)); }
+
+  /// inserts a tuple with a precomputed hash
+  std::pair<unsigned, bool> insert(const unsigned* tuple, size_t hash)
+  { // {{{
+    auto id_bool_pair = this->index_.insert(hash,
+      this->size_,
+      [&](unsigned id){
+        return 0 == std::memcmp((*this)[id], tuple, this->width_ * sizeof(unsigned));
+      });
+    if (id_bool_pair.second) { this->push(tuple); }
+
+    return id_bool_pair;
+  } // insert() }}}
+
+  /// appends a tuple without indexing it (it will never be found by
+  /// insert()); useful for placeholders; returns its number
+  unsigned append(const unsigned* tuple)
+  { // {{{
+    this->push(tuple);
+    return this->size_ - 1;
+  } // append() }}}
+
+  /// returns the tuple with the given number
+  const unsigned* operator[](unsigned id) const
+  { // {{{
+    assert(id < this->size_);
+    return this->chunks_[id / CHUNK_TUPLES].get() + (id % CHUNK_TUPLES) * this->width_;
+  } // operator[] }}}
+
+  /// number of stored tuples
+  size_t size() const { return this->size_; }
+
+  /// number of elements of every tuple
+  size_t width() const { return this->width_; }
+}; // tuple_table }}}
+
+
+/// Thread-safe variant of intern_table (all operations take a lock).
+template <class T, class Hash = std::hash<T>, class Equal = std::equal_to<T>>
+class concurrent_intern_table
+{ // {{{
+private: // DATA MEMBERS
+
+  intern_table<T, Hash, Equal> table_;
+  mutable std::mutex mtx_;
+
+public: // METHODS
+
+  /// see intern_table::insert()
+  template <class U>
+  std::pair<unsigned, bool> insert(U&& value)
+  { // {{{
+    std::lock_guard<std::mutex> lock(this->mtx_);
+    return this->table_.insert(std::forward<U>(value));
+  } // insert() }}}
+
+  /// see intern_table::operator[]() (the reference stays valid)
+  const T& operator[](unsigned id) const
+  { // {{{
+    std::lock_guard<std::mutex> lock(this->mtx_);
+    return this->table_[id];
+  } // operator[] }}}
+
+  /// number of stored values
+  size_t size() const
+  { // {{{
+    std::lock_guard<std::mutex> lock(this->mtx_);
+    return this->table_.size();
+  } // size() }}}
+}; // concurrent_intern_table }}}
+
+
+/// Thread-safe variant of tuple_table.  Tuples are distributed among shards
+/// (according to their hashes) with separate locks, so threads inserting
+/// different tuples rarely wait for each other.  The number of a tuple is
+/// (number within the shard) * (number of shards) + (index of the shard),
+/// i.e., the numbers are unique, but with more than one shard they are not
+/// consecutive.
+class concurrent_tuple_table
+{ // {{{
+private: // TYPES
+
+  struct shard
+  {
+    tuple_table table;
+    std::mutex mtx;
+
+    explicit shard(size_t width) : table(width) { }
+  };
+
+private: // DATA MEMBERS
+
+  size_t width_;
+  std::vector<std::unique_ptr<shard>> shards_;
+
+  /// selects the shard for a hash (uses other bits than the hash index)
+  size_t shard_of(size_t hash) const
+  { return ((hash * 0x9e3779b97f4a7c15ULL) >> 32) % this->shards_.size(); }
+
+public: // METHODS
+
+  /// constructor
+  explicit concurrent_tuple_table(size_t width = 0, size_t num_shards = 1) :
+    width_(width)
+  { // {{{
+    assert(num_shards > 0);
+    for (size_t i = 0; i < num_shards; ++i) {
+      this->shards_.emplace_back(new shard(width));
+    }
+  } // concurrent_tuple_table() }}}
+
+  /// inserts a tuple (if not present); returns its number and whether an
+  /// insertion happened
+  std::pair<unsigned, bool> insert(const unsigned* tuple)
+  { // {{{
+    const size_t num_shards = this->shards_.size();
+    const size_t hash = this->shards_[0]->table.hash_tuple(tuple);
+    const size_t sh = this->shard_of(hash);
+    std::lock_guard<std::mutex> lock(this->shards_[sh]->mtx);
+    auto id_bool_pair = this->shards_[sh]->table.insert(tuple, hash);
+    id_bool_pair.first = id_bool_pair.first * num_shards + sh;
+    return id_bool_pair;
+  } // insert() }}}
+
+  /// see tuple_table::append()
+  unsigned append(const unsigned* tuple)
+  { // {{{
+    std::lock_guard<std::mutex> lock(this->shards_[0]->mtx);
+    return this->shards_[0]->table.append(tuple) * this->shards_.size();
+  } // append() }}}
+
+  /// returns the tuple with the given number (the pointer stays valid)
+  const unsigned* operator[](unsigned id) const
+  { // {{{
+    const size_t num_shards = this->shards_.size();
+    shard& sh = *this->shards_[id % num_shards];
+    std::lock_guard<std::mutex> lock(sh.mtx);
+    return sh.table[id / num_shards];
+  } // operator[] }}}
+
+  /// number of stored tuples
+  size_t size() const
+  { // {{{
+    size_t result = 0;
+    for (const auto& sh : this->shards_) {
+      std::lock_guard<std::mutex> lock(sh->mtx);
+      result += sh->table.size();
+    }
+    return result;
+  } // size() }}}
+
+  /// number of shards
+  size_t num_shards() const { return this->shards_.size(); }
+
+  /// number of tuples in a shard; their numbers are i * num_shards() + shard
+  /// for i < shard_size(shard)
+  size_t shard_size(size_t shard) const
+  { // {{{
+    std::lock_guard<std::mutex> lock(this->shards_[shard]->mtx);
+    return this->shards_[shard]->table.size();
+  } // shard_size() }}}
+
+  /// is 'id' the number of a stored tuple?  (numbers are not consecutive
+  /// when there are more shards, so they cannot be compared with size())
+  bool contains(unsigned id) const
+  { // {{{
+    const size_t num_shards = this->shards_.size();
+    return id / num_shards < this->shard_size(id % num_shards);
+  } // contains() }}}
+
+  /// number of elements of every tuple
+  size_t width() const { return this->width_; }
+}; // concurrent_tuple_table }}}
+
+} // namespace kofola }}}
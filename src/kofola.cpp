@@ -19,10 +19,13 @@
 
 #include "kofola.hpp"
 #include "optimizer.hpp"
+#include "reachability.hpp"
 
 #include <vector>
 #include <sstream>
 
+#include <sys/resource.h>
+
 #include <spot/twaalgos/degen.hh>
 #include <spot/twaalgos/isdet.hh>
 #include <spot/twaalgos/isweakscc.hh>
@@ -60,7 +63,7 @@ namespace cola
   }
 
   bool
-  is_elevator_automaton(const spot::scc_info &scc, std::string& scc_str)
+  is_elevator_automaton(const spot::scc_info &scc, const std::string& scc_str)
   {
     for (unsigned sc = 0; sc < scc.scc_count(); ++sc)
     {
@@ -91,7 +94,7 @@ namespace cola
   }
 
   bool
-  is_weak_automaton(const spot::scc_info &scc, std::string& scc_str)
+  is_weak_automaton(const spot::scc_info &scc, const std::string& scc_str)
   {
     for (unsigned sc = 0; sc < scc.scc_count(); ++sc)
     {
@@ -166,26 +169,16 @@ namespace cola
   {
     unsigned long scccount = scc.scc_count();
     std::vector<bool> res(scccount * scccount, 0);
-    for (unsigned i = 0; i < scccount; ++i)
-      {
-        // reach itself
-        res[i + scccount * i] = true;
-      }
+    // the closure is computed on bitset rows (a word of SCCs at a time), only
+    // the reachable pairs are copied
+    kofola::scc_reachability reach(scc);
     for (unsigned i = 0; i < scccount; ++i)
     {
       unsigned ibase = i * scccount;
-      for (unsigned d : scc.succ(i))
+      for (unsigned j : reach.succ_sccs(i))
       {
-        // we necessarily have d < i because of the way SCCs are
-        // numbered, so we can build the transitive closure by
-        // just ORing any SCC reachable from d.
-        unsigned dbase = d * scccount;
-        // j reach d (i can reach d, so res[d + i * scccount] = 1)
-        for (unsigned j = 0; j < scccount; ++j)
-        {
-          // j is reachable from i if j is reachable from d
-          res[ibase + j] = res[ibase + j] || res[dbase + j];
-        }
+        // j is reachable from i
+        res[ibase + j] = true;
       }
     }
     return res;
@@ -274,7 +267,7 @@ namespace cola
   }
 
   bool
-  is_limit_deterministic_automaton(const spot::scc_info &si, std::string& scc_str)
+  is_limit_deterministic_automaton(const spot::scc_info &si, const std::string& scc_str)
   {
     unsigned nscc = si.scc_count();
     assert(nscc);
@@ -302,6 +295,12 @@ namespace cola
   get_scc_types(const spot::scc_info &si)
   {
     spot::scc_info si_copy = si;
+    return get_scc_types(si_copy);
+  }
+
+  std::string
+  get_scc_types(spot::scc_info &si)
+  {
     unsigned nc = si.scc_count();
     std::string res(nc, 0);
     for (unsigned sc = 0; sc < nc; ++sc)
@@ -309,7 +308,7 @@ namespace cola
       char type = 0;
       type |= is_deterministic_scc(sc, si) ? SCC_INSIDE_DET_TYPE : 0; // only care about the states inside SCC
       type |= is_deterministic_scc(sc, si, false) ? SCC_DET_TYPE : 0; // must also be deterministic for all transitions after accepting
-      type |=  spot::is_inherently_weak_scc(si_copy, sc) ? SCC_WEAK_TYPE : 0;
+      type |=  spot::is_inherently_weak_scc(si, sc) ? SCC_WEAK_TYPE : 0;
       type |= si.is_accepting_scc(sc) ? SCC_ACC : 0;
       // other type is 0
       res[sc] = type;
@@ -427,6 +426,28 @@ namespace kofola
         [=](unsigned x) { return vec_acceptance[x]; });
   }
 
+  size_t get_peak_memory_mib()
+  {
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage)) { return 0; }
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024 * 1024);   // in bytes
+#else
+    return usage.ru_maxrss / 1024;            // in KiB
+#endif
+  }
+
+  bool set_contains_accepting_state(
+    const state_bitset&        input,
+    const std::vector<bool>&   vec_acceptance)
+  {
+    for (unsigned x : input) {
+      if (vec_acceptance[x]) { return true; }
+    }
+
+    return false;
+  }
+
   std::ostream& operator<<(std::ostream& os, const PartitionType& parttype)
   {
     switch (parttype) {
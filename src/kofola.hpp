@@ -16,12 +16,15 @@
 #pragma once
 
 #include "optimizer.hpp"
+#include "post_image.hpp"
+#include "sim_relation.hpp"
 
 #include <set>
 #include <map>
 #include <vector>
 #include <fstream>
 #include <stack>
+#include <stdexcept>
 #include <string>
 
 #include <spot/twaalgos/hoa.hh>
@@ -42,6 +45,10 @@ static const char *SCC_REACH_MEMORY_LIMIT = "scc-reach-memory-limit";
 static const char *REQUIRE_PARITY = "require-parity";
 static const char *NUM_TRANS_PRUNING = "num-trans-pruning";
 static const char *MSTATE_REARRANGE = "mstate-rearrange";
+static const char *CHECKPOINT_FILE = "checkpoint-file";          // string option
+static const char *CHECKPOINT_INTERVAL = "checkpoint-interval";  // in seconds
+static const char *RESUME_FILE = "resume-file";                  // string option
+static const char *CHECKPOINT_OPTIONS = "checkpoint-options";    // string option
 
 
 static const char SCC_WEAK_TYPE = 1;
@@ -62,6 +69,15 @@ enum automaton_type
   LIMIT_DETERMINISTIC = 4
 };
 
+// Order of exploring the states of the complement
+enum class explore_order
+{
+  DFS,          // depth-first (newest states first)
+  BFS,          // breadth-first (oldest states first)
+  SMALL_REACH,  // states with smaller sets of reached states first
+  ACTIVE        // states with more active partial macrostates first
+};
+
 // Complement decomposition options
 struct compl_decomp_options
 {
@@ -79,6 +95,15 @@ struct compl_decomp_options
   bool dataflow = false;
   bool rank_for_nacs = false;
   bool low_red_interm = false;
+  bool lazy_product = false;  // intersect the complements of SCCs on the fly, reduce only the result
+  unsigned threads = 1;       // number of threads for state space exploration
+  unsigned max_states = 0;    // maximum number of states of the complement (0 = unlimited)
+  unsigned max_memory = 0;    // maximum memory usage in MiB (0 = unlimited)
+  unsigned timeout = 0;       // maximum time of the construction in seconds (0 = unlimited)
+  explore_order order = explore_order::DFS; // order of exploring states of the complement
+  std::string checkpoint_file;        // file for periodic checkpoints of the construction (empty = none)
+  unsigned checkpoint_interval = 600; // time between checkpoints in seconds
+  std::string resume_file;            // checkpoint to resume the construction from (empty = none)
 };
 
 /// macro for debug outputs
@@ -119,8 +144,8 @@ namespace kofola
   /// log verbosity
   extern unsigned LOG_VERBOSITY;
 
-  /// type for representing simulation (NB: this is not very efficient... should be changed)
-  using Simulation = std::vector<std::pair<unsigned, unsigned>>;
+  /// type for representing simulation
+  using Simulation = sim_relation;
 
   /// type for mapping states to partitions where they are (-1 represents trivial SCCs)
   /// TODO: a simple vector should suffice (-1 means invalid partition)
@@ -145,31 +170,50 @@ namespace kofola
   /// the type for mapping partition numbers to their types
   using PartitionToTypeMap = std::map<size_t, PartitionType>;
 
-  /// the type for representing a set of states reachable from a given state
-  using ReachableVector = std::vector<std::set<unsigned>>;
-
-  /// type for mapping SCCs to a set of SCCs (e.g., representing all
-  /// predecessors of the given SCC)
-  using SCCToSCCSetMap = std::unordered_map<unsigned, std::set<unsigned>>;
+  /// thrown when the construction of the complement exceeds a budget given
+  /// in compl_decomp_options (the members describe the partial result)
+  struct budget_exceeded : public std::runtime_error
+  { // {{{
+    std::string resource;        // "states", "memory", or "time"
+    size_t num_states;           // number of discovered states
+    size_t num_expanded;         // number of states whose successors were computed
+    size_t todo_size;            // number of states waiting for processing
+    int max_partition;           // partition with the most partial macrostates
+    size_t max_partition_size;   // the number of its partial macrostates
+
+    budget_exceeded(
+      const std::string&  resource,
+      size_t              num_states,
+      size_t              num_expanded,
+      size_t              todo_size,
+      int                 max_partition,
+      size_t              max_partition_size
+    ) : std::runtime_error("budget exceeded: " + resource),
+      resource(resource),
+      num_states(num_states),
+      num_expanded(num_expanded),
+      todo_size(todo_size),
+      max_partition(max_partition),
+      max_partition_size(max_partition_size)
+    { }
+  }; // budget_exceeded }}}
+
+  /// returns the peak memory usage of the process in MiB
+  size_t get_peak_memory_mib();
 
   /// declaration of printer
   template<class Tuple, size_t N>
   struct TuplePrinter;
 
-  /// get all successors of a given set of states over a given symbol
+  /// get all successors of a given set of states over a given letter
   template <class T>
-  std::set<unsigned> get_all_successors(
-    const spot::const_twa_graph_ptr&  aut,
+  state_bitset get_all_successors(
+    const post_image_table&           posts,
     const T&                          current_states,
-    const bdd&                        symbol)
+    unsigned                          symbol)
   { // {{{
-    std::set<unsigned> successors;
-
-    for (unsigned s : current_states) {
-      for (const auto &t : aut->out(s)) {
-        if (bdd_implies(symbol, t.cond)) { successors.insert(t.dst); }
-      }
-    }
+    state_bitset successors =
+      posts.get_post(current_states, symbol, post_image_table::ALL);
 
     DEBUG_PRINT_LN("all successors of " + std::to_string(current_states) +
         " over " + std::to_string(symbol) +
@@ -178,41 +222,31 @@ namespace kofola
   } // get_all_successors() }}}
 
 
-  /// get all successors of a given set over a symbol that are in the partition 'part_num'
+  /// get all successors of a given set over a letter that are in the partition 'part_num'
   template <class T>
-  std::set<unsigned> get_all_successors_in_part(
-    const spot::const_twa_graph_ptr&  aut,
+  state_bitset get_all_successors_in_part(
+    const post_image_table&           posts,
     const StateToPartitionMap&        st_to_part_map,
     unsigned                          part_num,
     const T&                          current_states,
-    const bdd&                        symbol)
+    unsigned                          symbol)
   { // {{{
-    std::set<unsigned> successors = get_all_successors(aut, current_states, symbol);
-    std::set<unsigned> result;
-    std::copy_if(successors.begin(), successors.end(), std::inserter(result, result.end()),
-        [=](unsigned x){ return part_num == st_to_part_map.at(x); });
+    state_bitset result;
+    for (unsigned x : get_all_successors(posts, current_states, symbol)) {
+      if (part_num == st_to_part_map.at(x)) { result.insert(x); }
+    }
 
     return result;
   } // get_all_successors_in_part() }}}
 
-  /// get all successors of a given set over a symbol that are in the same SCC as the source state
+  /// get all successors of a given set over a letter that are in the same SCC as the source state
   template <class T>
-  std::set<unsigned> get_all_successors_in_scc(
-    const spot::const_twa_graph_ptr&  aut,
-    const spot::scc_info&             scc_info,
+  state_bitset get_all_successors_in_scc(
+    const post_image_table&           posts,
     const T&                          current_states,
-    const bdd&                        symbol)
+    unsigned                          symbol)
   { // {{{
-    std::set<unsigned> successors;
-
-    for (unsigned s : current_states) {
-      for (const auto &t : aut->out(s)) {
-        if (scc_info.scc_of(s) == scc_info.scc_of(t.dst) && bdd_implies(symbol, t.cond)) {
-          successors.insert(t.dst); }
-      }
-    }
-
-    return successors;
+    return posts.get_post(current_states, symbol, post_image_table::IN_SCC);
   } // get_all_successors_in_scc() }}}
 
   /// checks whether an element is in a container with find()
@@ -220,6 +254,10 @@ namespace kofola
   inline bool is_in(const T& elem, const C& container)
   { return container.find(elem) != container.end(); }
 
+  /// checks whether a state is in a set of states
+  inline bool is_in(unsigned elem, const state_bitset& container)
+  { return container.contains(elem); }
+
 
   /// computes the difference of two sets
   template <class T>
@@ -257,11 +295,28 @@ namespace kofola
     return result;
   } // get_set_intersection() }}}
 
+  /// computes the difference of two sets of states
+  inline state_bitset get_set_difference(const state_bitset& lhs, const state_bitset& rhs)
+  { return lhs - rhs; }
+
+  /// computes the union of two sets of states
+  inline state_bitset get_set_union(const state_bitset& lhs, const state_bitset& rhs)
+  { return lhs | rhs; }
+
+  /// computes the intersection of two sets of states
+  inline state_bitset get_set_intersection(const state_bitset& lhs, const state_bitset& rhs)
+  { return lhs & rhs; }
+
   /// checks whether a set contains at least one accepting state
   bool set_contains_accepting_state(
     const std::set<unsigned>&  input,               // input set
     const std::vector<bool>&   vec_acceptance);     // vectoring denoting accepting states
 
+  /// checks whether a set of states contains at least one accepting state
+  bool set_contains_accepting_state(
+    const state_bitset&        input,               // input set
+    const std::vector<bool>&   vec_acceptance);     // vectoring denoting accepting states
+
 } // namespace kofola }}}
 
 
@@ -300,6 +355,30 @@ namespace cola
   spot::twa_graph_ptr
   complement_tnba(const spot::twa_graph_ptr &aut, spot::option_map &om, compl_decomp_options decomp_options);
 
+  /// \brief Complementation with streamed output
+  ///
+  /// Same as complement_tnba(), but the (not postprocessed) result is written
+  /// to \a os in the HOA format while it is being constructed, so that it
+  /// does not need to be kept in memory.
+  void
+  complement_tnba_stream(const spot::twa_graph_ptr &aut, spot::option_map &om, compl_decomp_options decomp_options, std::ostream &os);
+
+  /// \brief On-the-fly complementation
+  ///
+  /// Returns the (not postprocessed) complement of \a aut as a spot::twa
+  /// whose states and transitions are constructed only when they are asked
+  /// for, e.g., by a product and an emptiness check.
+  spot::twa_ptr
+  complement_tnba_lazy(const spot::twa_graph_ptr &aut, spot::option_map &om, compl_decomp_options decomp_options);
+
+  /// \brief Saturation of accepting transitions
+  ///
+  /// Returns a copy of \a aut where a transition inside an SCC is accepting
+  /// also if all transitions leaving its target inside the SCC are; \a si
+  /// are the SCCs of \a aut.
+  spot::twa_graph_ptr
+  saturation(const spot::const_twa_graph_ptr &aut, const spot::scc_info &si);
+
 
   spot::twa_graph_ptr
   determinize_twba(const spot::const_twa_graph_ptr &aut, spot::option_map &om);
@@ -353,7 +432,7 @@ namespace cola
   ///
   /// Output a bool value
   bool
-  is_elevator_automaton(const spot::scc_info &scc, std::string& scc_str);
+  is_elevator_automaton(const spot::scc_info &scc, const std::string& scc_str);
 
   bool
   is_elevator_automaton(const spot::const_twa_graph_ptr &aut);
@@ -362,10 +441,10 @@ namespace cola
   is_weak_automaton(const spot::const_twa_graph_ptr &aut);
 
   bool
-  is_weak_automaton(const spot::scc_info &scc, std::string& scc_str);
+  is_weak_automaton(const spot::scc_info &scc, const std::string& scc_str);
 
   bool
-  is_limit_deterministic_automaton(const spot::scc_info &scc, std::string& scc_str);
+  is_limit_deterministic_automaton(const spot::scc_info &scc, const std::string& scc_str);
 
   /// \brief Output the set of states
   ///
@@ -397,6 +476,9 @@ namespace cola
 
   std::string
   get_scc_types(const spot::scc_info &scc);
+  /// the same as above, but without copying 'scc' (Spot needs a mutable one)
+  std::string
+  get_scc_types(spot::scc_info &scc);
   // /// \brief Output an automaton to a file
   // std::vector<bool>
   // is_reachable_weak_sccs(const spot::scc_info &scc, state_simulator& sim);
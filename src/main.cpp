@@ -24,6 +24,9 @@
 #include "optimizer.hpp"
 #include "decomposer.hpp"
 #include "simulation.hpp"
+#include "result_cache.hpp"
+#include "analysis.hpp"
+#include "stats.hpp"
 // #include "postproc.hpp"
 
 #include <unistd.h>
@@ -31,6 +34,8 @@
 #include <ctime>
 #include <string>
 #include <sstream>
+#include <memory>
+#include <thread>
 
 #include <spot/twaalgos/simulation.hh>
 #include <spot/parseaut/public.hh>
@@ -109,6 +114,29 @@ Decomposition-based complementation:
     --dataflow            Data flow analysis in rank-based complementation
     --rank                Use rank-based complementation (default: Determinization-based)
     --low-red-interm      Low-only reduction of intermediate results for '--scc-compl'
+    --lazy-product        Build only the reachable part of the product of the complements
+                          for '--scc-compl' and reduce only the result
+    --threads=[INT]       Number of threads for exploring the complement, or of
+                          processes complementing parts with --scc-compl (default=1,
+                          at most the number of cores)
+    --explore=[dfs|bfs|reach|active]  Order of exploring states of the complement:
+                          depth-first (default), breadth-first, smaller sets of
+                          reached states first, more active partitions first
+    --max-states=[INT]    Give up when the complement has more than INT states
+    --max-memory=[INT]    Give up when the memory usage exceeds INT MiB
+    --timeout=[INT]       Give up when the complementation takes more than INT seconds
+                          (when giving up, the partial statistics are printed and
+                          the exit status is 3)
+    --checkpoint=[FILE]   Periodically save the state of the complementation or
+                          determinization of a single automaton into FILE
+    --checkpoint-interval=[INT]  Time between checkpoints in seconds (default=600)
+    --resume=[FILE]       Continue from a checkpoint written with the same input
+                          and options (for a single input automaton, not with
+                          --stream, --scc-compl or --decompose)
+    --cache=[DIR]         Reuse results of previous runs with the same input automaton
+                          and options stored in DIR, and store new results there
+    --stats=json          Print times of phases and counters for every input automaton
+                          to stderr as one JSON object per line
 
 Pre- and Post-processing:
     --preprocess=[0|1|2|3]       Level for simplifying the input automaton (default=1)
@@ -116,6 +144,9 @@ Pre- and Post-processing:
     --num-states=[INT]           Simplify the output with number of states less than INT (default=30000)
     --tba                 Output a TBA
     --raw                 no postprocessing
+    --stream              Write the complement while it is being constructed (implies --raw;
+                          states are numbered in the order of exploration, so not with
+                          --threads greater than 1)
 
 Miscellaneous options:
   -h, --help    Print this help
@@ -213,16 +244,17 @@ void output_input_type(spot::twa_graph_ptr aut)
     type = true;
     std::cout << "deterministic" << std::endl;
   }
-  if (spot::is_semi_deterministic(aut))
+  kofola::aut_analysis analysis(aut);
+  if (analysis.is_semi_deterministic())
   {
     type = true;
     std::cout << "limit-deterministic" << std::endl;
   }
-  if (cola::is_elevator_automaton(aut))
+  if (analysis.is_elevator())
   {
     std::cout << "elevator" << std::endl;
   }
-  if (cola::is_weak_automaton(aut))
+  if (analysis.is_weak())
   {
     std::cout << "inherently weak" << std::endl;
   }
@@ -329,6 +361,7 @@ int main(int argc, char *argv[])
   bool comp = false;
   bool contain = false;
   bool congr = false;
+  bool stream = false;
   std::string file_to_contain;
 
   compl_decomp_options decomp_options;
@@ -342,6 +375,10 @@ int main(int argc, char *argv[])
 
   std::string output_filename = "";
 
+  std::string cache_dir = "";
+
+  bool stats_json = false;
+
   for (int i = 1; i < argc; i++)
   {
     std::string arg = argv[i];
@@ -443,6 +480,9 @@ int main(int argc, char *argv[])
     else if (arg == "--low-red-interm") {
       decomp_options.low_red_interm = true;
     }
+    else if (arg == "--lazy-product") {
+      decomp_options.lazy_product = true;
+    }
     else if (arg == "--type")
       aut_type = true;
     else if (arg == "--unambiguous")
@@ -503,6 +543,11 @@ int main(int argc, char *argv[])
     {
       decomp_options.raw = true;
     }
+    else if (arg == "--stream")
+    {
+      stream = true;
+      decomp_options.raw = true;
+    }
     else if (arg == "--rank")
     {
       decomp_options.rank_for_nacs = true;
@@ -531,6 +576,79 @@ int main(int argc, char *argv[])
     {
       decomp_options.dataflow = true;
     }
+    else if (arg.find("--threads=") != std::string::npos)
+    {
+      // parse_int() would wrap negative numbers around
+      std::istringstream iss(arg.substr(arg.find('=') + 1));
+      long long threads = 0;
+      if (!(iss >> threads) || !iss.eof() || threads <= 0)
+      {
+        std::cerr << "cola: Option --threads requires a positive number.\n";
+        return 1;
+      }
+      // more threads (or processes with --scc-compl) than cores do not help
+      const unsigned num_cores = std::thread::hardware_concurrency();
+      if (num_cores > 0 && threads > num_cores)
+        threads = num_cores;
+      decomp_options.threads = static_cast<unsigned>(threads);
+    }
+    else if (arg.find("--explore=") != std::string::npos)
+    {
+      std::string order = arg.substr(arg.find('=') + 1);
+      if (order == "dfs")
+        decomp_options.order = explore_order::DFS;
+      else if (order == "bfs")
+        decomp_options.order = explore_order::BFS;
+      else if (order == "reach")
+        decomp_options.order = explore_order::SMALL_REACH;
+      else if (order == "active")
+        decomp_options.order = explore_order::ACTIVE;
+      else
+      {
+        std::cerr << "cola: Unknown exploration order " << order << ".\n";
+        return 1;
+      }
+    }
+    else if (arg.find("--max-states=") != std::string::npos)
+    {
+      decomp_options.max_states = parse_int(arg);
+    }
+    else if (arg.find("--max-memory=") != std::string::npos)
+    {
+      decomp_options.max_memory = parse_int(arg);
+    }
+    else if (arg.find("--timeout=") != std::string::npos)
+    {
+      decomp_options.timeout = parse_int(arg);
+    }
+    else if (arg.find("--checkpoint-interval=") != std::string::npos)
+    {
+      decomp_options.checkpoint_interval = parse_int(arg);
+      om.set(CHECKPOINT_INTERVAL, decomp_options.checkpoint_interval);
+    }
+    else if (arg.find("--checkpoint=") != std::string::npos)
+    {
+      decomp_options.checkpoint_file = arg.substr(arg.find('=') + 1);
+      om.set_str(CHECKPOINT_FILE, decomp_options.checkpoint_file);
+    }
+    else if (arg.find("--resume=") != std::string::npos)
+    {
+      decomp_options.resume_file = arg.substr(arg.find('=') + 1);
+      om.set_str(RESUME_FILE, decomp_options.resume_file);
+    }
+    else if (arg.find("--cache=") != std::string::npos)
+    {
+      cache_dir = arg.substr(arg.find('=') + 1);
+    }
+    else if (arg.find("--stats=") != std::string::npos)
+    {
+      if (arg.substr(arg.find('=') + 1) != "json")
+      {
+        std::cerr << "cola: Option --stats supports only the format json.\n";
+        return 1;
+      }
+      stats_json = true;
+    }
     else if (arg == "-f")
     {
       if (argc < i + 1)
@@ -631,8 +749,116 @@ int main(int argc, char *argv[])
     }
   }
 
+  // the streamed states are numbered in the order they are expanded, which
+  // depends on the scheduling of the threads; the output would not be the
+  // same in every run
+  if (stream && decomp_options.threads > 1)
+  {
+    std::cerr << "cola: Option --stream cannot be used with --threads greater than 1.\n";
+    return 1;
+  }
+
+  // a checkpoint belongs to one construction on one automaton
+  const bool checkpointing = !decomp_options.checkpoint_file.empty() ||
+                             !decomp_options.resume_file.empty();
+  if (checkpointing && (stream || decomp_options.scc_compl || decompose))
+  {
+    std::cerr << "cola: Checkpoints cannot be used with --stream, --scc-compl or --decompose.\n";
+    return 1;
+  }
+  if (checkpointing && path_to_files.size() > 1)
+  {
+    std::cerr << "cola: Checkpoints can be used only for a single input automaton.\n";
+    return 1;
+  }
+
+  // the options the result depends on (besides the input automaton); they
+  // identify results in the cache and constructions in checkpoints
+  std::string result_options;
+  {
+    std::ostringstream oss;
+    oss << "cola-" PACKAGE_VERSION
+        << " determinize=" << determinize << " complement=" << complement
+        << " comp=" << comp << " decompose=" << decompose
+        << " preprocess=" << preprocess << " postprocess=" << post_process
+        << " num-post=" << num_post << " output=" << output_type
+        << " acd=" << use_acd;
+    for (const char *key : {USE_SIMULATION, USE_DELAYED_SIMULATION, USE_STUTTER,
+                            USE_SCC_INFO, USE_UNAMBIGUITY, MORE_ACC_EDGES,
+                            NUM_NBA_DECOMPOSED, NUM_SCC_LIMIT_MERGER,
+                            SCC_REACH_MEMORY_LIMIT, REQUIRE_PARITY,
+                            NUM_TRANS_PRUNING, MSTATE_REARRANGE})
+    {
+      oss << " " << key << "=" << om.get(key);
+    }
+    // the exploration order, budgets and checkpoints do not change the
+    // result; neither does the number of threads, except that with
+    // --scc-compl (without --lazy-product) more threads intersect the parts
+    // as a balanced tree rather than smallest first
+    oss << " tree-product=" << (decomp_options.scc_compl &&
+        !decomp_options.lazy_product && decomp_options.threads > 1)
+        << " merge-iwa=" << decomp_options.merge_iwa
+        << " merge-det=" << decomp_options.merge_det
+        << " tgba=" << decomp_options.tgba << " tba=" << decomp_options.tba
+        << " raw=" << decomp_options.raw
+        << " iw-sim=" << decomp_options.iw_sim
+        << " det-sim=" << decomp_options.det_sim
+        << " scc-compl=" << decomp_options.scc_compl
+        << " scc-high=" << decomp_options.scc_compl_high
+        << " dir-sim=" << decomp_options.dir_sim
+        << " sat=" << decomp_options.sat
+        << " dataflow=" << decomp_options.dataflow
+        << " rank-nacs=" << decomp_options.rank_for_nacs
+        << " low-red-interm=" << decomp_options.low_red_interm
+        << " lazy-product=" << decomp_options.lazy_product;
+    result_options = oss.str();
+  }
+  if (checkpointing)
+    om.set_str(CHECKPOINT_OPTIONS, result_options);
+
+  // results are cached only if they depend on nothing but the input
+  // automaton and the options above
+  std::unique_ptr<kofola::result_cache> cache;
+  if (cache_dir != "" && !contain && !stream && (determinize || complement))
+  {
+    try
+    {
+      cache = std::make_unique<kofola::result_cache>(cache_dir);
+    }
+    catch (const std::runtime_error &e)
+    {
+      std::cerr << "cola: " << e.what() << "\n";
+      return 1;
+    }
+  }
+
   auto dict = spot::make_bdd_dict();
 
+  // outputs a result
+  auto output_result = [&](spot::twa_graph_ptr aut)
+  {
+    kofola::phase_timer timer("output");
+    const char *opts = nullptr;
+    aut->merge_edges();
+    if (om.get(VERBOSE_LEVEL) > 0)
+    {
+      std::cout << "Number of (states, transitions, colors) in the result automaton: ("
+                << aut->num_states() << "," << aut->num_edges() << "," << aut->num_sets() << ")" << std::endl;
+      spot::print_hoa(std::cout, aut);
+      std::cout << std::endl;
+    }
+
+    if (output_filename != "")
+    {
+      cola::output_file(aut, output_filename.c_str());
+    }
+    else
+    {
+      spot::print_hoa(std::cout, aut, opts);
+      std::cout << "\n";
+    }
+  };
+
   spot::twa_graph_ptr aut_to_contain = nullptr;
   // contain
   if (contain)
@@ -648,15 +874,28 @@ int main(int argc, char *argv[])
     aut_to_contain = parsed_aut->aut;
   }
 
+  // number of the processed automaton (over all files)
+  unsigned aut_index = 0;
   for (std::string &path_to_file : path_to_files)
   {
     if (om.get(VERBOSE_LEVEL))
       std::cout << "File: " << path_to_file << " Algo: " << determinize << std::endl;
     spot::automaton_stream_parser parser(path_to_file);
 
+    // prints the statistics of the current automaton
+    auto print_stats = [&]()
+    {
+      if (stats_json)
+        kofola::STATS.print_json(std::cerr, path_to_file, aut_index);
+      ++aut_index;
+    };
+
     for (;;)
     {
+      kofola::STATS.clear();
+      kofola::phase_timer parsing_timer("parsing");
       spot::parsed_aut_ptr parsed_aut = parser.parse(dict);
+      parsing_timer.stop();
 
       if (parsed_aut->format_errors(std::cerr))
         return 1;
@@ -667,6 +906,12 @@ int main(int argc, char *argv[])
       if (!aut)
         break;
 
+      if (checkpointing && aut_index > 0)
+      {
+        std::cerr << "cola: Checkpoints can be used only for a single input automaton.\n";
+        return 1;
+      }
+
       // Check if input is TGBA
       if (aut->acc().is_generalized_buchi())
       {
@@ -691,11 +936,31 @@ int main(int argc, char *argv[])
         break;
       }
 
+      kofola::result_cache::key cache_key;
+      if (cache)
+      {
+        cache_key = cache->make_key(aut, result_options);
+        spot::twa_graph_ptr cached = cache->lookup(cache_key, dict);
+        if (cached)
+        {
+          if (om.get(VERBOSE_LEVEL) > 0)
+            std::cout << "Result found in the cache: " << cache_key.name << std::endl;
+          output_result(cached);
+          kofola::STATS.add("cache_hits", 1);
+          print_stats();
+          continue;
+        }
+      }
+
+      // SCCs and their types of the input are computed only once
+      kofola::aut_analysis analysis(aut);
+      kofola::phase_timer preprocessing_timer("preprocessing");
+
       if (om.get(MORE_ACC_EDGES) > 0)
       {
         const unsigned num = 200;
         // strengther
-        spot::scc_info si(aut, spot::scc_info_options::ALL);
+        spot::scc_info &si = analysis.get_scc_info();
         cola::edge_strengther e_strengther(aut, si, 200);
         for (unsigned sc = 0; sc < si.scc_count(); sc++)
         {
@@ -704,20 +969,22 @@ int main(int argc, char *argv[])
             e_strengther.fix_scc(sc);
           }
         }
+        // the colours changed
+        analysis.invalidate();
       }
 
       //1. preprocess
       clock_t c_start = clock();
       unsigned aut_type = NONDETERMINISTIC;
-      if (cola::is_weak_automaton(aut))
+      if (analysis.is_weak())
       {
         aut_type |= INHERENTLY_WEAK;
       }
-      if (spot::is_semi_deterministic(aut))
+      if (analysis.is_semi_deterministic())
       {
         aut_type |= LIMIT_DETERMINISTIC;
       }
-      if (cola::is_elevator_automaton(aut))
+      if (analysis.is_elevator())
       {
         aut_type |= ELEVATOR;
       }
@@ -754,75 +1021,118 @@ int main(int argc, char *argv[])
         // trivial acceptance condition
         aut = spot::minimize_monitor(aut);
       }
+      preprocessing_timer.stop();
       if (!spot::is_deterministic(aut) && determinize)
       {
-        if (decompose && aut->acc().is_buchi() && !spot::is_deterministic(aut))
+        kofola::phase_timer timer("determinization");
+        try
         {
-          cola::decomposer nba_decomposer(aut, om);
-          std::vector<spot::twa_graph_ptr> subnbas = nba_decomposer.run();
-          std::vector<spot::twa_graph_ptr> dpas;
-          for (unsigned i = 0; i < subnbas.size(); i++)
+          if (decompose && aut->acc().is_buchi() && !spot::is_deterministic(aut))
           {
-            spot::twa_graph_ptr dpa = to_deterministic(subnbas[i], om, aut_type, determinize);
-            dpas.push_back(dpa);
+            cola::decomposer nba_decomposer(aut, om);
+            std::vector<spot::twa_graph_ptr> subnbas = nba_decomposer.run();
+            std::vector<spot::twa_graph_ptr> dpas;
+            for (unsigned i = 0; i < subnbas.size(); i++)
+            {
+              spot::twa_graph_ptr dpa = to_deterministic(subnbas[i], om, aut_type, determinize);
+              dpas.push_back(dpa);
+            }
+            cola::composer dpa_composer(dpas, om);
+            aut = dpa_composer.run();
           }
-          cola::composer dpa_composer(dpas, om);
-          aut = dpa_composer.run();
-        }
-        else if (aut->acc().is_buchi())
-        {
-          spot::twa_graph_ptr res = nullptr;
-          c_start = clock();
-          res = to_deterministic(aut, om, aut_type, determinize);
-          c_end = clock();
-          if (om.get(VERBOSE_LEVEL) > 0)
+          else if (aut->acc().is_buchi())
           {
-            std::cout << "Done for determinizing the input automaton in " << 1000.0 * (c_end - c_start) / CLOCKS_PER_SEC << " ms..." << std::endl;
+            spot::twa_graph_ptr res = nullptr;
+            c_start = clock();
+            res = to_deterministic(aut, om, aut_type, determinize);
+            c_end = clock();
+            if (om.get(VERBOSE_LEVEL) > 0)
+            {
+              std::cout << "Done for determinizing the input automaton in " << 1000.0 * (c_end - c_start) / CLOCKS_PER_SEC << " ms..." << std::endl;
+            }
+            aut = res;
           }
-          aut = res;
+        }
+        catch (const std::runtime_error &e)
+        {
+          std::cerr << "cola: " << e.what() << "\n";
+          return 1;
         }
       }
       if (complement && !determinize)
       {
-        if (complement == CONGR && contain)
+        try
         {
-          if (!aut_to_contain)
-            std::cout << "Contained" << std::endl;
-          cola::congr_contain(aut, aut_to_contain, om);
+          if (complement == CONGR && contain)
+          {
+            if (!aut_to_contain)
+              std::cout << "Contained" << std::endl;
+            cola::congr_contain(aut, aut_to_contain, om);
+          }
+          else if (complement == COMP && contain)
+          {
+            // the complement is explored only as far as the product with the
+            // other automaton needs
+            spot::twa_ptr lazy_compl = cola::complement_tnba_lazy(aut, om, decomp_options);
+            spot::twa_word_ptr word = aut_to_contain->intersecting_word(lazy_compl);
+            if (word)
+              std::cout << "Not contained: " << *word << std::endl;
+            else
+              std::cout << "Contained" << std::endl;
+            print_stats();
+            continue;
+          }
+          else if (complement == COMP && stream)
+          {
+            if (output_filename != "")
+            {
+              std::ofstream outfile(output_filename);
+              cola::complement_tnba_stream(aut, om, decomp_options, outfile);
+            }
+            else
+            {
+              cola::complement_tnba_stream(aut, om, decomp_options, std::cout);
+              std::cout << "\n";
+            }
+            print_stats();
+            continue;
+          }
+          else if (complement == COMP)
+          {
+            aut = cola::complement_tnba(aut, om, decomp_options);
+            output_type = Generic;
+          }
+          else
+          {
+            // set NCSB algorithm later
+            assert(false);
+          }
         }
-        else if (complement == COMP)
+        catch (const kofola::budget_exceeded &e)
         {
-          aut = cola::complement_tnba(aut, om, decomp_options);
-          output_type = Generic;
+          std::cerr << "cola: giving up, the budget for " << e.resource << " was exceeded\n"
+                    << "  states discovered: " << e.num_states << "\n"
+                    << "  states explored: " << e.num_expanded << "\n"
+                    << "  states to explore: " << e.todo_size << "\n"
+                    << "  largest partition: " << e.max_partition
+                    << " (" << e.max_partition_size << " partial macrostates)\n";
+          print_stats();
+          return 3;
         }
-        else
+        catch (const std::runtime_error &e)
         {
-          // set NCSB algorithm later
-          assert(false);
+          // e.g., an unusable checkpoint or a failed part of --scc-compl
+          std::cerr << "cola: " << e.what() << "\n";
+          return 1;
         }
       }else if (comp && determinize)
       {
         aut = spot::dualize(aut);
       }
-      const char *opts = nullptr;
-      aut->merge_edges();
-      if (om.get(VERBOSE_LEVEL) > 0)
-      {
-        std::cout << "Number of (states, transitions, colors) in the result automaton: ("
-                  << aut->num_states() << "," << aut->num_edges() << "," << aut->num_sets() << ")" << std::endl;
-        spot::print_hoa(std::cout, aut);
-        std::cout << std::endl;
-      }
-
-      if (output_filename != "")
-      {
-        cola::output_file(aut, output_filename.c_str());
-      }
-      else
-      {
-        spot::print_hoa(std::cout, aut, opts);
-        std::cout << "\n";
-      }
+      output_result(aut);
+      if (cache)
+        cache->store(cache_key, aut);
+      print_stats();
     }
   }
 
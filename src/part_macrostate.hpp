@@ -0,0 +1,161 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// partial macrostates of the partial complementation algorithms
+
+#pragma once
+
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "kofola.hpp"
+#include "checkpoint.hpp"
+#include "rankings.hpp"
+#include "safra_tree.hpp"
+#include "state_bitset.hpp"
+
+namespace kofola { // {{{
+
+// The partial macrostates are plain values; their methods are defined next
+// to the algorithms using them (complement_alg_*.cpp).
+
+/// partial macrostate of complement_mh
+struct mstate_mh
+{ // {{{
+  bool active_;
+  state_bitset states_;
+  state_bitset breakpoint_;
+
+  /// constructor
+  mstate_mh(
+    const state_bitset&        states,
+    const state_bitset&        breakpoint,
+    bool                       active
+  ) : active_(active),
+    states_(states),
+    breakpoint_(breakpoint)
+  { }
+
+  std::string to_string() const;
+  bool is_active() const { return this->active_; }
+  /// NB: active_ is not considered
+  bool operator==(const mstate_mh& rhs) const;
+  bool operator<(const mstate_mh& rhs) const;
+  size_t hash() const;
+  void save(checkpoint_writer& out) const;
+}; // mstate_mh }}}
+
+
+/// partial macrostate of complement_ncsb
+struct mstate_ncsb
+{ // {{{
+  bool active_;                    // true = active ; false = track
+  state_bitset check_;             // states for runs that need to be checked
+  state_bitset safe_;              // safe states (cannot see accepting transition)
+  state_bitset breakpoint_;
+
+  /// constructor
+  mstate_ncsb(
+    const state_bitset&        check,
+    const state_bitset&        safe,
+    const state_bitset&        breakpoint,
+    bool                       active
+  ) : active_(active),
+    check_(check),
+    safe_(safe),
+    breakpoint_(breakpoint)
+  { }
+
+  std::string to_string() const;
+  bool is_active() const { return this->active_; }
+  bool operator==(const mstate_ncsb& rhs) const;
+  bool operator<(const mstate_ncsb& rhs) const;
+  size_t hash() const;
+  void save(checkpoint_writer& out) const;
+}; // mstate_ncsb }}}
+
+
+/// partial macrostate of complement_safra
+struct mstate_safra
+{ // {{{
+  /// the corresponding Safra tree
+  safra::safra_tree st_;
+
+  /// constructor
+  explicit mstate_safra(const safra::safra_tree& st) : st_(st)
+  { }
+
+  std::string to_string() const;
+  bool is_active() const { return true; }
+  bool operator==(const mstate_safra& rhs) const;
+  bool operator<(const mstate_safra& rhs) const;
+  size_t hash() const;
+  void save(checkpoint_writer& out) const;
+}; // mstate_safra }}}
+
+
+/// partial macrostate of complement_rank
+struct mstate_rank
+{ // {{{
+  bool active_;
+  std::set<unsigned> states_;       // {} when !is_waiting_
+  bool is_waiting_;                 // true - waiting, false - tight
+  std::set<unsigned> breakpoint_;   // {} when !active_ || is_waiting_
+  ranking f_;                       // {} when is_waiting_
+  int i_;                           // -1 when !active_ || is_waiting_
+
+  /// constructor
+  mstate_rank(
+    const std::set<unsigned>&  states,
+    bool                       is_waiting,
+    const std::set<unsigned>&  breakpoint,
+    const ranking&             f,
+    int                        i,
+    bool                       active
+  ) : active_(active),
+    states_(states),
+    is_waiting_(is_waiting),
+    breakpoint_(breakpoint),
+    f_(f),
+    i_(i)
+  { }
+
+  std::string to_string() const;
+  bool is_active() const { return this->active_; }
+  bool operator==(const mstate_rank& rhs) const;
+  bool operator<(const mstate_rank& rhs) const;
+  size_t hash() const;
+  void save(checkpoint_writer& out) const;
+
+  bool invariants_hold() const;
+}; // mstate_rank }}}
+
+
+/// output stream conversions
+inline std::ostream& operator<<(std::ostream& os, const mstate_mh& ms)
+{ return os << ms.to_string(); }
+
+inline std::ostream& operator<<(std::ostream& os, const mstate_ncsb& ms)
+{ return os << ms.to_string(); }
+
+inline std::ostream& operator<<(std::ostream& os, const mstate_safra& ms)
+{ return os << ms.to_string(); }
+
+inline std::ostream& operator<<(std::ostream& os, const mstate_rank& ms)
+{ return os << ms.to_string(); }
+
+} // namespace kofola }}}
@@ -0,0 +1,84 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "post_image.hpp"
+
+using namespace kofola;
+
+
+post_image_table::post_image_table(
+  const spot::const_twa_graph_ptr&  aut,
+  const minterm_alphabet&           alphabet,
+  const spot::scc_info&             scc_info,
+  size_t                            max_bytes) :
+  aut_(aut),
+  alphabet_(alphabet),
+  scc_info_(scc_info),
+  num_words_((aut->num_states() + WORD_BITS - 1) / WORD_BITS)
+{ // {{{
+  const size_t num_letters = this->alphabet_.size();
+  const size_t row_words = NUM_KINDS * this->num_words_;
+  size_t max_words = MAX_TABLE_WORDS;
+  if (max_bytes > 0) { max_words = std::min(max_words, max_bytes / sizeof(word_t)); }
+  if (aut->num_states() * num_letters * row_words > max_words) {
+    return;   // the rows will be computed on demand
+  }
+
+  this->table_.assign(aut->num_states() * num_letters * row_words, 0);
+  for (unsigned s = 0; s < aut->num_states(); ++s) {
+    for (const auto& t : aut->out(s)) {
+      const unsigned edge = aut->edge_number(t);
+      const word_t dst_bit = word_t(1) << (t.dst % WORD_BITS);
+      const size_t dst_word = t.dst / WORD_BITS;
+      const bool in_scc = (scc_info.scc_of(s) == scc_info.scc_of(t.dst));
+      for (unsigned letter = 0; letter < num_letters; ++letter) {
+        if (!alphabet.edge_has_letter(edge, letter)) { continue; }
+
+        word_t* row = &this->table_[(s * num_letters + letter) * row_words];
+        row[ALL * this->num_words_ + dst_word] |= dst_bit;
+        if (in_scc) { row[IN_SCC * this->num_words_ + dst_word] |= dst_bit; }
+        if (t.acc) { row[ACC * this->num_words_ + dst_word] |= dst_bit; }
+      }
+    }
+  }
+} // post_image_table() }}}
+
+
+void post_image_table::add_row(
+  unsigned   state,
+  unsigned   letter,
+  post_kind  kind,
+  word_t*    result) const
+{ // {{{
+  if (!this->table_.empty()) { // precomputed
+    const word_t* row = &this->table_[
+      ((state * this->alphabet_.size() + letter) * NUM_KINDS + kind) * this->num_words_];
+    for (size_t i = 0; i < this->num_words_; ++i) { result[i] |= row[i]; }
+    return;
+  }
+
+  for (const auto& t : this->aut_->out(state)) {
+    if (!this->alphabet_.edge_has_letter(this->aut_->edge_number(t), letter)) {
+      continue;
+    }
+    if (IN_SCC == kind &&
+        this->scc_info_.scc_of(state) != this->scc_info_.scc_of(t.dst)) {
+      continue;
+    }
+    if (ACC == kind && !t.acc) { continue; }
+
+    result[t.dst / WORD_BITS] |= word_t(1) << (t.dst % WORD_BITS);
+  }
+} // add_row() }}}
+
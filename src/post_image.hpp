@@ -0,0 +1,116 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// precomputed successors of states over letters
+
+#pragma once
+
+#include "alphabet.hpp"
+#include "state_bitset.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <spot/twaalgos/sccinfo.hh>
+
+namespace kofola { // {{{
+
+/// Table of successors of every state over every letter of a
+/// minterm_alphabet, kept as bitsets of states.  There are several kinds of
+/// successors (see post_kind); the post-image of a set of states is then
+/// the bitwise OR of the rows of its states.  If the table would be too
+/// large (see MAX_TABLE_WORDS and the constructor), the rows are computed
+/// from the edges when needed.
+class post_image_table
+{ // {{{
+public: // TYPES
+
+  using word_t = minterm_alphabet::word_t;
+
+  /// kinds of successors of a state
+  enum post_kind
+  {
+    ALL = 0,     ///< all successors
+    IN_SCC = 1,  ///< successors in the same SCC as the state
+    ACC = 2,     ///< successors over accepting edges
+    NUM_KINDS = 3
+  };
+
+private: // CONSTANTS
+
+  static const size_t WORD_BITS = 64;
+  /// maximum size of the table (in words)
+  static const size_t MAX_TABLE_WORDS = size_t(1) << 25;
+
+private: // DATA MEMBERS
+
+  const spot::const_twa_graph_ptr aut_;
+  const minterm_alphabet& alphabet_;
+  const spot::scc_info& scc_info_;
+
+  /// number of words of a bitset of states
+  size_t num_words_;
+  /// the rows, indexed by (state, letter, kind); empty if not precomputed
+  std::vector<word_t> table_;
+
+  /// ORs the row of (state, letter, kind) into 'result'
+  void add_row(unsigned state, unsigned letter, post_kind kind, word_t* result) const;
+
+public: // METHODS
+
+  /// constructor; the table takes at most 'max_bytes' (if nonzero), so that
+  /// it fits into a memory budget
+  post_image_table(
+    const spot::const_twa_graph_ptr&  aut,
+    const minterm_alphabet&           alphabet,
+    const spot::scc_info&             scc_info,
+    size_t                            max_bytes = 0);
+
+  /// the alphabet
+  const minterm_alphabet& get_alphabet() const { return this->alphabet_; }
+
+  /// returns successors of a given kind of a set of states over a letter
+  template <class T>
+  state_bitset get_post(const T& states, unsigned letter, post_kind kind) const
+  { // {{{
+    std::vector<word_t> bits(this->num_words_, 0);
+    for (unsigned s : states) {
+      this->add_row(s, letter, kind, bits.data());
+    }
+
+    return state_bitset::from_words(std::move(bits));
+  } // get_post() }}}
+
+  /// checks whether some of the states has an accepting edge over a letter
+  /// to a state in its SCC
+  template <class T>
+  bool has_acc_post_in_scc(const T& states, unsigned letter) const
+  { // {{{
+    std::vector<word_t> acc(this->num_words_);
+    std::vector<word_t> in_scc(this->num_words_);
+    for (unsigned s : states) {
+      std::fill(acc.begin(), acc.end(), 0);
+      std::fill(in_scc.begin(), in_scc.end(), 0);
+      this->add_row(s, letter, ACC, acc.data());
+      this->add_row(s, letter, IN_SCC, in_scc.data());
+      for (size_t i = 0; i < this->num_words_; ++i) {
+        if (acc[i] & in_scc[i]) { return true; }
+      }
+    }
+
+    return false;
+  } // has_acc_post_in_scc() }}}
+}; // post_image_table }}}
+
+} // namespace kofola }}}
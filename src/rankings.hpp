@@ -4,6 +4,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <tuple>
 
 #include "kofola.hpp"
 
@@ -59,8 +60,12 @@ public:
 };
 
 
+/// returns the tight rankings of the states in 'mp' (triples of a state, the
+/// bound on its rank, and whether it is accepting, i.e., needs an even rank)
+std::vector<ranking> get_tight_rankings(
+  const std::vector<std::tuple<int, int, bool>>& mp);
+
 // bool compare_ranks(std::tuple<int, int, bool> first, std::tuple<int, int, bool> second);
-// std::vector<ranking> get_tight_rankings(std::vector<std::tuple<int, int, bool>> mp);
 // std::vector<ranking> cart_product(std::vector<ranking> rankings, std::tuple<int, int, bool> state);
 // std::vector<ranking> get_succ_rankings(std::vector<std::tuple<int, int, bool>> restr, std::set<unsigned> reachable, bdd letter);
 }
@@ -0,0 +1,98 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// reachability between states and SCCs of an automaton
+
+#pragma once
+
+#include "state_bitset.hpp"
+
+#include <cassert>
+#include <vector>
+
+#include <spot/twaalgos/sccinfo.hh>
+
+namespace kofola { // {{{
+
+/// Reachability relation of an automaton computed on its condensation (the
+/// DAG of SCCs).  Spot numbers SCCs in a reverse topological order, so the
+/// SCCs reachable from an SCC are obtained by joining the bitset rows of its
+/// successors, which are already complete.  Every SCC reaches itself.  The
+/// rows of the inverse relation (predecessors) are kept as well.  States
+/// outside SCCs (i.e., unreachable from the initial state) reach only
+/// themselves.
+class scc_reachability
+{ // {{{
+private: // DATA MEMBERS
+
+  /// SCCs of states
+  std::vector<unsigned> scc_of_;
+  /// SCCs reachable from every SCC
+  std::vector<state_bitset> succ_sccs_;
+  /// SCCs from which every SCC is reachable
+  std::vector<state_bitset> pred_sccs_;
+
+public: // METHODS
+
+  /// constructor
+  explicit scc_reachability(const spot::scc_info& si) :
+    scc_of_(si.get_aut()->num_states()),
+    succ_sccs_(si.scc_count()),
+    pred_sccs_(si.scc_count())
+  { // {{{
+    for (unsigned st = 0; st < this->scc_of_.size(); ++st) {
+      this->scc_of_[st] = si.scc_of(st);
+    }
+
+    for (unsigned scc = 0; scc < si.scc_count(); ++scc) {
+      state_bitset& row = this->succ_sccs_[scc];
+      row.insert(scc);
+      for (unsigned succ : si.succ(scc)) {
+        assert(succ < scc);     // the numbering is reverse topological
+        row |= this->succ_sccs_[succ];
+      }
+
+      for (unsigned reached : row) {
+        this->pred_sccs_[reached].insert(scc);
+      }
+    }
+  } // scc_reachability() }}}
+
+  /// checks whether 'dst_scc' is reachable from 'src_scc' ('src_scc' may
+  /// be -1U for states outside SCCs)
+  bool scc_reaches(unsigned src_scc, unsigned dst_scc) const
+  { // {{{
+    if (src_scc >= this->succ_sccs_.size()) { return false; }
+    return this->succ_sccs_[src_scc].contains(dst_scc);
+  } // scc_reaches() }}}
+
+  /// checks whether the state 'dst' is reachable from the state 'src'
+  bool reaches(unsigned src, unsigned dst) const
+  { // {{{
+    const unsigned src_scc = this->scc_of_[src];
+    const unsigned dst_scc = this->scc_of_[dst];
+    if (-1U == src_scc || -1U == dst_scc) { return src == dst; }
+    return this->scc_reaches(src_scc, dst_scc);
+  } // reaches() }}}
+
+  /// the SCCs reachable from 'scc' (including 'scc')
+  const state_bitset& succ_sccs(unsigned scc) const
+  { return this->succ_sccs_[scc]; }
+
+  /// the SCCs from which 'scc' is reachable (including 'scc')
+  const state_bitset& pred_sccs(unsigned scc) const
+  { return this->pred_sccs_[scc]; }
+}; // scc_reachability }}}
+
+} // namespace kofola }}}
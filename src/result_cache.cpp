@@ -0,0 +1,261 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "result_cache.hpp"
+#include "kofola.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spot/misc/bddlt.hh>
+#include <spot/parseaut/public.hh>
+#include <spot/twaalgos/hoa.hh>
+
+using namespace kofola;
+
+namespace { // {{{
+
+/// escapes a string so that it does not contain spaces and line breaks
+std::string escape(const std::string& str)
+{ // {{{
+  std::string result;
+  for (char c : str) {
+    if ('\\' == c || '"' == c) { result += '\\'; result += c; }
+    else if ('\n' == c) { result += "\\n"; }
+    else { result += c; }
+  }
+
+  return "\"" + result + "\"";
+} // escape() }}}
+
+/// writes labels as decision trees over atomic propositions in a fixed
+/// order (given by their ranks)
+class label_writer
+{ // {{{
+private: // DATA MEMBERS
+
+  /// ranks of BDD variables
+  const std::map<int, unsigned>& var_rank_;
+  /// the written labels (keyed by the BDDs themselves, which keeps their
+  /// nodes alive, so that an identifier is never reused for another
+  /// function, as it could be for the temporaries of the recursion)
+  std::map<bdd, std::string, spot::bdd_less_than> cache_;
+
+public: // METHODS
+
+  /// constructor
+  explicit label_writer(const std::map<int, unsigned>& var_rank) :
+    var_rank_(var_rank)
+  { }
+
+  /// writes a label; the tree branches on the variable of the support with
+  /// the lowest rank, so it is given by the function, not by the BDD
+  const std::string& write(const bdd& cond)
+  { // {{{
+    auto it = this->cache_.find(cond);
+    if (this->cache_.end() != it) { return it->second; }
+
+    std::string result;
+    if (bddtrue == cond) {
+      result = "t";
+    } else if (bddfalse == cond) {
+      result = "f";
+    } else {
+      int min_var = -1;
+      unsigned min_rank = UINT_MAX;
+      for (bdd supp = bdd_support(cond); supp != bddtrue; supp = bdd_high(supp)) {
+        const unsigned rank = this->var_rank_.at(bdd_var(supp));
+        if (rank < min_rank) {
+          min_rank = rank;
+          min_var = bdd_var(supp);
+        }
+      }
+
+      result = "(" + std::to_string(min_rank) + "?" +
+        this->write(bdd_restrict(cond, bdd_ithvar(min_var))) + ":" +
+        this->write(bdd_restrict(cond, bdd_nithvar(min_var))) + ")";
+    }
+
+    return this->cache_.emplace(cond, std::move(result)).first->second;
+  } // write() }}}
+}; // label_writer }}}
+
+/// FNV-1a hash of a string in hexadecimal
+std::string hash_to_hex(const std::string& str)
+{ // {{{
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+  return buf;
+} // hash_to_hex() }}}
+
+/// writes a file via a temporary file, so that readers never see it
+/// incomplete; returns false on failure
+bool write_file_atomically(
+  const std::string&                      path,
+  const std::function<void(std::ostream&)>&  write)
+{ // {{{
+  const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream out(tmp_path);
+    if (!out) { return false; }
+    write(out);
+    out.close();
+    if (!out) {
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+
+  return 0 == std::rename(tmp_path.c_str(), path.c_str());
+} // write_file_atomically() }}}
+
+} // anonymous namespace }}}
+
+
+result_cache::result_cache(const std::string& dir) :
+  dir_(dir)
+{ // {{{
+  if (0 != mkdir(dir.c_str(), 0777) && EEXIST != errno) {
+    throw std::runtime_error("cannot create cache directory " + dir);
+  }
+} // result_cache() }}}
+
+
+result_cache::key result_cache::make_key(
+  const spot::const_twa_graph_ptr&  aut,
+  const std::string&                options) const
+{ // {{{
+  key result;
+  result.description = options + "\n" + canonical_form(aut) + "\n";
+  result.name = hash_to_hex(result.description);
+  return result;
+} // make_key() }}}
+
+
+spot::twa_graph_ptr result_cache::lookup(
+  const key&                        k,
+  const spot::bdd_dict_ptr&         dict) const
+{ // {{{
+  std::ifstream key_file(this->get_path(k, ".key"));
+  if (!key_file) { return nullptr; }
+  std::stringstream description;
+  description << key_file.rdbuf();
+  if (description.str() != k.description) { // a collision of hashes
+    DEBUG_PRINT_LN("cache entry " + k.name + " has another key");
+    return nullptr;
+  }
+
+  spot::automaton_stream_parser parser(this->get_path(k, ".hoa"));
+  spot::parsed_aut_ptr parsed = parser.parse(dict);
+  std::ostringstream errors;
+  if (parsed->format_errors(errors) || !parsed->aut) {
+    WARN_PRINT("cache entry " << k.name << " is damaged: " << errors.str());
+    return nullptr;
+  }
+
+  return parsed->aut;
+} // lookup() }}}
+
+
+void result_cache::store(
+  const key&                        k,
+  const spot::const_twa_graph_ptr&  result) const
+{ // {{{
+  // the key goes last, so an entry is never found without its result
+  bool ok = write_file_atomically(this->get_path(k, ".hoa"),
+    [&](std::ostream& os) { spot::print_hoa(os, result) << "\n"; });
+  ok = ok && write_file_atomically(this->get_path(k, ".key"),
+    [&](std::ostream& os) { os << k.description; });
+  if (!ok) {
+    WARN_PRINT("cannot store the result into cache directory " << this->dir_);
+  }
+} // store() }}}
+
+
+std::string result_cache::canonical_form(const spot::const_twa_graph_ptr& aut)
+{ // {{{
+  std::ostringstream os;
+
+  // atomic propositions ordered by their names
+  std::vector<std::pair<std::string, int>> name_var;
+  for (const auto& ap : aut->ap()) {
+    name_var.emplace_back(ap.ap_name(), aut->get_dict()->varnum(ap));
+  }
+  std::sort(name_var.begin(), name_var.end());
+  std::map<int, unsigned> var_rank;
+  os << "AP:";
+  for (unsigned i = 0; i < name_var.size(); ++i) {
+    var_rank[name_var[i].second] = i;
+    os << " " << escape(name_var[i].first);
+  }
+  os << " Acc: " << aut->num_sets() << " " << aut->get_acceptance();
+
+  // edges of states in the breadth-first order
+  label_writer labels(var_rank);
+  std::vector<unsigned> orig_to_canon(aut->num_states(), UINT_MAX);
+  std::queue<unsigned> bfs_queue;
+  unsigned num_visited = 0;
+  auto visit = [&](unsigned state) {
+      if (UINT_MAX == orig_to_canon[state]) {
+        orig_to_canon[state] = num_visited++;
+        bfs_queue.push(state);
+      }
+    };
+
+  visit(aut->get_init_state_number());
+  while (!bfs_queue.empty()) {
+    const unsigned state = bfs_queue.front();
+    bfs_queue.pop();
+
+    // (label, colours, original target)
+    std::vector<std::tuple<std::string, std::string, unsigned>> edges;
+    for (const auto& t : aut->out(state)) {
+      std::ostringstream cols;
+      cols << t.acc;
+      edges.emplace_back(labels.write(t.cond), cols.str(), t.dst);
+    }
+    std::stable_sort(edges.begin(), edges.end(),
+      [](const auto& lhs, const auto& rhs) {
+        return std::tie(std::get<0>(lhs), std::get<1>(lhs)) <
+          std::tie(std::get<0>(rhs), std::get<1>(rhs));
+      });
+
+    os << " State: " << orig_to_canon[state];
+    for (const auto& edge : edges) {
+      visit(std::get<2>(edge));
+      os << " [" << std::get<0>(edge) << "] " << orig_to_canon[std::get<2>(edge)] <<
+        " " << std::get<1>(edge);
+    }
+  }
+
+  return os.str();
+} // canonical_form() }}}
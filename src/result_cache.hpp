@@ -0,0 +1,84 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// persistent cache of results of constructions
+
+#pragma once
+
+#include <string>
+
+#include <spot/twa/twagraph.hh>
+
+namespace kofola { // {{{
+
+/// Content-addressed cache of results in a directory, shared among runs.
+/// An entry is keyed by a canonical form of the input automaton together
+/// with a description of the options affecting the result.  It consists of
+/// two files named by the hash of the key: NAME.hoa with the result in HOA
+/// and NAME.key with the key itself, which is compared on lookup, so that a
+/// collision of hashes gives a miss instead of a wrong result.
+class result_cache
+{ // {{{
+public: // TYPES
+
+  /// key of an entry
+  struct key
+  {
+    /// the name of the files of the entry (hash of 'description')
+    std::string name;
+    /// the options and the canonical form of the input
+    std::string description;
+  };
+
+private: // DATA MEMBERS
+
+  /// the directory with the entries
+  std::string dir_;
+
+  /// path to a file of an entry
+  std::string get_path(const key& k, const std::string& suffix) const
+  { return this->dir_ + "/" + k.name + suffix; }
+
+public: // METHODS
+
+  /// constructor (creates the directory if needed)
+  explicit result_cache(const std::string& dir);
+
+  /// computes the key of the result of processing 'aut' with 'options'
+  key make_key(
+    const spot::const_twa_graph_ptr&  aut,
+    const std::string&                options) const;
+
+  /// returns the cached result (over 'dict'), or nullptr on a miss
+  spot::twa_graph_ptr lookup(
+    const key&                        k,
+    const spot::bdd_dict_ptr&         dict) const;
+
+  /// stores a result; failures to write are only reported, the cache is
+  /// not essential
+  void store(
+    const key&                        k,
+    const spot::const_twa_graph_ptr&  result) const;
+
+  /// A canonical form of the part of an automaton reachable from its
+  /// initial state.  It does not depend on the numbering of BDD variables
+  /// and the order of atomic propositions (labels are written as decision
+  /// trees over the propositions ordered by their names), nor on the
+  /// numbering of states and the order of edges (states are numbered in
+  /// the breadth-first order, where the edges of a state are ordered by
+  /// their labels and colours; ties are broken by the original order).
+  static std::string canonical_form(const spot::const_twa_graph_ptr& aut);
+}; // result_cache }}}
+
+} // namespace kofola }}}
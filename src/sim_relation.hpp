@@ -0,0 +1,118 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// simulation relations over states
+
+#pragma once
+
+#include "state_bitset.hpp"
+
+#include <cassert>
+#include <ostream>
+#include <vector>
+
+namespace kofola { // {{{
+
+/// A (simulation) relation over states 0, ..., n-1 kept as bitsets of
+/// simulators and simulatees of every state, so that queries take constant
+/// time and sets of states can be reduced by bitset operations.
+class sim_relation
+{ // {{{
+private: // DATA MEMBERS
+
+  /// simulators_[s] = states simulating s
+  std::vector<state_bitset> simulators_;
+  /// simulatees_[s] = states simulated by s
+  std::vector<state_bitset> simulatees_;
+  /// number of pairs
+  size_t size_ = 0;
+
+public: // METHODS
+
+  /// constructor (empty relation over 'num_states' states)
+  explicit sim_relation(unsigned num_states = 0) :
+    simulators_(num_states),
+    simulatees_(num_states)
+  { }
+
+  /// number of states
+  unsigned num_states() const { return this->simulators_.size(); }
+
+  /// number of pairs in the relation
+  size_t size() const { return this->size_; }
+
+  /// adds the pair (bigger simulates smaller)
+  void add(unsigned smaller, unsigned bigger)
+  { // {{{
+    assert(smaller < this->num_states() && bigger < this->num_states());
+    if (this->simulators_[smaller].contains(bigger)) { return; }
+    this->simulators_[smaller].insert(bigger);
+    this->simulatees_[bigger].insert(smaller);
+    ++this->size_;
+  } // add() }}}
+
+  /// checks whether 'bigger' simulates 'smaller'
+  bool simulates(unsigned bigger, unsigned smaller) const
+  { // {{{
+    return smaller < this->num_states() &&
+      this->simulators_[smaller].contains(bigger);
+  } // simulates() }}}
+
+  /// states simulating 's'
+  const state_bitset& get_simulators(unsigned s) const
+  { // {{{
+    assert(s < this->num_states());
+    return this->simulators_[s];
+  } // get_simulators() }}}
+
+  /// states simulated by 's'
+  const state_bitset& get_simulatees(unsigned s) const
+  { // {{{
+    assert(s < this->num_states());
+    return this->simulatees_[s];
+  } // get_simulatees() }}}
+
+  /// removes from 'states' all states simulated by some other state of
+  /// 'states' (every state is compared against the original set, so the
+  /// relation should not contain cycles other than the identity)
+  state_bitset remove_dominated(const state_bitset& states) const
+  { // {{{
+    state_bitset dominated;
+    for (unsigned s : states) {
+      if (s >= this->num_states()) { continue; }
+      state_bitset smaller = this->simulatees_[s] & states;
+      smaller.erase(s);
+      dominated |= smaller;
+    }
+
+    return states - dominated;
+  } // remove_dominated() }}}
+
+  /// output stream conversion (list of pairs (smaller, bigger))
+  friend std::ostream& operator<<(std::ostream& os, const sim_relation& rel)
+  { // {{{
+    os << "{";
+    bool first = true;
+    for (unsigned smaller = 0; smaller < rel.num_states(); ++smaller) {
+      for (unsigned bigger : rel.simulators_[smaller]) {
+        if (!first) { os << ", "; }
+        first = false;
+        os << "(" << smaller << ", " << bigger << ")";
+      }
+    }
+    return os << "}";
+  } // operator<<() }}}
+}; // sim_relation }}}
+
+} // namespace kofola }}}
@@ -29,32 +29,21 @@ namespace cola
             return ;
         }
         unsigned n_states = nba->num_states();
-        for (unsigned i = 0; i < n_states; i++)
-        {
-            compact_.push_back(bddfalse);
-            support_.push_back(bddfalse);
-        }
+        alphabet_ = std::make_unique<kofola::minterm_alphabet>(nba_);
 
         std::set<unsigned> states_has_incoming_acc;
-        // compute the latters and support
+        // compute the letters
         for (int p = 0; p < n_states; p++)
         {
-            bdd c_compact = bddfalse;
-            bdd c_support = bddtrue;
-
             for (auto &e : nba_->out(p))
             {
-                bdd cond = e.cond;
-                c_compact |= cond;
-                c_support &= bdd_support(cond);
                 if (e.acc)
                 {
                     states_has_incoming_acc.insert(e.dst);
                 }
             }
 
-            compact_[p] = c_compact;
-            support_[p] = c_support;
+            letters_.push_back(alphabet_->get_enabled_letters(std::vector<unsigned>{(unsigned)p}));
             std::pair<unsigned, bool> s = std::make_pair(p, false);
             states_.push_back(s);
             s2index_[s] = p;
@@ -90,11 +79,14 @@ namespace cola
                 win_region_[p][q] = false;
                 unsigned p_repr = states_[p].first;
                 unsigned q_repr = states_[q].first;
-                bdd act = compact_[p_repr] & !compact_[q_repr];
-                // p can do action \a act, but q cannot
-                if (act != bddfalse)
+                // p can do some action, but q cannot
+                for (unsigned letter : letters_[p_repr])
                 {
-                    win_region_[p][q] = true;
+                    if (!alphabet_->state_has_letter(q_repr, letter))
+                    {
+                        win_region_[p][q] = true;
+                        break;
+                    }
                 }
             }
 
@@ -258,23 +250,19 @@ namespace cola
         p = states_[p].first;
         q = states_[q].first;
 
-        bdd all = compact_[p];
-        bdd supp = support_[p] & support_[q];
-        while (all != bddfalse)
+        for (unsigned letter : letters_[p])
         {
-            bdd letter = bdd_satoneset(all, supp, bddfalse);
-            all -= letter;
             // for the letter from p
             for (auto &e1 : nba_->out(p))
             {
-                if (!bdd_implies(letter, e1.cond))
+                if (!alphabet_->edge_has_letter(nba_->edge_number(e1), letter))
                 {
                     continue;
                 }
                 trapped = true;
                 for (auto &e2 : nba_->out(q))
                 {
-                    if (!bdd_implies(letter, e2.cond))
+                    if (!alphabet_->edge_has_letter(nba_->edge_number(e2), letter))
                         continue;
                     // p has a and q has a transition
                     // there exists a successor p' of p that is simulated by q'
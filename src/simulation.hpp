@@ -49,8 +49,9 @@ namespace cola
         std::unordered_map<std::pair<unsigned, bool>, unsigned, pair_hash> s2index_;
 
         pair_vec states_;
-        bdd_vec compact_;
-        bdd_vec support_;
+        // the alphabet split into letters and the letters enabled in states
+        std::unique_ptr<kofola::minterm_alphabet> alphabet_;
+        std::vector<std::vector<unsigned>> letters_;
 
         // number of states of the form (q, b)
         // b = 1 or 0 if q has accepting incoming transitions
@@ -0,0 +1,382 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// sets of states represented as dense bitsets
+
+#pragma once
+
+#include "hash_index.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace kofola { // {{{
+
+/// kernels working on arrays of 64-bit words (vectorised where the target
+/// supports it, with a scalar fallback)
+namespace bitset_kernels { // {{{
+
+using word_t = uint64_t;
+
+/// dst = a | b
+inline void or_words(word_t* dst, const word_t* a, const word_t* b, size_t n)
+{ // {{{
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(x, y));
+  }
+#elif defined(__SSE2__)
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(x, y));
+  }
+#endif
+  for (; i < n; ++i) { dst[i] = a[i] | b[i]; }
+} // or_words() }}}
+
+/// dst = a & b
+inline void and_words(word_t* dst, const word_t* a, const word_t* b, size_t n)
+{ // {{{
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_and_si256(x, y));
+  }
+#elif defined(__SSE2__)
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_and_si128(x, y));
+  }
+#endif
+  for (; i < n; ++i) { dst[i] = a[i] & b[i]; }
+} // and_words() }}}
+
+/// dst = a & ~b
+inline void andnot_words(word_t* dst, const word_t* a, const word_t* b, size_t n)
+{ // {{{
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_andnot_si256(y, x));
+  }
+#elif defined(__SSE2__)
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_andnot_si128(y, x));
+  }
+#endif
+  for (; i < n; ++i) { dst[i] = a[i] & ~b[i]; }
+} // andnot_words() }}}
+
+/// checks whether a & ~b == 0
+inline bool is_subset_words(const word_t* a, const word_t* b, size_t n)
+{ // {{{
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    if (!_mm256_testz_si256(_mm256_andnot_si256(y, x), _mm256_set1_epi64x(-1))) {
+      return false;
+    }
+  }
+#elif defined(__SSE2__)
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    __m128i diff = _mm_andnot_si128(y, x);
+    if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128()))) {
+      return false;
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (a[i] & ~b[i]) { return false; }
+  }
+
+  return true;
+} // is_subset_words() }}}
+
+} // namespace bitset_kernels }}}
+
+
+/// A set of states represented as a bitset.  The representation is kept
+/// canonical (there are no trailing zero words), so that equal sets have
+/// equal representations.  The interface mimics std::set<unsigned> and the
+/// ordering is the same as the (lexicographic) ordering of std::set.
+class state_bitset
+{ // {{{
+public: // TYPES
+
+  using word_t = bitset_kernels::word_t;
+  using value_type = unsigned;
+
+  /// iterator over the states in ascending order
+  class const_iterator
+  { // {{{
+  private: // DATA MEMBERS
+
+    const std::vector<word_t>* words_;
+    size_t index_;      // current word
+    word_t rest_;       // bits of the current word not yet visited
+
+    void skip_empty()
+    { // {{{
+      while (0 == this->rest_ && ++this->index_ < this->words_->size()) {
+        this->rest_ = (*this->words_)[this->index_];
+      }
+    } // skip_empty() }}}
+
+  public: // METHODS
+
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = unsigned;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const unsigned*;
+    using reference = unsigned;
+
+    const_iterator(const std::vector<word_t>* words, size_t index) :
+      words_(words), index_(index),
+      rest_((index < words->size())? (*words)[index] : 0)
+    { // {{{
+      if (this->index_ < this->words_->size()) { this->skip_empty(); }
+    } // const_iterator() }}}
+
+    unsigned operator*() const
+    { return this->index_ * 64 + __builtin_ctzll(this->rest_); }
+
+    const_iterator& operator++()
+    { // {{{
+      this->rest_ &= this->rest_ - 1;
+      this->skip_empty();
+      return *this;
+    } // operator++ }}}
+
+    const_iterator operator++(int)
+    { // {{{
+      const_iterator tmp = *this;
+      ++*this;
+      return tmp;
+    } // operator++(int) }}}
+
+    bool operator==(const const_iterator& rhs) const
+    { return this->index_ == rhs.index_ && this->rest_ == rhs.rest_; }
+
+    bool operator!=(const const_iterator& rhs) const
+    { return !(*this == rhs); }
+  }; // const_iterator }}}
+
+  using iterator = const_iterator;
+
+private: // CONSTANTS
+
+  static const size_t WORD_BITS = 64;
+
+private: // DATA MEMBERS
+
+  std::vector<word_t> words_;
+
+  /// removes trailing zero words
+  void trim()
+  { // {{{
+    while (!this->words_.empty() && 0 == this->words_.back()) {
+      this->words_.pop_back();
+    }
+  } // trim() }}}
+
+public: // METHODS
+
+  /// constructors
+  state_bitset() { }
+
+  state_bitset(std::initializer_list<unsigned> states)
+  { for (unsigned s : states) { this->insert(s); } }
+
+  template <class InputIt>
+  state_bitset(InputIt first, InputIt last)
+  { for (; first != last; ++first) { this->insert(*first); } }
+
+  /// creates a set from its words (bit i of word j represents state
+  /// 64 * j + i)
+  static state_bitset from_words(std::vector<word_t> words)
+  { // {{{
+    state_bitset result;
+    result.words_ = std::move(words);
+    result.trim();
+    return result;
+  } // from_words() }}}
+
+  /// the words of the bitset
+  const std::vector<word_t>& words() const { return this->words_; }
+
+  const_iterator begin() const { return const_iterator(&this->words_, 0); }
+  const_iterator end() const { return const_iterator(&this->words_, this->words_.size()); }
+
+  bool empty() const { return this->words_.empty(); }
+
+  /// number of states
+  size_t size() const
+  { // {{{
+    size_t result = 0;
+    for (word_t w : this->words_) { result += __builtin_popcountll(w); }
+    return result;
+  } // size() }}}
+
+  bool contains(unsigned state) const
+  { // {{{
+    const size_t index = state / WORD_BITS;
+    return index < this->words_.size() &&
+      ((this->words_[index] >> (state % WORD_BITS)) & 1);
+  } // contains() }}}
+
+  void insert(unsigned state)
+  { // {{{
+    const size_t index = state / WORD_BITS;
+    if (index >= this->words_.size()) { this->words_.resize(index + 1, 0); }
+    this->words_[index] |= word_t(1) << (state % WORD_BITS);
+  } // insert() }}}
+
+  void erase(unsigned state)
+  { // {{{
+    const size_t index = state / WORD_BITS;
+    if (index >= this->words_.size()) { return; }
+    this->words_[index] &= ~(word_t(1) << (state % WORD_BITS));
+    this->trim();
+  } // erase() }}}
+
+  void clear() { this->words_.clear(); }
+
+  /// union
+  state_bitset operator|(const state_bitset& rhs) const
+  { // {{{
+    const state_bitset& longer = (this->words_.size() >= rhs.words_.size())? *this : rhs;
+    const state_bitset& shorter = (&longer == this)? rhs : *this;
+    state_bitset result = longer;
+    bitset_kernels::or_words(result.words_.data(), longer.words_.data(),
+      shorter.words_.data(), shorter.words_.size());
+    return result;
+  } // operator| }}}
+
+  /// intersection
+  state_bitset operator&(const state_bitset& rhs) const
+  { // {{{
+    std::vector<word_t> words(std::min(this->words_.size(), rhs.words_.size()));
+    bitset_kernels::and_words(words.data(), this->words_.data(),
+      rhs.words_.data(), words.size());
+    return from_words(std::move(words));
+  } // operator& }}}
+
+  /// difference
+  state_bitset operator-(const state_bitset& rhs) const
+  { // {{{
+    state_bitset result = *this;
+    const size_t n = std::min(this->words_.size(), rhs.words_.size());
+    bitset_kernels::andnot_words(result.words_.data(), this->words_.data(),
+      rhs.words_.data(), n);
+    result.trim();
+    return result;
+  } // operator- }}}
+
+  state_bitset& operator|=(const state_bitset& rhs) { return *this = *this | rhs; }
+  state_bitset& operator&=(const state_bitset& rhs) { return *this = *this & rhs; }
+  state_bitset& operator-=(const state_bitset& rhs) { return *this = *this - rhs; }
+
+  /// checks whether the set is a subset of 'rhs'
+  bool is_subset_of(const state_bitset& rhs) const
+  { // {{{
+    if (this->words_.size() > rhs.words_.size()) { return false; }
+    return bitset_kernels::is_subset_words(this->words_.data(),
+      rhs.words_.data(), this->words_.size());
+  } // is_subset_of() }}}
+
+  /// checks whether the sets have a common state
+  bool intersects(const state_bitset& rhs) const
+  { // {{{
+    const size_t n = std::min(this->words_.size(), rhs.words_.size());
+    for (size_t i = 0; i < n; ++i) {
+      if (this->words_[i] & rhs.words_[i]) { return true; }
+    }
+    return false;
+  } // intersects() }}}
+
+  bool operator==(const state_bitset& rhs) const { return this->words_ == rhs.words_; }
+  bool operator!=(const state_bitset& rhs) const { return this->words_ != rhs.words_; }
+
+  /// lexicographic ordering of the ascending sequences of states (the same
+  /// as for std::set)
+  bool operator<(const state_bitset& rhs) const
+  { // {{{
+    const size_t n = std::min(this->words_.size(), rhs.words_.size());
+    size_t i = 0;
+    while (i < n && this->words_[i] == rhs.words_[i]) { ++i; }
+    if (i == n) { // one is a prefix of the other
+      return this->words_.size() < rhs.words_.size();
+    }
+
+    // the smallest state in only one of the sets decides: the set with it is
+    // smaller iff the other set has some bigger state
+    const word_t diff = this->words_[i] ^ rhs.words_[i];
+    const word_t lowest = diff & (~diff + 1);
+    const bool in_this = (this->words_[i] & lowest);
+    const state_bitset& other = in_this? rhs : *this;
+    const bool other_has_bigger =
+      (other.words_[i] & ~(lowest | (lowest - 1))) || other.words_.size() > i + 1;
+    return in_this == other_has_bigger;
+  } // operator< }}}
+
+  /// hash value
+  size_t hash() const
+  { return hash_range(this->words_.begin(), this->words_.end()); }
+}; // state_bitset }}}
+
+/// output stream conversion
+inline std::ostream& operator<<(std::ostream& os, const state_bitset& st)
+{ // {{{
+  os << "{";
+  bool first = true;
+  for (unsigned s : st) {
+    if (!first) { os << ", "; }
+    first = false;
+    os << s;
+  }
+  return os << "}";
+} // operator<<() }}}
+
+/// hash functor for state_bitset
+struct state_bitset_hash
+{
+  size_t operator()(const state_bitset& st) const { return st.hash(); }
+};
+
+} // namespace kofola }}}
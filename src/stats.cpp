@@ -0,0 +1,172 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "stats.hpp"
+#include "kofola.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+using namespace kofola;
+
+kofola::run_stats kofola::STATS;
+
+namespace { // {{{
+
+/// writes a JSON string literal
+void print_json_string(std::ostream& os, const std::string& str)
+{ // {{{
+  os << '"';
+  for (char c : str) {
+    if ('"' == c || '\\' == c) { os << '\\' << c; }
+    else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+      os << buf;
+    } else { os << c; }
+  }
+  os << '"';
+} // print_json_string() }}}
+
+} // anonymous namespace }}}
+
+
+void run_stats::add_phase(const std::string& name, double wall_ms, double cpu_ms)
+{ // {{{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto it = std::find_if(this->phases_.begin(), this->phases_.end(),
+    [&name](const phase& ph) { return ph.name == name; });
+  if (this->phases_.end() == it) {
+    this->phases_.push_back({name, wall_ms, cpu_ms});
+  } else {
+    it->wall_ms += wall_ms;
+    it->cpu_ms += cpu_ms;
+  }
+} // add_phase() }}}
+
+
+void run_stats::add(const std::string& counter, uint64_t val)
+{ // {{{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto it = std::find_if(this->counters_.begin(), this->counters_.end(),
+    [&counter](const auto& cnt) { return cnt.name == counter; });
+  if (this->counters_.end() == it) {
+    this->counters_.push_back({counter, val, false});
+  } else {
+    it->val += val;
+  }
+} // add() }}}
+
+
+void run_stats::set_max(const std::string& counter, uint64_t val)
+{ // {{{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  auto it = std::find_if(this->counters_.begin(), this->counters_.end(),
+    [&counter](const auto& cnt) { return cnt.name == counter; });
+  if (this->counters_.end() == it) {
+    this->counters_.push_back({counter, val, true});
+  } else {
+    it->val = std::max(it->val, val);
+  }
+} // set_max() }}}
+
+
+void run_stats::clear()
+{ // {{{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->phases_.clear();
+  this->counters_.clear();
+} // clear() }}}
+
+
+void run_stats::save(std::ostream& os) const
+{ // {{{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  // names go last as they may contain spaces
+  os << std::setprecision(std::numeric_limits<double>::max_digits10);
+  for (const phase& ph : this->phases_) {
+    os << "phase " << ph.wall_ms << " " << ph.cpu_ms << " " << ph.name << "\n";
+  }
+  for (const counter& cnt : this->counters_) {
+    os << (cnt.is_max? "max " : "add ") << cnt.val << " " << cnt.name << "\n";
+  }
+} // save() }}}
+
+
+bool run_stats::merge(std::istream& is)
+{ // {{{
+  std::string line;
+  while (std::getline(is, line)) {
+    std::istringstream iss(line);
+    std::string kind;
+    iss >> kind;
+    if ("phase" == kind) {
+      double wall_ms = 0, cpu_ms = 0;
+      std::string name;
+      if (!(iss >> wall_ms >> cpu_ms) || !std::getline(iss >> std::ws, name)) {
+        return false;
+      }
+      this->add_phase(name, wall_ms, cpu_ms);
+    } else if ("add" == kind || "max" == kind) {
+      uint64_t val = 0;
+      std::string name;
+      if (!(iss >> val) || !std::getline(iss >> std::ws, name)) {
+        return false;
+      }
+      if ("add" == kind) { this->add(name, val); }
+      else { this->set_max(name, val); }
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+} // merge() }}}
+
+
+void run_stats::print_json(std::ostream& os, const std::string& input, unsigned index) const
+{ // {{{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  os << "{\"input\":";
+  print_json_string(os, input);
+  os << ",\"index\":" << index << ",\"phases\":{";
+  for (size_t i = 0; i < this->phases_.size(); ++i) {
+    if (i > 0) { os << ","; }
+    print_json_string(os, this->phases_[i].name);
+    os << ":{\"wall_ms\":" << this->phases_[i].wall_ms <<
+      ",\"cpu_ms\":" << this->phases_[i].cpu_ms << "}";
+  }
+  os << "},\"counters\":{";
+  for (size_t i = 0; i < this->counters_.size(); ++i) {
+    if (i > 0) { os << ","; }
+    print_json_string(os, this->counters_[i].name);
+    os << ":" << this->counters_[i].val;
+  }
+  os << "},\"peak_rss_mib\":" << get_peak_memory_mib() << "}\n";
+} // print_json() }}}
+
+
+void phase_timer::stop()
+{ // {{{
+  if (!this->running_) { return; }
+  this->running_ = false;
+
+  const std::chrono::duration<double, std::milli> wall =
+    std::chrono::steady_clock::now() - this->wall_start_;
+  const double cpu = 1000.0 * (std::clock() - this->cpu_start_) / CLOCKS_PER_SEC;
+  STATS.add_phase(this->name_, wall.count(), cpu);
+} // stop() }}}
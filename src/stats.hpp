@@ -0,0 +1,123 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// statistics of runs (times of phases and counters)
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace kofola { // {{{
+
+/// Statistics of processing one automaton: wall-clock and CPU times of
+/// phases and named counters, both kept in the order of their first use.
+/// Repeated phases and counters are summed up.  The statistics are
+/// collected always (the cost is negligible) and printed on request.
+/// Statistics of a child process (see run_forked() in complement_tnba.cpp)
+/// are passed to the parent using save() and merge(); times of phases
+/// running in parallel children are summed up, too.
+class run_stats
+{ // {{{
+private: // TYPES
+
+  /// times of a phase
+  struct phase
+  {
+    std::string name;
+    double wall_ms;
+    double cpu_ms;
+  };
+
+  /// a counter
+  struct counter
+  {
+    std::string name;
+    uint64_t val;
+    bool is_max;     // set by set_max() rather than add()
+  };
+
+private: // DATA MEMBERS
+
+  std::vector<phase> phases_;
+  std::vector<counter> counters_;
+  mutable std::mutex mutex_;
+
+public: // METHODS
+
+  /// adds time spent in a phase
+  void add_phase(const std::string& name, double wall_ms, double cpu_ms);
+
+  /// adds to a counter
+  void add(const std::string& counter, uint64_t val);
+
+  /// raises a counter to 'val' (for maxima)
+  void set_max(const std::string& counter, uint64_t val);
+
+  /// drops everything (before the next automaton)
+  void clear();
+
+  /// writes the statistics in a line-based format read by merge()
+  void save(std::ostream& os) const;
+
+  /// adds statistics written by save() to these (using add_phase(), add(),
+  /// and set_max()); returns false if 'is' is malformed
+  bool merge(std::istream& is);
+
+  /// prints the statistics as one JSON object on one line; 'input' and
+  /// 'index' identify the automaton
+  void print_json(std::ostream& os, const std::string& input, unsigned index) const;
+}; // run_stats }}}
+
+
+/// statistics of the automaton being processed
+extern run_stats STATS;
+
+
+/// Measures a phase from its construction to stop() or destruction and adds
+/// it to STATS.
+class phase_timer
+{ // {{{
+private: // DATA MEMBERS
+
+  std::string name_;
+  std::chrono::steady_clock::time_point wall_start_;
+  std::clock_t cpu_start_;
+  bool running_ = true;
+
+public: // METHODS
+
+  /// starts measuring the phase 'name'
+  explicit phase_timer(const std::string& name) :
+    name_(name),
+    wall_start_(std::chrono::steady_clock::now()),
+    cpu_start_(std::clock())
+  { }
+
+  phase_timer(const phase_timer&) = delete;
+  phase_timer& operator=(const phase_timer&) = delete;
+
+  /// stops measuring (only the first call counts)
+  void stop();
+
+  ~phase_timer() { this->stop(); }
+}; // phase_timer }}}
+
+} // namespace kofola }}}
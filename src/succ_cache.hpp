@@ -0,0 +1,147 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// cache of successors of partial macrostates
+
+#pragma once
+
+#include "abstract_complement_alg.hpp"
+#include "state_bitset.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace kofola { // {{{
+
+/// Bounded thread-safe cache of successors of partial macrostates of one
+/// partition.  The successors are given by the number of the partial
+/// macrostate, the letter, whether the macrostate is treated as active, and
+/// the set of reached states restricted by
+/// abstract_complement_alg::restrict_reached().  The successors are kept as
+/// numbers of partial macrostates (in the table of the partition), so a hit
+/// copies no partial macrostates.  The cache is split into shards with their
+/// own locks; a full shard is emptied.
+class succ_cache
+{ // {{{
+public: // TYPES
+
+  /// the key
+  struct key
+  { // {{{
+    unsigned ms_id;
+    unsigned symbol;
+    bool active;
+    state_bitset reached;
+
+    bool operator==(const key& rhs) const
+    { // {{{
+      return this->ms_id == rhs.ms_id && this->symbol == rhs.symbol &&
+        this->active == rhs.active && this->reached == rhs.reached;
+    } // operator== }}}
+
+    size_t hash() const
+    { // {{{
+      size_t res = hash_combine(this->reached.hash(), this->ms_id);
+      res = hash_combine(res, this->symbol);
+      return hash_combine(res, this->active);
+    } // hash() }}}
+  }; // key }}}
+
+  /// numbers of the successors with sets of colours on the edges
+  using value = std::vector<std::pair<unsigned, std::set<unsigned>>>;
+
+private: // TYPES
+
+  struct key_hash
+  {
+    size_t operator()(const key& k) const { return k.hash(); }
+  };
+
+  struct shard
+  {
+    std::mutex mtx;
+    std::unordered_map<key, value, key_hash> map;
+  };
+
+public: // CONSTANTS
+
+  /// default maximum number of entries
+  static const size_t DEFAULT_MAX_ENTRIES = size_t(1) << 16;
+
+private: // CONSTANTS
+
+  static const size_t NUM_SHARDS = 16;
+
+private: // DATA MEMBERS
+
+  std::vector<std::unique_ptr<shard>> shards_;
+  /// maximum number of entries of a shard
+  size_t max_shard_entries_;
+
+  std::atomic<size_t> hits_{0};
+  std::atomic<size_t> misses_{0};
+
+  shard& get_shard(const key& k)
+  { return *this->shards_[k.hash() % NUM_SHARDS]; }
+
+public: // METHODS
+
+  /// constructor
+  explicit succ_cache(size_t max_entries = DEFAULT_MAX_ENTRIES) :
+    max_shard_entries_(std::max<size_t>(1, max_entries / NUM_SHARDS))
+  { // {{{
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+      this->shards_.emplace_back(new shard());
+    }
+  } // succ_cache() }}}
+
+  /// looks up the successors for 'k'; returns false if they are not cached
+  bool find(const key& k, value& result)
+  { // {{{
+    shard& sh = this->get_shard(k);
+    std::lock_guard<std::mutex> lock(sh.mtx);
+    auto it = sh.map.find(k);
+    if (sh.map.end() == it) {
+      ++this->misses_;
+      return false;
+    }
+
+    ++this->hits_;
+    result = it->second;
+    return true;
+  } // find() }}}
+
+  /// stores the successors for 'k'
+  void insert(key k, const value& val)
+  { // {{{
+    shard& sh = this->get_shard(k);
+    std::lock_guard<std::mutex> lock(sh.mtx);
+    if (sh.map.size() >= this->max_shard_entries_) { sh.map.clear(); }
+    sh.map.emplace(std::move(k), val);
+  } // insert() }}}
+
+  /// number of successful lookups
+  size_t hits() const { return this->hits_; }
+
+  /// number of unsuccessful lookups
+  size_t misses() const { return this->misses_; }
+}; // succ_cache }}}
+
+} // namespace kofola }}}
@@ -0,0 +1,235 @@
+// Copyright (C) 2022  The COLA Authors
+// COLA is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// COLA is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// pool of worker threads with work-stealing deques
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kofola { // {{{
+
+/// A pool of worker threads processing tasks (numbers) from work-stealing
+/// deques.  Every worker takes tasks from its own deque in the order given
+/// by task_order (by default from the back, so it proceeds depth-first) and
+/// when it runs out of work, it steals from the deques of other workers
+/// (the oldest task, or the one with the best priority).  Processing a task
+/// may push new tasks.  The thread calling run() acts as worker 0, so a pool
+/// with a single worker does not start any thread.  The workers can be
+/// stopped by request_stop(); the tasks not yet processed are then left in
+/// the deques, where they can be collected by drain().
+class work_stealing_pool
+{ // {{{
+public: // TYPES
+
+  /// order in which a worker takes its own tasks
+  enum class task_order
+  {
+    LIFO,       ///< the newest task first (depth-first)
+    FIFO,       ///< the oldest task first (breadth-first)
+    PRIORITY    ///< the task with the lowest priority value first
+  };
+
+private: // TYPES
+
+  /// a task with its priority (only used with task_order::PRIORITY)
+  using prio_task = std::pair<size_t, unsigned>;
+
+  struct worker_deque
+  {
+    std::deque<unsigned> tasks;
+    /// binary heap (with the lowest priority value on top)
+    std::vector<prio_task> heap;
+    std::mutex mtx;
+  };
+
+private: // DATA MEMBERS
+
+  /// deques of the workers
+  std::vector<std::unique_ptr<worker_deque>> deques_;
+  /// the order of taking tasks
+  task_order order_;
+  /// number of tasks pushed and not yet processed
+  std::atomic<size_t> pending_{0};
+  /// the maximum value of 'pending_'
+  std::atomic<size_t> peak_pending_{0};
+  /// set when processing of some task failed
+  std::atomic<bool> abort_{false};
+  /// set when the workers are asked to stop
+  std::atomic<bool> stop_{false};
+  /// the first exception thrown by processing of a task
+  std::exception_ptr error_;
+  std::mutex error_mtx_;
+
+  /// takes a task from a deque (the lock needs to be held); 'own' says
+  /// whether the deque belongs to the worker
+  bool take(worker_deque& dq, bool own, unsigned& task)
+  { // {{{
+    if (task_order::PRIORITY == this->order_) {
+      if (dq.heap.empty()) { return false; }
+      std::pop_heap(dq.heap.begin(), dq.heap.end(), std::greater<prio_task>());
+      task = dq.heap.back().second;
+      dq.heap.pop_back();
+      return true;
+    }
+
+    if (dq.tasks.empty()) { return false; }
+    if (own && task_order::LIFO == this->order_) {
+      task = dq.tasks.back();
+      dq.tasks.pop_back();
+    } else {
+      task = dq.tasks.front();
+      dq.tasks.pop_front();
+    }
+    return true;
+  } // take() }}}
+
+  /// takes a task from the worker's own deque
+  bool pop(size_t worker, unsigned& task)
+  { // {{{
+    worker_deque& dq = *this->deques_[worker];
+    std::lock_guard<std::mutex> lock(dq.mtx);
+    return this->take(dq, true, task);
+  } // pop() }}}
+
+  /// steals a task from a deque of another worker
+  bool steal(size_t worker, unsigned& task)
+  { // {{{
+    const size_t num_workers = this->deques_.size();
+    for (size_t i = 1; i < num_workers; ++i) {
+      worker_deque& dq = *this->deques_[(worker + i) % num_workers];
+      std::lock_guard<std::mutex> lock(dq.mtx);
+      if (this->take(dq, false, task)) { return true; }
+    }
+
+    return false;
+  } // steal() }}}
+
+  /// the loop of a worker
+  template <class F>
+  void work(size_t worker, F& process)
+  { // {{{
+    while (!this->abort_ && !this->stop_) {
+      unsigned task;
+      if (this->pop(worker, task) || this->steal(worker, task)) {
+        try {
+          process(worker, task);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(this->error_mtx_);
+          if (!this->error_) { this->error_ = std::current_exception(); }
+          this->abort_ = true;
+        }
+        --this->pending_;
+      } else if (0 == this->pending_) { // no task anywhere
+        break;
+      } else { // some other worker is still processing
+        std::this_thread::yield();
+      }
+    }
+  } // work() }}}
+
+public: // METHODS
+
+  /// constructor
+  explicit work_stealing_pool(
+    size_t      num_workers,
+    task_order  order = task_order::LIFO
+  ) : order_(order)
+  { // {{{
+    assert(num_workers > 0);
+    for (size_t i = 0; i < num_workers; ++i) {
+      this->deques_.emplace_back(new worker_deque());
+    }
+  } // work_stealing_pool() }}}
+
+  /// number of workers
+  size_t num_workers() const { return this->deques_.size(); }
+
+  /// number of tasks pushed and not yet processed (including the ones
+  /// being processed)
+  size_t num_pending() const { return this->pending_; }
+
+  /// the maximum number of pending tasks so far
+  size_t peak_pending() const { return this->peak_pending_; }
+
+  /// pushes a task into the deque of a worker ('priority' is used only with
+  /// task_order::PRIORITY)
+  void push(size_t worker, unsigned task, size_t priority = 0)
+  { // {{{
+    const size_t pending = ++this->pending_;
+    size_t peak = this->peak_pending_;
+    while (pending > peak && !this->peak_pending_.compare_exchange_weak(peak, pending)) { }
+
+    worker_deque& dq = *this->deques_[worker];
+    std::lock_guard<std::mutex> lock(dq.mtx);
+    if (task_order::PRIORITY == this->order_) {
+      dq.heap.emplace_back(priority, task);
+      std::push_heap(dq.heap.begin(), dq.heap.end(), std::greater<prio_task>());
+    } else {
+      dq.tasks.push_back(task);
+    }
+  } // push() }}}
+
+  /// asks the workers to stop after processing their current tasks (can be
+  /// called from process())
+  void request_stop() { this->stop_ = true; }
+
+  /// says whether the last run() was stopped by request_stop()
+  bool is_stopped() const { return this->stop_; }
+
+  /// removes all tasks not processed yet and returns them (oldest first in
+  /// every deque); the pool can then be run again
+  std::vector<unsigned> drain()
+  { // {{{
+    std::vector<unsigned> result;
+    for (auto& dq : this->deques_) {
+      std::lock_guard<std::mutex> lock(dq->mtx);
+      result.insert(result.end(), dq->tasks.begin(), dq->tasks.end());
+      dq->tasks.clear();
+      for (const auto& prio_task : dq->heap) { result.push_back(prio_task.second); }
+      dq->heap.clear();
+    }
+
+    this->pending_ = 0;
+    this->stop_ = false;
+    return result;
+  } // drain() }}}
+
+  /// calls process(worker, task) for all tasks until no task is left (or
+  /// until request_stop() is called); if some call throws, the workers stop
+  /// and the exception is rethrown
+  template <class F>
+  void run(F&& process)
+  { // {{{
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < this->deques_.size(); ++i) {
+      threads.emplace_back([this, i, &process]{ this->work(i, process); });
+    }
+    this->work(0, process);
+    for (auto& th : threads) { th.join(); }
+
+    if (this->error_) { std::rethrow_exception(this->error_); }
+  } // run() }}}
+}; // work_stealing_pool }}}
+
+} // namespace kofola }}}